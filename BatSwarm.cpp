@@ -0,0 +1,358 @@
+#include "BatSwarm.h"
+#include <cassert>
+#include "World.h"
+#include "Player.h"
+#include "Collision.h"
+#include "SIMD.h"
+#include "JobSystem.h"
+
+extern JobSystem g_job_system;
+
+void BatSwarm::init(const Player& player, const World& world)
+{
+	clear();
+	grid.init(GRID_CELL_SIZE);
+	this->player = &player;
+	this->world = &world;
+}
+
+void BatSwarm::clear()
+{
+	count = 0;
+	resizeArrays(0);
+	lod.resize(0);
+	grid.clear();
+}
+
+void BatSwarm::add(const Vec3f& position)
+{
+	const unsigned i = count;
+	count++;
+	if (count > state.size())
+		resizeArrays((count + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH);
+	lod.resize(count);
+
+	const Vec3f velocity = Vec3f(Vector3::getRandomUnitVectorXZ()) * S_MAX;
+	const Vec3f forward = velocity.getNormalized();
+	Vec3f target = world->getRandomXZPosition();
+	target.y = TARGET_HEIGHT;
+
+	position_x[i] = position.x;
+	position_y[i] = position.y;
+	position_z[i] = position.z;
+	previous_x[i] = position.x;
+	previous_y[i] = position.y;
+	previous_z[i] = position.z;
+	velocity_x[i] = velocity.x;
+	velocity_y[i] = velocity.y;
+	velocity_z[i] = velocity.z;
+	forward_x[i] = forward.x;
+	forward_y[i] = forward.y;
+	forward_z[i] = forward.z;
+	target_x[i] = target.x;
+	target_y[i] = target.y;
+	target_z[i] = target.z;
+	ignore_timer[i] = 0;
+	state[i] = Bat_State::EXPLORE;
+	grid.insert(i, position_x[i], position_z[i], radius);
+}
+
+void BatSwarm::update(float delta_time_seconds, const LodView& view)
+{
+	if (count == 0) return;
+	lod.beginTick(view);
+
+	previous_x = position_x;
+	previous_y = position_y;
+	previous_z = position_z;
+
+	//Jobs work on whole groups of SIMD_WIDTH bats
+	const unsigned group_count = (count + SIMD_WIDTH - 1) / SIMD_WIDTH;
+
+	//World collisions and choosing to pursue or explore only read the world and player
+	g_job_system.parallelFor(group_count, GROUPS_PER_JOB, [this, delta_time_seconds](unsigned begin, unsigned end)
+	{
+		scheduleSteps(begin * SIMD_WIDTH, std::min(end * SIMD_WIDTH, count), delta_time_seconds);
+		updateStates(begin * SIMD_WIDTH, std::min(end * SIMD_WIDTH, count));
+		chooseTargets(begin * SIMD_WIDTH, end * SIMD_WIDTH);
+	});
+	lod.countBands();
+
+	//New explore targets use random numbers so they are picked in bat order on this thread
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (!needs_new_target[i]) continue;
+		needs_new_target[i] = 0;
+
+		const Vec3f target = world->getRandomXZPosition();
+		target_x[i] = target.x;
+		target_y[i] = TARGET_HEIGHT;
+		target_z[i] = target.z;
+	}
+
+	g_job_system.parallelFor(group_count, GROUPS_PER_JOB, [this](unsigned begin, unsigned end)
+	{
+		steer(begin * SIMD_WIDTH, end * SIMD_WIDTH);
+	});
+
+	updateGrid();
+}
+
+unsigned BatSwarm::size() const
+{
+	return count;
+}
+
+Vec3f BatSwarm::getPosition(unsigned i) const
+{
+	assert(i < count);
+	return Vec3f(position_x[i], position_y[i], position_z[i]);
+}
+
+Vec3f BatSwarm::getVelocity(unsigned i) const
+{
+	assert(i < count);
+	return Vec3f(velocity_x[i], velocity_y[i], velocity_z[i]);
+}
+
+Vec3f BatSwarm::getForward(unsigned i) const
+{
+	assert(i < count);
+	return Vec3f(forward_x[i], forward_y[i], forward_z[i]);
+}
+
+Vec3f BatSwarm::getPreviousPosition(unsigned i) const
+{
+	assert(i < count);
+	return Vec3f(previous_x[i], previous_y[i], previous_z[i]);
+}
+
+Bat_State BatSwarm::getState(unsigned i) const
+{
+	assert(i < count);
+	return state[i];
+}
+
+bool BatSwarm::isIgnoringPlayer(unsigned i) const
+{
+	assert(i < count);
+	return ignore_timer[i] > 0;
+}
+
+void BatSwarm::hitPlayer(unsigned i)
+{
+	assert(i < count);
+	velocity_x[i] = 0;
+	velocity_y[i] = S_MAX;
+	velocity_z[i] = 0;
+	ignore_timer[i] = 1.0f;
+}
+
+const SimulationLod& BatSwarm::getLod() const
+{
+	return lod;
+}
+
+void BatSwarm::findNear(float x, float z, float r, std::vector<unsigned>& result) const
+{
+	grid.query(x, z, r, result);
+}
+
+void BatSwarm::scheduleSteps(unsigned begin, unsigned end, float delta_time_seconds)
+{
+	for (unsigned i = begin; i < end; i++)
+	{
+		step_time[i] = 0.0f;
+		if (state[i] == Bat_State::DEAD) continue;
+		if (lod.schedule(i, getPosition(i), delta_time_seconds))
+			step_time[i] = float(lod.takeAccumulatedTime(i));
+	}
+}
+
+void BatSwarm::updateStates(unsigned begin, unsigned end)
+{
+	for (unsigned i = begin; i < end; i++)
+	{
+		if (step_time[i] == 0.0f) continue;
+		ignore_timer[i] -= step_time[i];
+		if (ignore_timer[i] < 0) ignore_timer[i] = 0;
+
+		//Bats that fly into a disk die where they hit it
+		if (world->isCylinderCollisionWithDisk(Vec3f(position_x[i], position_y[i], position_z[i]), radius, 0))
+		{
+			state[i] = Bat_State::DEAD;
+			ignore_timer[i] = 1.0f;
+			step_time[i] = 0.0f;
+		}
+	}
+}
+
+void BatSwarm::chooseTargets(unsigned begin, unsigned end)
+{
+	const Vec3f player_position = player->getPosition();
+	const Vec3f player_velocity = player->getVelocity();
+
+	const simd_float zero = simdSet1(0.0f);
+
+	const simd_float player_x = simdSet1(player_position.x);
+	const simd_float player_y = simdSet1(player_position.y);
+	const simd_float player_z = simdSet1(player_position.z);
+	const simd_float player_velocity_x = simdSet1(player_velocity.x);
+	const simd_float player_velocity_y = simdSet1(player_velocity.y);
+	const simd_float player_velocity_z = simdSet1(player_velocity.z);
+	const simd_float player_half_height = simdSet1(player->getHalfHeight());
+
+	//Cylinder tests against the player use the bat's size grown by the pursue distance
+	const simd_float pursue_reach = simdSet1(radius + PURSUE_DISTANCE + player->getRadius());
+	const simd_float pursue_reach_squared = simdMul(pursue_reach, pursue_reach);
+	const simd_float pursue_half_height = simdSet1(half_height + PURSUE_DISTANCE);
+
+	const simd_float target_reach = simdSet1(radius + TARGET_RADIUS);
+	const simd_float target_reach_squared = simdMul(target_reach, target_reach);
+	const simd_float bat_half_height = simdSet1(half_height);
+	const simd_float target_half_height = simdSet1(TARGET_HALF_HEIGHT);
+
+	for (unsigned i = begin; i < end; i += SIMD_WIDTH)
+	{
+		//Only bats stepped this update choose a target
+		const simd_float is_stepped = simdGreater(simdLoad(&step_time[i]), zero);
+		if (simdMoveMask(is_stepped) == 0) continue;
+
+		const simd_float px = simdLoad(&position_x[i]);
+		const simd_float py = simdLoad(&position_y[i]);
+		const simd_float pz = simdLoad(&position_z[i]);
+
+		//Pursue if the player is in range, otherwise explore
+		const simd_float player_dx = simdSub(player_x, px);
+		const simd_float player_dy = simdSub(player_y, py);
+		const simd_float player_dz = simdSub(player_z, pz);
+		const simd_float player_distance_xz_squared = simdAdd(simdMul(player_dx, player_dx), simdMul(player_dz, player_dz));
+		const simd_float player_height_overlap =
+			simdLessEqual(simdMax(player_dy, simdSub(zero, player_dy)), simdAdd(pursue_half_height, player_half_height));
+		const simd_float pursuing = simdAnd(is_stepped,
+			simdAnd(player_height_overlap, simdLessEqual(player_distance_xz_squared, pursue_reach_squared)));
+		const simd_float exploring = simdAndNot(pursuing, is_stepped);
+
+		//Exploring bats that reached their target need a new one
+		const simd_float target_dx = simdSub(simdLoad(&target_x[i]), px);
+		const simd_float target_dy = simdSub(simdLoad(&target_y[i]), py);
+		const simd_float target_dz = simdSub(simdLoad(&target_z[i]), pz);
+		const simd_float target_distance_xz_squared = simdAdd(simdMul(target_dx, target_dx), simdMul(target_dz, target_dz));
+		const simd_float target_height_overlap =
+			simdLessEqual(simdMax(target_dy, simdSub(zero, target_dy)), simdAdd(bat_half_height, target_half_height));
+		const simd_float reached_target = simdAnd(exploring,
+			simdAnd(target_height_overlap, simdLessEqual(target_distance_xz_squared, target_reach_squared)));
+		const int pursuing_bits = simdMoveMask(pursuing);
+		const int exploring_bits = simdMoveMask(exploring);
+		const int reached_bits = simdMoveMask(reached_target);
+		for (unsigned lane = 0; lane < SIMD_WIDTH; lane++)
+		{
+			if (pursuing_bits & (1 << lane)) state[i + lane] = Bat_State::PURSUE;
+			if (exploring_bits & (1 << lane)) state[i + lane] = Bat_State::EXPLORE;
+			if (reached_bits & (1 << lane)) needs_new_target[i + lane] = 1;
+		}
+
+		//Pursuing bats aim where the player will be
+		//The further the player is the further ahead the bat predicts
+		const simd_float prediction_time = simdMul(simdSqrt(simdAdd(player_distance_xz_squared,
+			simdMul(player_dy, player_dy))), simdSet1(0.3f));
+		const simd_float pursue_x = simdAdd(player_x, simdMul(player_velocity_x, prediction_time));
+		const simd_float pursue_y = simdAdd(simdAdd(player_y, simdMul(player_velocity_y, prediction_time)), player_half_height);
+		const simd_float pursue_z = simdAdd(player_z, simdMul(player_velocity_z, prediction_time));
+		simdStore(&target_x[i], simdSelect(pursuing, pursue_x, simdLoad(&target_x[i])));
+		simdStore(&target_y[i], simdSelect(pursuing, pursue_y, simdLoad(&target_y[i])));
+		simdStore(&target_z[i], simdSelect(pursuing, pursue_z, simdLoad(&target_z[i])));
+	}
+}
+
+void BatSwarm::steer(unsigned begin, unsigned end)
+{
+	const simd_float zero = simdSet1(0.0f);
+	const simd_float one = simdSet1(1.0f);
+	const simd_float s_max = simdSet1(S_MAX);
+	const simd_float a_max = simdSet1(A_MAX);
+
+	for (unsigned i = begin; i < end; i += SIMD_WIDTH)
+	{
+		//Each bat steps by its own time, bats not stepped this update have 0
+		const simd_float dt = simdLoad(&step_time[i]);
+		const simd_float is_stepped = simdGreater(dt, zero);
+		if (simdMoveMask(is_stepped) == 0) continue;
+		const simd_float inverse_dt = simdDiv(one, simdSelect(is_stepped, dt, one));
+
+		const simd_float px = simdLoad(&position_x[i]);
+		const simd_float py = simdLoad(&position_y[i]);
+		const simd_float pz = simdLoad(&position_z[i]);
+		simd_float vx = simdLoad(&velocity_x[i]);
+		simd_float vy = simdLoad(&velocity_y[i]);
+		simd_float vz = simdLoad(&velocity_z[i]);
+
+		//Seek
+		//Desired velocity is towards the target at full speed
+		const simd_float rx = simdSub(simdLoad(&target_x[i]), px);
+		const simd_float ry = simdSub(simdLoad(&target_y[i]), py);
+		const simd_float rz = simdSub(simdLoad(&target_z[i]), pz);
+		const simd_float r_norm = simdSqrt(simdAdd(simdAdd(simdMul(rx, rx), simdMul(ry, ry)), simdMul(rz, rz)));
+		const simd_float d_scale = simdSelect(simdGreater(r_norm, zero), simdDiv(s_max, r_norm), zero);
+
+		//Desired acceleration is the steering velocity over one update, truncated to A_MAX
+		const simd_float ax = simdMul(simdSub(simdMul(rx, d_scale), vx), inverse_dt);
+		const simd_float ay = simdMul(simdSub(simdMul(ry, d_scale), vy), inverse_dt);
+		const simd_float az = simdMul(simdSub(simdMul(rz, d_scale), vz), inverse_dt);
+		const simd_float a_norm = simdSqrt(simdAdd(simdAdd(simdMul(ax, ax), simdMul(ay, ay)), simdMul(az, az)));
+		const simd_float a_scale = simdMul(simdSelect(simdGreater(a_norm, a_max), simdDiv(a_max, a_norm), one), dt);
+
+		//Update velocity truncated to S_MAX
+		vx = simdAdd(vx, simdMul(ax, a_scale));
+		vy = simdAdd(vy, simdMul(ay, a_scale));
+		vz = simdAdd(vz, simdMul(az, a_scale));
+		const simd_float v_norm = simdSqrt(simdAdd(simdAdd(simdMul(vx, vx), simdMul(vy, vy)), simdMul(vz, vz)));
+		const simd_float v_scale = simdSelect(simdGreater(v_norm, s_max), simdDiv(s_max, v_norm), one);
+		vx = simdMul(vx, v_scale);
+		vy = simdMul(vy, v_scale);
+		vz = simdMul(vz, v_scale);
+		const simd_float speed = simdMin(v_norm, s_max);
+
+		//Face along the velocity, keeping the old forward if the bat stopped
+		const simd_float moving = simdAnd(is_stepped, simdGreater(speed, zero));
+		const simd_float inverse_speed = simdDiv(one, simdMax(speed, simdSet1(1e-12f)));
+		simdStore(&forward_x[i], simdSelect(moving, simdMul(vx, inverse_speed), simdLoad(&forward_x[i])));
+		simdStore(&forward_y[i], simdSelect(moving, simdMul(vy, inverse_speed), simdLoad(&forward_y[i])));
+		simdStore(&forward_z[i], simdSelect(moving, simdMul(vz, inverse_speed), simdLoad(&forward_z[i])));
+
+		//Dead bats keep their velocity and position
+		simdStore(&velocity_x[i], simdSelect(is_stepped, vx, simdLoad(&velocity_x[i])));
+		simdStore(&velocity_y[i], simdSelect(is_stepped, vy, simdLoad(&velocity_y[i])));
+		simdStore(&velocity_z[i], simdSelect(is_stepped, vz, simdLoad(&velocity_z[i])));
+		simdStore(&position_x[i], simdSelect(is_stepped, simdAdd(px, simdMul(vx, dt)), px));
+		simdStore(&position_y[i], simdSelect(is_stepped, simdAdd(py, simdMul(vy, dt)), py));
+		simdStore(&position_z[i], simdSelect(is_stepped, simdAdd(pz, simdMul(vz, dt)), pz));
+	}
+}
+
+void BatSwarm::updateGrid()
+{
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (state[i] == Bat_State::DEAD)
+			grid.remove(i);
+		else if (step_time[i] > 0.0f)
+			grid.move(i, position_x[i], position_z[i], radius);
+	}
+}
+
+void BatSwarm::resizeArrays(unsigned padded_count)
+{
+	std::vector<float>* arrays[] = {
+		&position_x, &position_y, &position_z,
+		&velocity_x, &velocity_y, &velocity_z,
+		&forward_x, &forward_y, &forward_z,
+		&target_x, &target_y, &target_z,
+		&previous_x, &previous_y, &previous_z,
+		&ignore_timer, &step_time
+	};
+	for (std::vector<float>* array : arrays)
+		array->resize(padded_count, 0.0f);
+	state.resize(padded_count, Bat_State::DEAD);
+	needs_new_target.resize(padded_count, 0);
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <vector>
+#include "lib/ObjLibrary/Vector3.h"
+#include "SimulationLod.h"
+#include "SpatialGrid.h"
+using ObjLibrary::Vector3;
+
+class World;
+class Player;
+
+enum class Bat_State
+{
+	DEAD,
+	PURSUE,
+	EXPLORE
+};
+
+//Every bat in the world stored as float structure of arrays
+//The steering for seek, pursue and explore is done SIMD_WIDTH bats at a time.
+//Groups of bats are updated in parallel on the job system. Picking new explore targets
+//is done on the calling thread in bat order so the random numbers used are the same
+//as updating each bat alone
+class BatSwarm
+{
+public:
+	//Collision properties
+	const float radius = 0.5f;
+	const float half_height = 0.05f;
+	const float S_MAX = 5.0f;
+	const float S_MIN = 1.0f;
+	const float A_MAX = 8.0f;
+
+	//How close the player must be for a bat to pursue them
+	const float PURSUE_DISTANCE = 20.0f;
+	//How close a bat must get to its explore target to pick a new one
+	const float TARGET_RADIUS = 2.0f;
+	const float TARGET_HALF_HEIGHT = 1.0f;
+	//The height explore targets are placed at
+	const float TARGET_HEIGHT = 15.0f;
+
+	//Groups of SIMD_WIDTH bats in each job
+	const unsigned GROUPS_PER_JOB = 32;
+
+	//The width of the cells in the grid of living bats
+	const float GRID_CELL_SIZE = 8.0f;
+
+private:
+	Player const* player{};
+	World const* world{};
+
+	unsigned count{};
+
+	//Each array is padded to a multiple of SIMD_WIDTH
+	//Padding lanes are never stepped and never read back
+	std::vector<float> position_x, position_y, position_z;
+	std::vector<float> velocity_x, velocity_y, velocity_z;
+	std::vector<float> forward_x, forward_y, forward_z;
+	std::vector<float> target_x, target_y, target_z;
+	//The positions before the last update, drawing blends from them to the positions
+	std::vector<float> previous_x, previous_y, previous_z;
+
+	//A timer in seconds
+	//When bat hits a player the time is set to 1 second
+	//Bat will ignore player during this time
+	std::vector<float> ignore_timer;
+
+	std::vector<Bat_State> state;
+
+	//The time each bat steps this update
+	//Bats the LOD skips this update, dead bats and padding have 0
+	std::vector<float> step_time;
+
+	//Bats far from the player are stepped less often
+	SimulationLod lod;
+
+	//Every living bat by position, moved as the bats move
+	SpatialGrid grid;
+
+	//1 if the bat reached its explore target this update
+	//Stored as bytes so jobs can set neighbouring bats at the same time
+	std::vector<unsigned char> needs_new_target;
+
+public:
+	BatSwarm() = default;
+
+	//Removes every bat and sets the player and world the bats react to
+	void init(const Player& player, const World& world);
+
+	//Removes every bat
+	void clear();
+
+	//Adds a bat at a position flying in a random XZ direction towards a random position in the world
+	void add(const Vec3f& position);
+
+	//Updates every bat that is not dead
+	//Bats far from the view's focus are stepped less often with the time they skipped
+	void update(float delta_time_seconds, const LodView& view);
+
+	unsigned size() const;
+
+	Vec3f getPosition(unsigned i) const;
+	Vec3f getVelocity(unsigned i) const;
+	Vec3f getForward(unsigned i) const;
+	//Returns the position of a bat before the last update
+	Vec3f getPreviousPosition(unsigned i) const;
+	Bat_State getState(unsigned i) const;
+
+	//Returns if a bat recently hit the player and is ignoring them
+	bool isIgnoringPlayer(unsigned i) const;
+
+	//Knocks a bat upwards after it hits the player and makes it ignore the player for a second
+	void hitPlayer(unsigned i);
+
+	//Returns the scheduler deciding how often each bat is stepped
+	const SimulationLod& getLod() const;
+
+	//Adds the living bats that may overlap the circle at x,z with radius r to result
+	//Bats are added in index order and still need an exact intersection test
+	void findNear(float x, float z, float r, std::vector<unsigned>& result) const;
+
+private:
+	//Sets the step time of bats in [begin, end) from the LOD
+	void scheduleSteps(unsigned begin, unsigned end, float delta_time_seconds);
+
+	//Per bat world checks and timers for bats in [begin, end) stepped this update
+	void updateStates(unsigned begin, unsigned end);
+
+	//Chooses to pursue or explore and computes pursue targets for bats in [begin, end)
+	//Bats that reached their explore target are marked in needs_new_target
+	//begin and end must be multiples of SIMD_WIDTH
+	void chooseTargets(unsigned begin, unsigned end);
+
+	//Steers every bat in [begin, end) stepped this update towards its target
+	//begin and end must be multiples of SIMD_WIDTH
+	void steer(unsigned begin, unsigned end);
+
+	//Moves bats stepped this update in the grid and removes bats that died
+	void updateGrid();
+
+	//Resizes every array to hold the bats plus padding
+	void resizeArrays(unsigned padded_count);
+};
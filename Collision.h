@@ -1,6 +1,7 @@
 #pragma once
 #include "lib/ObjLibrary/Vector2.h"
 #include "lib/ObjLibrary/Vector3.h"
+#include "Vec3f.h"
 
 namespace Collision
 {
@@ -72,6 +73,21 @@ namespace Collision
 
 	}
 
+	inline bool cylinderIntersection(const Vec3f& p1, float r1, float half_heigth1, const Vec3f& p2, float r2, float half_height2)
+	{
+		const float h1 = half_heigth1;
+		const float h2 = half_height2;
+		//Check for height collision first
+		//Top of p1 doesnt reach bottom of p2
+		//Or bottom of p1 doesnt reach  top of p2
+		if (p1.y + h1 < p2.y - h2 || p1.y - h1 > p2.y + h2)
+			return false;
+
+		//Check for circle collision second
+		return circleIntersection(p1.x, p1.z, r1, p2.x, p2.z, r2);
+
+	}
+
 	inline bool cylinderIntersection(const ObjLibrary::Vector3& p1, double r1, double half_heigth1, const ObjLibrary::Vector3& p2, double r2, double half_height2)
 	{
 		const double h1 = half_heigth1;
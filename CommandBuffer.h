@@ -0,0 +1,67 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+//Commands recorded by jobs on several threads and applied later on one thread
+//Each thread records into its own list so recording needs no locks.
+//Every command has a sort key (the index of the entity that recorded it) and merging orders
+//the commands by key, so the order they are applied in does not depend on the threads
+template <typename Command>
+class CommandBuffer
+{
+private:
+	struct KeyedCommand
+	{
+		unsigned key;
+		Command command;
+	};
+
+	std::vector<std::vector<KeyedCommand>> thread_commands;
+	std::vector<KeyedCommand> merged_keyed;
+	std::vector<Command> merged;
+
+public:
+	CommandBuffer() = default;
+
+	//Sets the number of threads that record commands and clears every command
+	void init(unsigned thread_count)
+	{
+		thread_commands.resize(thread_count);
+		clear();
+	}
+
+	void clear()
+	{
+		for (auto& commands : thread_commands)
+			commands.clear();
+		merged_keyed.clear();
+		merged.clear();
+	}
+
+	//Records a command from the thread with the given index
+	void push(unsigned thread_index, unsigned key, const Command& command)
+	{
+		assert(thread_index < thread_commands.size());
+		thread_commands[thread_index].push_back(KeyedCommand{ key, command });
+	}
+
+	//Returns every recorded command ordered by key and clears the thread lists
+	//Commands with the same key keep the order they were recorded in
+	const std::vector<Command>& merge()
+	{
+		merged_keyed.clear();
+		for (auto& commands : thread_commands)
+		{
+			merged_keyed.insert(merged_keyed.end(), commands.begin(), commands.end());
+			commands.clear();
+		}
+		std::stable_sort(merged_keyed.begin(), merged_keyed.end(),
+			[](const KeyedCommand& a, const KeyedCommand& b) { return a.key < b.key; });
+
+		merged.clear();
+		for (const KeyedCommand& keyed : merged_keyed)
+			merged.push_back(keyed.command);
+		return merged;
+	}
+};
@@ -1,40 +1,39 @@
 #include "CoordinateSystem.h"
-#include "lib/ObjLibrary/Vector3.h"
 #include "MathHelper.h"
 #include "lib/ObjLibrary/Vector2.h"
 #include "lib/glm/gtc/matrix_transform.hpp"
 
 CoordinateSystem::CoordinateSystem()
 {
-	init(ObjLibrary::Vector3(0, 0, 0), ObjLibrary::Vector3(0, 0, 0), ObjLibrary::Vector3(0, 0, 0));
+	init(Vec3f(), Vec3f(), Vec3f());
 }
 
-CoordinateSystem::CoordinateSystem(const ObjLibrary::Vector3& pos, const ObjLibrary::Vector3& forward, const ObjLibrary::Vector3& up)
+CoordinateSystem::CoordinateSystem(const Vec3f& pos, const Vec3f& forward, const Vec3f& up)
 {
 	init(pos, forward, up);
 }
 
-CoordinateSystem::CoordinateSystem(const ObjLibrary::Vector3& pos, const ObjLibrary::Vector3& forward)
+CoordinateSystem::CoordinateSystem(const Vec3f& pos, const Vec3f& forward)
 {
 	init(pos, forward, calculateUpVector(forward));
 }
 
-const ObjLibrary::Vector3& CoordinateSystem::getPosition() const
+const Vec3f& CoordinateSystem::getPosition() const
 {
 	return position;
 }
 
-const ObjLibrary::Vector3& CoordinateSystem::getForward() const
+const Vec3f& CoordinateSystem::getForward() const
 {
 	return forward;
 }
 
-const ObjLibrary::Vector3& CoordinateSystem::getUp() const
+const Vec3f& CoordinateSystem::getUp() const
 {
 	return up;
 }
 
-ObjLibrary::Vector3 CoordinateSystem::getRight() const
+Vec3f CoordinateSystem::getRight() const
 {
 	return forward.crossProduct(up);
 }
@@ -45,14 +44,14 @@ glm::mat4 CoordinateSystem::getViewMatrix() const
 		glm::vec3(position + forward), glm::vec3(up));
 }
 
-void CoordinateSystem::init(const ObjLibrary::Vector3& position, const ObjLibrary::Vector3& forward, const ObjLibrary::Vector3& up)
+void CoordinateSystem::init(const Vec3f& position, const Vec3f& forward, const Vec3f& up)
 {
 	this->position = position;
 	this->forward = forward;
 	this->up = up;
 }
 
-void CoordinateSystem::init(const ObjLibrary::Vector3& position, const ObjLibrary::Vector3& forward)
+void CoordinateSystem::init(const Vec3f& position, const Vec3f& forward)
 {
 	this->position = position;
 	this->forward = forward;
@@ -61,7 +60,7 @@ void CoordinateSystem::init(const ObjLibrary::Vector3& position, const ObjLibrar
 
 
 
-void CoordinateSystem::setPosition(const ObjLibrary::Vector3& position)
+void CoordinateSystem::setPosition(const Vec3f& position)
 {
 	this->position = position;
 }
@@ -81,13 +80,13 @@ void CoordinateSystem::moveRight(float distance)
 	position += getRight() * distance;
 }
 
-void CoordinateSystem::setOrientation(const ObjLibrary::Vector3& forward, const ObjLibrary::Vector3& up)
+void CoordinateSystem::setOrientation(const Vec3f& forward, const Vec3f& up)
 {
 	this->forward = forward;
 	this->up = up;
 }
 
-void CoordinateSystem::setOrientation(const ObjLibrary::Vector3& forward)
+void CoordinateSystem::setOrientation(const Vec3f& forward)
 {
 	this->forward = forward;
 	this->up = calculateUpVector(forward);
@@ -95,64 +94,63 @@ void CoordinateSystem::setOrientation(const ObjLibrary::Vector3& forward)
 
 void CoordinateSystem::rotateAroundForward(double radians)
 {
-	up.rotateArbitrary(forward, radians);
+	up.rotateArbitrary(forward, float(radians));
 }
 
 void CoordinateSystem::rotateAroundUp(double radians)
 {
-	forward.rotateArbitrary(up, radians);
+	forward.rotateArbitrary(up, float(radians));
 }
 
 void CoordinateSystem::rotateAroundRight(double radians)
 {
-	ObjLibrary::Vector3 right = getRight();
-	forward.rotateArbitrary(right, radians);
+	Vec3f right = getRight();
+	forward.rotateArbitrary(right, float(radians));
 	//up.rotateArbitrary(right, radians);
 }
 
-void CoordinateSystem::rotateAroundTarget(const ObjLibrary::Vector3& target, double radiansUp, double radiansRight)
+void CoordinateSystem::rotateAroundTarget(const Vec3f& target, double radiansUp, double radiansRight)
 {
 	//pitch up down
-	ObjLibrary::Vector3 diff = position - target;
-	ObjLibrary::Vector3 newPos = position - target;
+	Vec3f newPos = position - target;
 
-	newPos.rotateArbitrary(getRight().getNormalized(), radiansRight);
+	newPos.rotateArbitrary(getRight().getNormalized(), float(radiansRight));
 	//yaw left right
-	newPos.rotateArbitrary(up.getNormalized(), radiansUp);
+	newPos.rotateArbitrary(up.getNormalized(), float(radiansUp));
 	position = newPos + target;
 	//Look at target
 	lookAt(target);
 }
 
-void CoordinateSystem::rotateAroundTargetToPosition(const ObjLibrary::Vector3& target,
-	const ObjLibrary::Vector3& to_position, double max_radians)
+void CoordinateSystem::rotateAroundTargetToPosition(const Vec3f& target,
+	const Vec3f& to_position, double max_radians)
 {
-	ObjLibrary::Vector3 target_towards_position = -(position - target).getNormalized();
-	ObjLibrary::Vector3 target_towards_to_position = -(to_position - target).getNormalized();
-	ObjLibrary::Vector3 cross = target_towards_position.crossProduct((target_towards_to_position));
-	double angle = target_towards_position.getAngleSafe(target_towards_to_position);
+	Vec3f target_towards_position = -(position - target).getNormalized();
+	Vec3f target_towards_to_position = -(to_position - target).getNormalized();
+	Vec3f cross = target_towards_position.crossProduct((target_towards_to_position));
+	float angle = target_towards_position.getAngleSafe(target_towards_to_position);
 
 
 	if (angle > MathHelper::M_PI_2)
 	{
-		double temp = cross.x;
+		float temp = cross.x;
 		if (cross.y < 0 && cross.z < 0) temp = -temp;
 		cross.x = cross.z;
 		cross.z = temp;
 	}
 
 
-	if (angle > max_radians) angle = max_radians;
-	else if (angle < -max_radians) angle = -max_radians;
+	if (angle > max_radians) angle = float(max_radians);
+	else if (angle < -max_radians) angle = float(-max_radians);
 
-	ObjLibrary::Vector3 newPos = position - target;
+	Vec3f newPos = position - target;
 	newPos.rotateArbitrary(cross, angle);
 	position = newPos + target;
 	lookAt(target);
 
 }
 
-void CoordinateSystem::lookAt(const ObjLibrary::Vector3& target)
+void CoordinateSystem::lookAt(const Vec3f& target)
 {
 	setOrientation(
 		(target - this->position).getNormalized()
@@ -162,7 +160,7 @@ void CoordinateSystem::lookAt(const ObjLibrary::Vector3& target)
 
 void CoordinateSystem::calculateOrientationMatrix(double a_matrix[]) const
 {
-	ObjLibrary::Vector3 right = getRight();
+	Vec3f right = getRight();
 
 	a_matrix[0] = right.x;
 	a_matrix[1] = right.y;
@@ -185,10 +183,10 @@ void CoordinateSystem::calculateOrientationMatrix(double a_matrix[]) const
 
 void CoordinateSystem::calculateRotationMatrix(double a_matrix[]) const
 {
-	ObjLibrary::Vector3 xaxis = up.crossProduct(forward);
+	Vec3f xaxis = up.crossProduct(forward);
 	xaxis.normalize();
 
-	ObjLibrary::Vector3 yaxis = forward.crossProduct(xaxis);
+	Vec3f yaxis = forward.crossProduct(xaxis);
 	yaxis.normalize();
 
 	a_matrix[0] = xaxis.x;
@@ -210,22 +208,22 @@ void CoordinateSystem::calculateRotationMatrix(double a_matrix[]) const
 }
 
 
-ObjLibrary::Vector3 CoordinateSystem::calculateUpVector(const ObjLibrary::Vector3& local_forward) const
+Vec3f CoordinateSystem::calculateUpVector(const Vec3f& local_forward) const
 {
-	static const ObjLibrary::Vector3 IDEAL_UP_VECTOR(0.0, 1.0, 0.0);
-	static const double HALF_PI = 1.5707963267948966;
+	static const Vec3f IDEAL_UP_VECTOR(0.0f, 1.0f, 0.0f);
+	static const float HALF_PI = 1.57079633f;
 	// code will go here
 
 	assert(!local_forward.isZero());
 
-	ObjLibrary::Vector3 axis = local_forward.crossProduct(IDEAL_UP_VECTOR);
+	Vec3f axis = local_forward.crossProduct(IDEAL_UP_VECTOR);
 
 	if (axis.isZero())
-		return ObjLibrary::Vector3(1.0, 0.0, 0.0);
+		return Vec3f(1.0f, 0.0f, 0.0f);
 
 	axis.normalize();
 	// more code here
-	ObjLibrary::Vector3 local_up = local_forward.getRotatedArbitrary(axis, HALF_PI);
+	Vec3f local_up = local_forward.getRotatedArbitrary(axis, HALF_PI);
 	return local_up;
 
 
@@ -235,16 +233,16 @@ ObjLibrary::Vector3 CoordinateSystem::calculateUpVector(const ObjLibrary::Vector
 void CoordinateSystem::rotateUpright(double max_radians)
 {
 	// code will go here
-	ObjLibrary::Vector3 desired_up = calculateUpVector(forward);
-	ObjLibrary::Vector3 axis = up.crossProduct(desired_up);
+	Vec3f desired_up = calculateUpVector(forward);
+	Vec3f axis = up.crossProduct(desired_up);
 	if (axis.isZero())
 		axis = forward;
 	else
 		axis.normalize();
 
-	double radians = up.getAngleSafe(desired_up);
+	float radians = up.getAngleSafe(desired_up);
 	if (radians > max_radians)
-		radians = max_radians;
+		radians = float(max_radians);
 
 	up.rotateArbitrary(axis, radians);
 }
@@ -253,5 +251,18 @@ void CoordinateSystem::setRandomUp()
 {
 	static const double PI = 3.14159265358979323846;
 	double random0to1 = rand() / (RAND_MAX + 1.0);
-	up.rotateArbitrary(forward, random0to1 * 2 * PI);
+	up.rotateArbitrary(forward, float(random0to1 * 2 * PI));
+}
+
+CoordinateSystem CoordinateSystem::interpolate(const CoordinateSystem& from, const CoordinateSystem& to, float fraction)
+{
+	CoordinateSystem result = to;
+	result.position = from.position + (to.position - from.position) * fraction;
+
+	//Turns in one update are small so a normalized blend is close to rotating
+	const Vec3f blended_forward = from.forward + (to.forward - from.forward) * fraction;
+	const Vec3f blended_up = from.up + (to.up - from.up) * fraction;
+	if (!blended_forward.isZero()) result.forward = blended_forward.getNormalized();
+	if (!blended_up.isZero()) result.up = blended_up.getNormalized();
+	return result;
 }
@@ -1,30 +1,30 @@
 #pragma once
 #include "lib/glm/glm.hpp"
-#include "lib/ObjLibrary/Vector3.h"
+#include "Vec3f.h"
 
-//Leverages the Vector3 class by managing a position, forward, and up vector
+//Leverages the Vec3f class by managing a position, forward, and up vector
 //	as a Coordinate System
 
 class CoordinateSystem
 {
 public:
 	//Camera position
-	ObjLibrary::Vector3 position;
+	Vec3f position;
 	//Camera forward
-	ObjLibrary::Vector3 forward;
+	Vec3f forward;
 	//Camera up
-	ObjLibrary::Vector3 up;
+	Vec3f up;
 
 	explicit CoordinateSystem();
 	//Initializing Contructor
 	explicit CoordinateSystem(
-		const ObjLibrary::Vector3& pos,
-		const ObjLibrary::Vector3& forward,
-		const ObjLibrary::Vector3& up);
+		const Vec3f& pos,
+		const Vec3f& forward,
+		const Vec3f& up);
 
 	explicit CoordinateSystem(
-		const ObjLibrary::Vector3& pos,
-		const ObjLibrary::Vector3& forward);
+		const Vec3f& pos,
+		const Vec3f& forward);
 
 	//Copy Constructor
 	CoordinateSystem(const CoordinateSystem& other) = default;
@@ -38,22 +38,22 @@ public:
 	CoordinateSystem& operator=(CoordinateSystem&& other) = default;
 
 	//Getters
-	const ObjLibrary::Vector3& getPosition() const;
-	const ObjLibrary::Vector3& getForward() const;
-	const ObjLibrary::Vector3& getUp() const;
-	ObjLibrary::Vector3 getRight() const;
+	const Vec3f& getPosition() const;
+	const Vec3f& getForward() const;
+	const Vec3f& getUp() const;
+	Vec3f getRight() const;
 
 	//Setters the position
-	void setPosition(const ObjLibrary::Vector3& position);
-	void setOrientation(const ObjLibrary::Vector3& forward, const ObjLibrary::Vector3& up);
-	void setOrientation(const ObjLibrary::Vector3& forward);
+	void setPosition(const Vec3f& position);
+	void setOrientation(const Vec3f& forward, const Vec3f& up);
+	void setOrientation(const Vec3f& forward);
 
 	//Get the view matrix using glm::lookAt
 	glm::mat4 getViewMatrix() const;
 
 	//Initialize a coordinate system
-	void init(const ObjLibrary::Vector3& position, const ObjLibrary::Vector3& forward, const ObjLibrary::Vector3& up);
-	void init(const ObjLibrary::Vector3& position, const ObjLibrary::Vector3& forward);
+	void init(const Vec3f& position, const Vec3f& forward, const Vec3f& up);
+	void init(const Vec3f& position, const Vec3f& forward);
 
 	//Move the coordinate system a distance
 	void moveForward(float distance);
@@ -66,14 +66,14 @@ public:
 	void rotateAroundRight(double radians);
 
 	//Arcball around a target
-	void rotateAroundTarget(const ObjLibrary::Vector3& target, double radiansUp, double radiansRight);
+	void rotateAroundTarget(const Vec3f& target, double radiansUp, double radiansRight);
 
 	//Arcball around a target to a position
 	//TODO doesnt work
-	void rotateAroundTargetToPosition(const ObjLibrary::Vector3& target, const ObjLibrary::Vector3& position, double max_radians);
+	void rotateAroundTargetToPosition(const Vec3f& target, const Vec3f& position, double max_radians);
 
 	//Set the forward to lookAt a target
-	void lookAt(const ObjLibrary::Vector3& target);
+	void lookAt(const Vec3f& target);
 
 	//Calculates an orientation matrix
 	void calculateOrientationMatrix(double a_matrix[]) const;
@@ -81,11 +81,15 @@ public:
 	void calculateRotationMatrix(double a_matrix[]) const;
 
 	//Calculates an up vector from a forward
-	ObjLibrary::Vector3 calculateUpVector(const ObjLibrary::Vector3& local_forward) const;
+	Vec3f calculateUpVector(const Vec3f& local_forward) const;
 
 	//Rotates the coordinate system towards upright
 	void rotateUpright(double max_radians);
 
 	//Sets a random up vector
 	void setRandomUp();
+
+	//Returns a coordinate system a fraction of the way from one to another
+	//The position is blended linearly and the forward and up are blended and normalized
+	static CoordinateSystem interpolate(const CoordinateSystem& from, const CoordinateSystem& to, float fraction);
 };
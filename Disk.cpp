@@ -4,12 +4,17 @@
 #include "PerformanceCounter.h"
 #include "MathHelper.h"
 #include "DepthTexture.h"
+#include <algorithm>
 
 extern DepthTexture g_depth_texture;
+extern bool g_headless;
 
 
 void Disk::generateHeightMapModel()
 {
+	//The height map is still used for collisions without a GPU
+	if (g_headless) return;
+
 	assert(heightMapSize % 2 == 0);
 	assert(!heightMap.empty());
 
@@ -196,8 +201,8 @@ float Disk::getHeightAtPosition(float x, float z) const
 		return 0.0f;
 
 	//Index in height map
-	const unsigned int ix = unsigned int(floor(cx));
-	const unsigned int kz = unsigned int(floor(cz));
+	const unsigned int ix = unsigned(floor(cx));
+	const unsigned int kz = unsigned(floor(cz));
 
 	const float fx = cx - ix;
 	const float fz = cz - kz;
@@ -236,6 +241,66 @@ float Disk::getHeightAtPosition(float x, float z) const
 	return height;
 }
 
+simd_float Disk::getHeightsAtPositions(simd_float x, simd_float z) const
+{
+	//get x,z within the height map centered on the bottom left corner
+	const simd_float scale = simdSet1((heightMapSize / 2.0f) / (radius * float(MathHelper::M_SQRT2_2)));
+	const simd_float half_size = simdSet1(heightMapSize / 2.0f);
+	const simd_float cx = simdAdd(simdMul(simdSub(x, simdSet1(float(position.x))), scale), half_size);
+	const simd_float cz = simdAdd(simdMul(simdSub(z, simdSet1(float(position.z))), scale), half_size);
+
+	float cx_lanes[SIMD_WIDTH], cz_lanes[SIMD_WIDTH];
+	simdStore(cx_lanes, cx);
+	simdStore(cz_lanes, cz);
+
+	//The corners of the height map cell each position is in
+	//Positions outside the height map use a flat cell at 0
+	float h00[SIMD_WIDTH], h10[SIMD_WIDTH], h01[SIMD_WIDTH], h11[SIMD_WIDTH];
+	float fx_lanes[SIMD_WIDTH], fz_lanes[SIMD_WIDTH];
+	for (unsigned lane = 0; lane < SIMD_WIDTH; lane++)
+	{
+		const float lane_cx = cx_lanes[lane];
+		const float lane_cz = cz_lanes[lane];
+		if (lane_cx >= 0 && lane_cx < heightMapSize && lane_cz >= 0 && lane_cz < heightMapSize)
+		{
+			const unsigned int ix = unsigned(lane_cx);
+			const unsigned int kz = unsigned(lane_cz);
+			h00[lane] = heightMap[ix][kz];
+			h10[lane] = heightMap[ix + 1][kz];
+			h01[lane] = heightMap[ix][kz + 1];
+			h11[lane] = heightMap[ix + 1][kz + 1];
+			fx_lanes[lane] = lane_cx - ix;
+			fz_lanes[lane] = lane_cz - kz;
+		} else
+		{
+			h00[lane] = h10[lane] = h01[lane] = h11[lane] = 0.0f;
+			fx_lanes[lane] = fz_lanes[lane] = 0.0f;
+		}
+	}
+
+	//Interpolate across the triangle of the cell the position is in, like getHeightAtPosition
+	const simd_float fx = simdLoad(fx_lanes);
+	const simd_float fz = simdLoad(fz_lanes);
+	const simd_float corner = simdLoad(h00);
+	const simd_float opposite = simdLoad(h11);
+	const simd_float right = simdLoad(h10);
+	const simd_float up = simdLoad(h01);
+	//Upper right triangle
+	const simd_float upper = simdAdd(corner, simdAdd(simdMul(fx, simdSub(right, corner)), simdMul(fz, simdSub(opposite, right))));
+	//Lower right triangle
+	const simd_float lower = simdAdd(corner, simdAdd(simdMul(fz, simdSub(up, corner)), simdMul(fx, simdSub(opposite, up))));
+	return simdSelect(simdGreater(fx, fz), upper, lower);
+}
+
+float Disk::getMaxHeight() const
+{
+	float max_height = 0.0f;
+	for (const std::vector<float>& row : heightMap)
+		for (const float height : row)
+			max_height = std::max(max_height, height);
+	return max_height;
+}
+
 float Disk::getSpeedFactor() const
 {
 	switch (type)
@@ -1,5 +1,6 @@
 #pragma once
 #include "lib/ObjLibrary/ModelWithShader.h"
+#include "SIMD.h"
 
 
 using ObjLibrary::Vector3;
@@ -54,6 +55,13 @@ public:
 
 	virtual float getHeightAtPosition(float x, float z) const;
 
+	//Gets the height at SIMD_WIDTH positions at once, the same as getHeightAtPosition for each
+	//Only the height map reads are done one position at a time
+	simd_float getHeightsAtPositions(simd_float x, simd_float z) const;
+
+	//Returns the highest point of the height map
+	float getMaxHeight() const;
+
 	float getSpeedFactor() const;
 	float getAccelFactor() const;
 	float getFriction() const;
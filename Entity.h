@@ -1,5 +1,6 @@
 #pragma once
 #include "lib/ObjLibrary/Vector3.h"
+#include "Vec3f.h"
 #include "lib/ObjLibrary/ModelWithShader.h"
 #include "CoordinateSystem.h"
 
@@ -15,12 +16,12 @@ public:
 		: model(&model)
 	{}
 
-	explicit Entity(const ModelWithShader& model, const Vector3& pos, const Vector3& forward = Vector3(0,0,-1))
-		: coordinate_system(pos,forward), model(&model)
+	explicit Entity(const ModelWithShader& model, const Vec3f& pos, const Vec3f& forward = Vec3f(0,0,-1))
+		: coordinate_system(pos,forward), previous_coordinate_system(pos,forward), model(&model)
 	{}
 
 		explicit Entity(const ModelWithShader& model, const CoordinateSystem& coordinate_system)
-		: coordinate_system(coordinate_system), model(&model)
+		: coordinate_system(coordinate_system), previous_coordinate_system(coordinate_system), model(&model)
 	{}
 
 	virtual ~Entity() = default;
@@ -28,10 +29,18 @@ public:
 
 
 	CoordinateSystem coordinate_system;
+	//The coordinate system before the last update, drawing blends from it to coordinate_system
+	CoordinateSystem previous_coordinate_system;
+
+	//Saves the coordinate system before it is changed by an update
+	void savePreviousTransform()
+	{
+		previous_coordinate_system = coordinate_system;
+	}
 
 	//For drawing the model
-	Vector3 model_scalar = {1,1,1};
-	Vector3 model_forward = {0,0,-1};
+	Vec3f model_scalar = Vec3f(1,1,1);
+	Vec3f model_forward = Vec3f(0,0,-1);
 
 public:
 	ModelWithShader const* model;
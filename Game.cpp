@@ -7,6 +7,9 @@
 #include "MathHelper.h"
 #include "Ring.h"
 #include "ParticleEmitter.h"
+#include "JobSystem.h"
+#include "StateHash.h"
+#include "RenderSnapshot.h"
 
 //Matrix to help with calculating depth texture
 const glm::mat4 BIAS_MATRIX(
@@ -17,6 +20,13 @@ const glm::mat4 BIAS_MATRIX(
 );
 
 
+void Game::initWorldGraph(const std::string& world_file_name)
+{
+	const std::string cache_name = world_file_name.substr(0, world_file_name.find_last_of('.')) + ".graph";
+	world_graph.initCached(world.disks, WORLD_FOLDER + world_file_name, GRAPH_CACHE_FOLDER + cache_name);
+	initWorldGraphPointLine();
+}
+
 void Game::initWorldGraphPointLine()
 {
 	const glm::vec3 offset(0, 0.2, 0);
@@ -36,28 +46,32 @@ void Game::initWorldGraphPointLine()
 
 void Game::initBats()
 {
+	bats.init(player, world);
 	for (auto && disk : world.disks)
 	{
-		Vector3 pos = world.getRandomXZPosition();
+		Vec3f pos = world.getRandomXZPosition();
 		pos.y = 15.0f;
-		bats.emplace_back(bat_model, player, world, pos);
+		bats.add(pos);
 	}
 }
 
 
-void Game::init()
+void Game::init(const std::string& world_file_name)
 {
-	ObjShader::load();
-
-	ObjModel model;
-	model.load(ROD_FILENAME);
-	this->rod_model = model.getModelWithShader();
-	model.load(RING_FILENAME);
-	this->ring_model = model.getModelWithShader();
-	model.load(SKYBOX_FILENAME);
-	skybox_model = model.getModelWithShader();
-	model.load(BAT_FILENAME);
-	bat_model = model.getModelWithShader();
+	if (!g_headless)
+	{
+		ObjShader::load();
+
+		ObjModel model;
+		model.load(ROD_FILENAME);
+		this->rod_model = model.getModelWithShader();
+		model.load(RING_FILENAME);
+		this->ring_model = model.getModelWithShader();
+		model.load(SKYBOX_FILENAME);
+		skybox_model = model.getModelWithShader();
+		model.load(BAT_FILENAME);
+		bat_model = model.getModelWithShader();
+	}
 
 #ifdef  _WIN32
 	//Load the file names of all of the worlds
@@ -68,7 +82,7 @@ void Game::init()
 #endif
 
 	//The world that is loaded first
-	world.init(WORLD_FOLDER + "Basic.txt");
+	world.init(WORLD_FOLDER + world_file_name);
 	//world.init(WORLD_FOLDER + "Dense.txt");
 	//world.init(WORLD_FOLDER + "Icy.txt");
 	//world.init(WORLD_FOLDER + "Leafy.txt");
@@ -78,10 +92,8 @@ void Game::init()
 	//world.init(WORLD_FOLDER + "Small.txt");
 	//world.init(WORLD_FOLDER + "Sparse.txt");
 	//world.init(WORLD_FOLDER + "Twisted.txt");
-	world_graph.init(world.disks);
-
-
-	initWorldGraphPointLine();
+	g_particle_emitter.setCollisionWorld(&world);
+	initWorldGraph(world_file_name);
 
 	player_camera.setPosition(PLAYER_CAMERA_INIT_POS);
 	player_camera.setOrientation(CAMERA_INIT_FORWARD);
@@ -90,16 +102,21 @@ void Game::init()
 	//overview_camera.setOrientation(Vector3(0.0f, -1.0f, 0.0f));
 
 	active_camera = &player_camera;
+	previous_player_camera = player_camera;
+	previous_overview_camera = overview_camera;
 
 	pickup_manager.init(world, world_graph, rod_model, ring_model);
 	player.init(world);
 
 	initBats();
 
+	if (g_headless) return;
+
 	//Initialize for shadows
 	//Pass the light view matrix to the shadow box
 	light_view_matrix = glm::mat4();
-	shadow_box.init(&light_view_matrix, &active_camera);
+	render_camera = *active_camera;
+	shadow_box.init(&light_view_matrix, &render_camera_pointer);
 
 	//Enabled lighting and shadows
 	LightingManager::setEnabled(true);
@@ -123,13 +140,13 @@ void Game::init()
 	//LightingManager::setLightAttenuation(1, 1.5f, 0.09f, 0.032f);
 
 
-	const Vector3 forward_vector = active_camera->getForward();
-	const Vector3 up_vector = active_camera->getUp();
-	const Vector3 to_far = forward_vector * shadow_box.SHADOW_DISTANCE;
-	const Vector3 to_near = forward_vector * (shadow_box.CLIP_NEAR);
+	const Vec3f forward_vector = active_camera->getForward();
+	const Vec3f up_vector = active_camera->getUp();
+	const Vec3f to_far = forward_vector * shadow_box.SHADOW_DISTANCE;
+	const Vec3f to_near = forward_vector * (shadow_box.CLIP_NEAR);
 
-	const Vector3 center_near = to_near + active_camera->getPosition();
-	const Vector3 center_far = to_far + active_camera->getPosition();
+	const Vec3f center_near = to_near + active_camera->getPosition();
+	const Vec3f center_far = to_far + active_camera->getPosition();
 
 	glm::vec4* points = shadow_box.calculateFrustumVertices(up_vector, forward_vector, center_near,
 		center_far);
@@ -143,11 +160,16 @@ void Game::update(double fixed_delta_time)
 	const float delta_time = float(fixed_delta_time);
 	const float delta_time_seconds = float(fixed_delta_time / 1000.0f);
 
+	//Drawing blends from where the player and cameras were before this update
+	player.savePreviousTransform();
+	previous_player_camera = player_camera;
+	previous_overview_camera = overview_camera;
+
 	//PLAYER UPDATE ************************************
 	//save old player values for calculations
 	bool player_moved = false;
-	const Vector3 last_player_pos = player.coordinate_system.getPosition();
-	const Vector3 last_player_forward = player.coordinate_system.getForward();
+	const Vec3f last_player_pos = player.coordinate_system.getPosition();
+	const Vec3f last_player_forward = player.coordinate_system.getForward();
 
 	//move player
 	if (g_key_pressed['D'])
@@ -172,10 +194,13 @@ void Game::update(double fixed_delta_time)
 	//Update the player
 	player.update(world, delta_time_seconds);
 
-	for (auto && bat : bats)
-	{
-		bat.update(delta_time_seconds);
-	}
+	//Bats and rings far from the player update less often
+	LodView lod_view;
+	lod_view.focus = player.getPosition();
+	lod_view.camera_position = active_camera->getPosition();
+	lod_view.camera_forward = active_camera->getForward();
+
+	bats.update(float(delta_time_seconds), lod_view);
 
 	batPlayerCollisions();
 
@@ -187,7 +212,7 @@ void Game::update(double fixed_delta_time)
 
 
 	//Update the position of the rings
-	pickup_manager.update(fixed_delta_time);
+	pickup_manager.update(fixed_delta_time, lod_view);
 
 	//Do collision detection for player and rings/rods
 	pickup_manager.checkForPickups(player);
@@ -239,9 +264,9 @@ void Game::update(double fixed_delta_time)
 		if (angle_y < MathHelper::M_PI * 0.08)
 			if (g_mouse_dy < 0) g_mouse_dy = 0;
 
-		const Vector3 target = player.coordinate_system.getPosition() + PLAYER_CAMERA_OFFSET;
+		const Vec3f target = player.coordinate_system.getPosition() + PLAYER_CAMERA_OFFSET;
 		player_camera.rotateAroundTarget(target, glm::radians(double(-g_mouse_dx)), glm::radians(double(-g_mouse_dy)));
-		player_camera.setOrientation(player_camera.getForward().getNormalized(), Vector3(0, 1, 0));
+		player_camera.setOrientation(player_camera.getForward().getNormalized(), Vec3f(0, 1, 0));
 		camera_float = true;
 	}
 
@@ -249,14 +274,14 @@ void Game::update(double fixed_delta_time)
 	//Glides the camera back behind the player when left click is released.
 	if (!g_key_pressed[MOUSE_LEFT])
 	{
-		Vector3 new_cam_position = player.coordinate_system.getPosition();
-		const Vector3& player_forward = player.coordinate_system.getForward();
+		Vec3f new_cam_position = player.coordinate_system.getPosition();
+		const Vec3f& player_forward = player.coordinate_system.getForward();
 
 		new_cam_position.x -= 4.0f * player_forward.x;
 		new_cam_position.z -= 4.0f * player_forward.z;
 		new_cam_position += PLAYER_CAMERA_OFFSET;
 
-		Vector3 diff = player_camera.getPosition() - new_cam_position;
+		Vec3f diff = player_camera.getPosition() - new_cam_position;
 		const double norm = diff.getNorm();
 
 		//We want the camera to move faster if farther but to not too fast when far
@@ -267,7 +292,7 @@ void Game::update(double fixed_delta_time)
 			//Caps the speed
 			if (log_factor > 10.0) log_factor = 10.0;
 
-			const Vector3 target = player.coordinate_system.getPosition() + PLAYER_CAMERA_OFFSET;
+			const Vec3f target = player.coordinate_system.getPosition() + PLAYER_CAMERA_OFFSET;
 			player_camera.rotateAroundTargetToPosition(target, new_cam_position, glm::radians(log_factor*0.5));
 		} else
 		{
@@ -290,9 +315,9 @@ void Game::update(double fixed_delta_time)
 	//If camera is not in free float around player, snap it back behind the player
 	if (!camera_float)
 	{
-		Vector3 new_cam_position = player.coordinate_system.getPosition();
-		const Vector3& player_forward = player.coordinate_system.getForward();
-		player_camera.setOrientation(player_forward, Vector3(0, 1, 0));
+		Vec3f new_cam_position = player.coordinate_system.getPosition();
+		const Vec3f& player_forward = player.coordinate_system.getForward();
+		player_camera.setOrientation(player_forward, Vec3f(0, 1, 0));
 		new_cam_position.x -= 4.0f * player_forward.x;
 		new_cam_position.z -= 4.0f * player_forward.z;
 		new_cam_position += PLAYER_CAMERA_OFFSET;
@@ -309,12 +334,43 @@ void Game::updateAnimations(double delta_time)
 	player.updateAnimation(delta_time);
 }
 
+unsigned long long Game::getStateHash() const
+{
+	StateHash hash;
+	hash.add(player.getPosition());
+	hash.add(player.getVelocity());
+	hash.add(player.coordinate_system.getForward());
+
+	hash.add(bats.size());
+	for (unsigned i = 0; i < bats.size(); i++)
+	{
+		hash.add(bats.getPosition(i));
+		hash.add(bats.getVelocity(i));
+		hash.add(unsigned(bats.getState(i)));
+	}
+
+	pickup_manager.hashState(hash);
+	return hash.get();
+}
+
 
-void Game::display()
+void Game::display(const RenderSnapshot& snapshot)
 {
+	//Draw between the last two updates so motion stays smooth when updates are slower than the display
+	//The shadow box follows the drawn camera
+	render_camera = getRenderCamera(snapshot, g_render_fraction);
+	const CoordinateSystem render_player = CoordinateSystem::interpolate(snapshot.previous_player, snapshot.player, g_render_fraction);
+
+	//The particles only change when there is a new snapshot
+	if (snapshot.update_count != uploaded_update_count)
+	{
+		g_particle_emitter.upload(snapshot.particle_data, snapshot.particle_origin);
+		uploaded_update_count = snapshot.update_count;
+	}
+
 	//**************Render to depth texture ***************
 	glm::mat4 depth_vp;
-	renderToDepthTexture(depth_vp);
+	renderToDepthTexture(snapshot, render_player, depth_vp);
 
 	//**********Done Rendering to Depth Texture ********************
 
@@ -328,7 +384,7 @@ void Game::display()
 	LightingManager::setShadowMap(g_depth_texture.getTexture());
 	LightingManager::setShadowMapSpaceMatrix(shadow_map_space_matrix);
 
-	const Vector3& camera_position = active_camera->getPosition();
+	const Vec3f& camera_position = render_camera.getPosition();
 
 	//************Render to the screen with shadows and lighting*************
 	glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -341,10 +397,10 @@ void Game::display()
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	//Positional light at player position
-	LightingManager::setLightPositional(1, player.coordinate_system.getPosition());
+	LightingManager::setLightPositional(1, render_player.getPosition());
 
 	// Get the current camera view matrix
-	glm::mat4 view_matrix = active_camera->getViewMatrix();
+	glm::mat4 view_matrix = render_camera.getViewMatrix();
 
 
 	//Draw the skybox
@@ -359,39 +415,55 @@ void Game::display()
 
 	//Draw the world
 	world.drawOptimized(view_matrix, g_projection_matrix, camera_position);
-	pickup_manager.drawOptimized(view_matrix, g_projection_matrix, camera_position);
+	pickup_manager.drawOptimized(snapshot.pickups, g_render_fraction, view_matrix, g_projection_matrix, camera_position);
 
 
-	displayBats(view_matrix, g_projection_matrix, camera_position);
+	displayBats(snapshot, view_matrix, g_projection_matrix, camera_position);
 
-	player.draw(view_matrix, g_projection_matrix, camera_position);
+	player.draw(render_player, snapshot.player_pose, view_matrix, g_projection_matrix, camera_position);
 
 	g_particle_emitter.draw(view_matrix,g_projection_matrix);
 
-	const std::string text = "Score: " + std::to_string(pickup_manager.getScore());
+	const std::string text = "Score: " + std::to_string(snapshot.score);
 	const float text_width = g_text_renderer.getWidth(text, 0.75f);
 	//g_text_renderer.draw(text, float(g_win_width - text_width - 10), float(g_win_height - 40), 0.75f, glm::vec3(1, 1, 1));
 
-	displayMovementGraph(view_matrix, g_projection_matrix);
+	displayMovementGraph(snapshot, view_matrix, g_projection_matrix);
 
 	//Draw the node ids
-	//displayNodeNameplates(view_matrix, g_projection_matrix);
+	//displayNodeNameplates(snapshot, view_matrix, g_projection_matrix);
 
 	//Draw the Search path for overview camera
-	displaySearchPathSpheres(view_matrix, g_projection_matrix);
+	displaySearchPathSpheres(snapshot, view_matrix, g_projection_matrix);
 
 	//Draw the line of Ring0 from current position to end node
-	displayRingZeroPath(view_matrix, g_projection_matrix);
+	displayRingZeroPath(snapshot, view_matrix, g_projection_matrix);
 
 
 	//Draw useful text on the screen
-	const unsigned a_visits = world_graph.getMemorizedAStarVisits(),
-		d_visits = world_graph.getMemorizedDijsktraVisits(),
-		mm_visits = world_graph.getMemorizedmmVisits();
+	//The search visit counts change on the simulation thread so they are not in the snapshot
+	//const unsigned a_visits = world_graph.getMemorizedAStarVisits(),
+	//	d_visits = world_graph.getMemorizedDijsktraVisits(),
+	//	mm_visits = world_graph.getMemorizedmmVisits();
 
 	g_text_renderer.draw("Update Rate: " + std::to_string(long(round(g_update_fps))), 2, float(g_win_height - 20), 0.4f, glm::vec3(0, 1, 0));
 	g_text_renderer.draw("Display Rate: " + std::to_string(long(round(g_display_fps))), 2, float(g_win_height - 40), 0.4f, glm::vec3(0, 1, 0));
-	g_text_renderer.draw("Time Scale: " + realToString(g_time_scale, 2) + 'x', 2, float(g_win_height - 60), 0.4f, glm::vec3(0, 1, 0));
+	g_text_renderer.draw("Time Scale: " + realToString(snapshot.time_scale, 2) + 'x', 2, float(g_win_height - 60), 0.4f, glm::vec3(0, 1, 0));
+
+	//Share of bats and rings in each simulation LOD band, from full rate to 1/8 rate
+	const unsigned lod_entities = std::max(1u, snapshot.lod_entity_count);
+	std::string lod_text = "LOD Bands:";
+	for (unsigned b = 0; b < SimulationLod::BAND_COUNT; b++)
+		lod_text += " " + realToString(100.0f * float(snapshot.lod_band_counts[b]) / float(lod_entities), 0) + "%";
+	g_text_renderer.draw(lod_text, 2, float(g_win_height - 80), 0.4f, glm::vec3(0, 1, 0));
+
+	//Live particles and the share of requested particles culled for distance and for the budget
+	const ParticleCounters& particle_counters = snapshot.particle_counters;
+	const float requested_particles = float(std::max(1ull, particle_counters.requested));
+	g_text_renderer.draw("Particles: " + std::to_string(snapshot.particle_data.size())
+		+ " Distance Culled: " + realToString(100.0f * float(particle_counters.culled_by_distance) / requested_particles, 0) + "%"
+		+ " Budget Culled: " + realToString(100.0f * float(particle_counters.culled_by_budget) / requested_particles, 0) + "%",
+		2, float(g_win_height - 100), 0.4f, glm::vec3(0, 1, 0));
 	//g_text_renderer.draw("Nodes: " + std::to_string(world_graph.getNodeCount()), 2, float(g_win_height - 84), 0.4f, glm::vec3(0, 1, 0));
 	//g_text_renderer.draw("Node Links: " + std::to_string(world_graph.getNodeLinkCount()), 2, float(g_win_height - 104), 0.4f, glm::vec3(0, 1, 0));
 
@@ -409,7 +481,61 @@ void Game::display()
 
 }
 
-void Game::displayBats(const glm::mat4x4& view_matrix,
+void Game::fillSnapshot(RenderSnapshot& snapshot) const
+{
+	snapshot.previous_player = player.previous_coordinate_system;
+	snapshot.player = player.coordinate_system;
+	snapshot.player_pose = player.getAnimationPose();
+
+	snapshot.overview_camera_active = active_camera == &overview_camera;
+	snapshot.previous_camera = snapshot.overview_camera_active ? previous_overview_camera : previous_player_camera;
+	snapshot.camera = *active_camera;
+
+	snapshot.bats.resize(bats.size());
+	for (unsigned i = 0; i < bats.size(); i++)
+	{
+		RenderSnapshot::BatTransform& bat = snapshot.bats[i];
+		bat.previous_position = bats.getPreviousPosition(i);
+		bat.position = bats.getPosition(i);
+		bat.forward = bats.getForward(i);
+	}
+
+	pickup_manager.getTransforms(snapshot.pickups);
+	snapshot.score = pickup_manager.getScore();
+
+	const Ring* ring_zero = pickup_manager.getRing(0);
+	snapshot.has_ring_zero = ring_zero != nullptr;
+	if (ring_zero != nullptr)
+	{
+		snapshot.ring_zero_position = ring_zero->coordinate_system.position;
+		snapshot.ring_zero_target_position = ring_zero->targetPosition;
+		snapshot.ring_zero_target_node_id = ring_zero->target_node_id;
+		snapshot.ring_zero_path = ring_zero->path;
+	}
+
+	//The search spheres are only drawn from the overview camera
+	if (snapshot.overview_camera_active)
+		snapshot.search_data = world_graph.getMemorizedSearchData();
+	else
+		snapshot.search_data.clear();
+
+	const SimulationLod& bat_lod = bats.getLod();
+	const SimulationLod& ring_lod = pickup_manager.getRingLod();
+	snapshot.lod_entity_count = bat_lod.size() + ring_lod.size();
+	for (unsigned b = 0; b < SimulationLod::BAND_COUNT; b++)
+		snapshot.lod_band_counts[b] = bat_lod.getBandCount(b) + ring_lod.getBandCount(b);
+
+	g_particle_emitter.copyParticleData(snapshot.particle_data, snapshot.particle_origin);
+	snapshot.particle_counters = g_particle_emitter.getCounters();
+}
+
+CoordinateSystem Game::getRenderCamera(const RenderSnapshot& snapshot, float fraction) const
+{
+	return CoordinateSystem::interpolate(snapshot.previous_camera, snapshot.camera, fraction);
+}
+
+void Game::displayBats(const RenderSnapshot& snapshot,
+	const glm::mat4x4& view_matrix,
 	const glm::mat4x4& projection_matrix,
 	const glm::vec3& camera_position)
 {
@@ -422,13 +548,14 @@ void Game::displayBats(const glm::mat4x4& view_matrix,
 	glUniform3fv(uniforms.m_camera_pos, 1, &(camera_position.x));
 
 
-	for (auto const& bat : bats)
+	for (const RenderSnapshot::BatTransform& bat : snapshot.bats)
 	{
+		const Vec3f& forward = bat.forward;
+		const Vec3f position = bat.previous_position + (bat.position - bat.previous_position) * g_render_fraction;
 		glm::mat4 model_matrix = glm::mat4();
-		model_matrix = translate(model_matrix, glm::vec3(bat.coordinate_system.position));
-		model_matrix = rotate(model_matrix, (float(atan2(bat.coordinate_system.forward.x, bat.coordinate_system.forward.z)) - float(MathHelper::M_PI_2)),
-			glm::vec3(bat.coordinate_system.getUp()));
-		model_matrix = glm::scale(model_matrix, glm::vec3(bat.model_scalar));
+		model_matrix = translate(model_matrix, glm::vec3(position));
+		model_matrix = rotate(model_matrix, (float(atan2(forward.x, forward.z)) - float(MathHelper::M_PI_2)),
+			glm::vec3(0, 1, 0));
 		const glm::mat4 mvp_matrix = projection_matrix * view_matrix * model_matrix;
 
 		glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
@@ -438,30 +565,35 @@ void Game::displayBats(const glm::mat4x4& view_matrix,
 
 }
 
-void Game::displayBatsToDepthTexture(const glm::mat4& depth_view_projection_matrix)
+void Game::displayBatsToDepthTexture(const RenderSnapshot& snapshot, const glm::mat4& depth_view_projection_matrix)
 {
-	MeshWithShader mesh = bat_model.getMesh(0, 0);
-
-	for (auto const& bat : bats)
+	const unsigned int mat_count = bat_model.getMaterialCount();
+	for (const RenderSnapshot::BatTransform& bat : snapshot.bats)
 	{
+		const Vec3f& forward = bat.forward;
+		const Vec3f position = bat.previous_position + (bat.position - bat.previous_position) * g_render_fraction;
 		glm::mat4 model_matrix = glm::mat4();
-		model_matrix = translate(model_matrix, glm::vec3(bat.coordinate_system.position));
-		model_matrix = rotate(model_matrix, (float(atan2(bat.coordinate_system.forward.x, bat.coordinate_system.forward.z)) - float(MathHelper::M_PI_2)),
-			glm::vec3(bat.coordinate_system.getUp()));
-		model_matrix = glm::scale(model_matrix, glm::vec3(bat.model_scalar));
+		model_matrix = translate(model_matrix, glm::vec3(position));
+		model_matrix = rotate(model_matrix, (float(atan2(forward.x, forward.z)) - float(MathHelper::M_PI_2)),
+			glm::vec3(0, 1, 0));
 
 		glm::mat4x4 depth_mvp = depth_view_projection_matrix * model_matrix;
 		g_depth_texture.setDepthMVP(depth_mvp);
-		mesh.draw();
+		for (unsigned int j = 0; j < mat_count; j++)
+		{
+			const unsigned int mesh_count = bat_model.getMeshCount(j);
+			for (unsigned int k = 0; k < mesh_count; k++)
+				bat_model.getMesh(j, k).draw();
+		}
 	}
 }
 
 
-void Game::displayMovementGraph(const glm::mat4x4& view_matrix,
+void Game::displayMovementGraph(const RenderSnapshot& snapshot, const glm::mat4x4& view_matrix,
 	const glm::mat4x4& projection_matrix) const
 {
 
-	if (active_camera == &overview_camera)
+	if (snapshot.overview_camera_active)
 		glDisable(GL_DEPTH_TEST);
 
 	glm::mat4 vp = projection_matrix * view_matrix;
@@ -471,20 +603,21 @@ void Game::displayMovementGraph(const glm::mat4x4& view_matrix,
 }
 
 
-void Game::displayRingZeroPath(const glm::mat4& view_matrix,
+void Game::displayRingZeroPath(const RenderSnapshot& snapshot, const glm::mat4& view_matrix,
 	const glm::mat4x4& projection_matrix) const
 {
 	//Draw the Path found in search
-	std::deque<unsigned> path = pickup_manager.rings[0].path;
-	const Ring& ring = pickup_manager.rings[0];
+	//Nothing to draw once ring 0 has been picked up
+	if (!snapshot.has_ring_zero) return;
+	const Path& path = snapshot.ring_zero_path;
 	const glm::vec3 offset(0, 1.0, 0);
 	g_line_renderer.preAllocateLine(path.size() * 2 + 6);
-	g_line_renderer.addLine(glm::vec3(ring.coordinate_system.position), glm::vec3(ring.coordinate_system.position + offset), glm::vec4(1, 1, 1, 1));
-	g_line_renderer.addLine(glm::vec3(ring.coordinate_system.position + offset), glm::vec3(ring.targetPosition + offset), glm::vec4(1, 1, 1, 1));
+	g_line_renderer.addLine(glm::vec3(snapshot.ring_zero_position), glm::vec3(snapshot.ring_zero_position) + offset, glm::vec4(1, 1, 1, 1));
+	g_line_renderer.addLine(glm::vec3(snapshot.ring_zero_position) + offset, glm::vec3(snapshot.ring_zero_target_position) + offset, glm::vec4(1, 1, 1, 1));
 	if (!path.empty())
 	{
 		g_line_renderer.addLine(
-			glm::vec3(world_graph.getNodeList()[ring.target_node_id].position + offset),
+			glm::vec3(world_graph.getNodeList()[snapshot.ring_zero_target_node_id].position + offset),
 			glm::vec3(world_graph.getNodeList()[path[0]].position + offset),
 			glm::vec4(1, 1, 1, 1));
 		for (unsigned i = 0; i < path.size() - 1; i++)
@@ -502,14 +635,15 @@ void Game::displayRingZeroPath(const glm::mat4& view_matrix,
 	glEnable(GL_DEPTH_TEST);
 }
 
-void Game::displayNodeNameplates(const glm::mat4& view_matrix,
+void Game::displayNodeNameplates(const RenderSnapshot& snapshot, const glm::mat4& view_matrix,
 	const glm::mat4x4& projection_matrix) const
 {
 	const glm::vec4 viewport = glm::vec4(0, 0, g_win_width, g_win_height);
 	for (auto& node : world_graph.getNodeList())
 	{
+		if (!world_graph.isNodeActive(node.node_id)) continue;
 		//Dont draw numbers behind camera
-		if (active_camera->getForward().dotProduct(active_camera->getPosition() - node.position) <= 0)
+		if (snapshot.camera.getForward().dotProduct(snapshot.camera.getPosition() - Vec3f(node.position)) <= 0)
 		{
 			glm::mat4 model = glm::mat4();
 			glm::translate(model, glm::vec3(node.position));
@@ -523,15 +657,17 @@ void Game::displayNodeNameplates(const glm::mat4& view_matrix,
 	}
 }
 
-void Game::displaySearchPathSpheres(const glm::mat4& view_matrix,
+void Game::displaySearchPathSpheres(const RenderSnapshot& snapshot, const glm::mat4& view_matrix,
 	const glm::mat4x4& projection_matrix) const
 {
-	const std::vector<NodeSearchData>& search_data = world_graph.getMemorizedSearchData();
+	//Only the nodes visited by the search are memorized
+	const std::vector<MemorizedNode>& visited_nodes = snapshot.search_data;
 	unsigned start_node_id = 0;
 	unsigned end_node_id = 0;
 	unsigned meeting_node_id = 0;
-	if (!search_data.empty())
-		if (active_camera == &overview_camera)
+	bool meeting_node_found = false;
+	if (!visited_nodes.empty())
+		if (snapshot.overview_camera_active)
 		{
 			//Collect data About the search to draw the spheres
 			float highest_priority_start = 0;
@@ -539,41 +675,42 @@ void Game::displaySearchPathSpheres(const glm::mat4& view_matrix,
 			float highest_priority_end = 0;
 			float lowest_priority_end = 99999999.0f;
 
-			for (unsigned i = 0; i < search_data.size(); i++)
+			for (const MemorizedNode& visited_node : visited_nodes)
 			{
-				const SearchData& node_start_data = search_data[i].start;
-				const SearchData& node_end_data = search_data[i].end;
-				if (node_start_data.visited && node_end_data.visited) meeting_node_id = i;
+				const SearchData& node_start_data = visited_node.search_data.start;
+				const SearchData& node_end_data = visited_node.search_data.end;
+				if (node_start_data.visited && node_end_data.visited)
+				{
+					meeting_node_id = visited_node.node_id;
+					meeting_node_found = true;
+					highest_priority_start = node_start_data.priority;
+					highest_priority_end = node_end_data.priority;
+				}
 				if (node_end_data.visited)
 				{
-					if (node_end_data.given_cost == 0) end_node_id = i;
-					highest_priority_end = max(node_end_data.priority, highest_priority_end);
+					if (node_end_data.given_cost == 0) end_node_id = visited_node.node_id;
+					if (!meeting_node_found) highest_priority_end = max(node_end_data.priority, highest_priority_end);
 					lowest_priority_end = min(node_end_data.priority, lowest_priority_end);
 				}
 				if (node_start_data.visited)
 				{
-					if (node_start_data.given_cost == 0) start_node_id = i;
-					highest_priority_start = max(node_start_data.priority, highest_priority_start);
+					if (node_start_data.given_cost == 0) start_node_id = visited_node.node_id;
+					if (!meeting_node_found) highest_priority_start = max(node_start_data.priority, highest_priority_start);
 					lowest_priority_start = min(node_start_data.priority, lowest_priority_start);
 				}
 			}
-			highest_priority_start = search_data[meeting_node_id].start.priority;
-			highest_priority_end = search_data[meeting_node_id].end.priority;
 			//Loops through spheres on path and draws them with certaian color based on priority
-			for (unsigned i = 0; i < search_data.size(); i++)
+			for (const MemorizedNode& visited_node : visited_nodes)
 			{
-				const SearchData& node_data_start = search_data[i].start;
-				const SearchData& node_data_end = search_data[i].end;
-
-				//If not visited dont draw them
-				if (!node_data_end.visited && !node_data_start.visited)
-					continue;
+				const unsigned i = visited_node.node_id;
+				const SearchData& node_data_start = visited_node.search_data.start;
+				const SearchData& node_data_end = visited_node.search_data.end;
 
 				Vector3 color;
 				float scale = 1.5;
 
 				//If on path make them bigger
-				if (i == start_node_id || i == end_node_id || i == meeting_node_id)
+				if (i == start_node_id || i == end_node_id || (meeting_node_found && i == meeting_node_id))
 					scale = 3.0;
 
 
@@ -590,7 +727,7 @@ void Game::displaySearchPathSpheres(const glm::mat4& view_matrix,
 				//Set thses colors for distinguished nodes
 				if (i == start_node_id) color = Vector3(0, 1, 1);
 				if (i == end_node_id)color = Vector3(1, 1, 1);
-				if (i == meeting_node_id) color = Vector3(0.6, 0, 1);
+				if (meeting_node_found && i == meeting_node_id) color = Vector3(0.6, 0, 1);
 
 				//Draw the sphere
 				const Vector3& pos = world_graph.getNodeList()[i].position;
@@ -605,7 +742,7 @@ void Game::displaySearchPathSpheres(const glm::mat4& view_matrix,
 }
 
 
-void Game::renderToDepthTexture(glm::mat4& depth_vp)
+void Game::renderToDepthTexture(const RenderSnapshot& snapshot, const CoordinateSystem& render_player, glm::mat4& depth_vp)
 {
 
 	g_depth_texture.startRenderToDepthTexture();
@@ -614,8 +751,7 @@ void Game::renderToDepthTexture(glm::mat4& depth_vp)
 	glPolygonOffset(g_polygon_offset_factor, g_polygon_offset_units);
 
 
-	const Vector3& player_forward = player.coordinate_system.getForward();
-	const Vector3&player_position = player.coordinate_system.getPosition();
+	const Vec3f& player_position = render_player.getPosition();
 
 	//Update the shadow box to re orient the location of the shadow view
 	shadow_box.update();
@@ -628,7 +764,7 @@ void Game::renderToDepthTexture(glm::mat4& depth_vp)
 	depthProjectionMatrix[3][3] = 1;
 
 
-	const Vector3 center = -shadow_box.getCenter();
+	const Vec3f center = -shadow_box.getCenter();
 
 	//Calculate the light view matrix which is what the light views
 	const Vector3 light_inverse_dir = -SUN_DIR.getNormalized();
@@ -646,16 +782,13 @@ void Game::renderToDepthTexture(glm::mat4& depth_vp)
 
 	depth_vp = depthProjectionMatrix * light_view_matrix;
 
-	player.drawToDepth(depth_vp);
+	player.drawToDepth(render_player, snapshot.player_pose, depth_vp);
 
-	for (auto && bat : bats)
-	{
-		bat.drawToDepth(depth_vp);
-	}
+	displayBatsToDepthTexture(snapshot, depth_vp);
 
 	//Draw the world to the depth texture
 	world.drawDepthOptimized(player_position, shadow_box.getShadowFadeDistance(), depth_vp);
-	pickup_manager.drawDepthOptimized(player_position, shadow_box.getShadowFadeDistance(), depth_vp);
+	pickup_manager.drawDepthOptimized(snapshot.pickups, g_render_fraction, player_position, shadow_box.getShadowFadeDistance(), depth_vp);
 
 	glDisable(GL_POLYGON_OFFSET_FILL);
 }
@@ -667,9 +800,9 @@ void Game::destroyIntoNextWorld()
 	bats.clear();
 	world.destroy();
 	world_graph.destroy();
-	world.init(WORLD_FOLDER + levels[level++]);
-	world_graph.init(world.disks);
-	initWorldGraphPointLine();
+	world.init(WORLD_FOLDER + levels[level]);
+	g_particle_emitter.setCollisionWorld(&world);
+	initWorldGraph(levels[level++]);
 	if (level >= levels.size()) level = 0;
 	pickup_manager.destroy();
 	pickup_manager.init(world, world_graph, rod_model, ring_model);
@@ -681,9 +814,9 @@ void Game::destroyIntoNextWorld()
 
 void Game::playerAccelerateForward(float delta_time)
 {
-	const Vector3& pos = player.coordinate_system.getPosition();
-	const Vector3& forward = player.coordinate_system.getForward();
-	Vector3 accel = forward * PLAYER_ACCEL_FORWARD * world.getAccelFactorAtPosition(float(pos.x), float(pos.z));
+	const Vec3f& pos = player.coordinate_system.getPosition();
+	const Vec3f& forward = player.coordinate_system.getForward();
+	Vec3f accel = forward * PLAYER_ACCEL_FORWARD * world.getAccelFactorAtPosition(pos.x, pos.z);
 	accel *= delta_time;
 	player.addAcceleration(accel);
 
@@ -691,27 +824,27 @@ void Game::playerAccelerateForward(float delta_time)
 
 void Game::playerAccelerateBackward(float delta_time)
 {
-	const Vector3& pos = player.coordinate_system.getPosition();
-	const Vector3& backward = -player.coordinate_system.getForward();
-	Vector3 accel = backward * PLAYER_ACCEL * world.getSpeedFactorAtPosition(float(pos.x), float(pos.z));
+	const Vec3f& pos = player.coordinate_system.getPosition();
+	const Vec3f& backward = -player.coordinate_system.getForward();
+	Vec3f accel = backward * PLAYER_ACCEL * world.getSpeedFactorAtPosition(pos.x, pos.z);
 	accel *= delta_time;
 	player.addAcceleration(accel);
 }
 
 void Game::playerAccelerateLeft(float delta_time)
 {
-	const Vector3& pos = player.coordinate_system.getPosition();
-	const Vector3& left = -player.coordinate_system.getRight();
-	Vector3 accel = left * PLAYER_ACCEL * world.getSpeedFactorAtPosition(float(pos.x), float(pos.z));
+	const Vec3f& pos = player.coordinate_system.getPosition();
+	const Vec3f& left = -player.coordinate_system.getRight();
+	Vec3f accel = left * PLAYER_ACCEL * world.getSpeedFactorAtPosition(pos.x, pos.z);
 	accel *= delta_time;
 	player.addAcceleration(accel);
 }
 
 void Game::playerAccelerateRight(float delta_time)
 {
-	const Vector3& pos = player.coordinate_system.getPosition();
-	const Vector3& right = player.coordinate_system.getRight();
-	Vector3 accel = right * PLAYER_ACCEL * world.getSpeedFactorAtPosition(float(pos.x), float(pos.z));
+	const Vec3f& pos = player.coordinate_system.getPosition();
+	const Vec3f& right = player.coordinate_system.getRight();
+	Vec3f accel = right * PLAYER_ACCEL * world.getSpeedFactorAtPosition(pos.x, pos.z);
 	accel *= delta_time;
 	player.addAcceleration(accel);
 }
@@ -731,25 +864,39 @@ void Game::playerTurnRight(float delta_time)
 
 void Game::batPlayerCollisions()
 {
-	for (auto && bat : bats)
+	//Only bats in the grid cells around the player are checked
+	const Vec3f player_position = player.getPosition();
+	bat_candidates.clear();
+	bats.findNear(player_position.x, player_position.z, player.getRadius(), bat_candidates);
+
+	//Candidates are checked in parallel and the hits applied afterwards in bat order
+	bat_hits.init(g_job_system.getThreadCount());
+	g_job_system.parallelFor(bat_candidates.size(), BAT_COLLISION_BATCH_SIZE, [this](unsigned begin, unsigned end)
 	{
-		if (bat.ignore_timer > 0) continue;
-		//Collision with player
-		if (Collision::cylinderIntersection(bat.coordinate_system.position, bat.radius, bat.half_height,
-			player.coordinate_system.position, player.getRadius(), player.getHalfHeight()))
+		const unsigned thread_index = JobSystem::getThreadIndex();
+		for (unsigned c = begin; c < end; c++)
 		{
-			player.hitByBat(bat.velocity);
-
-			bat.velocity = Vector3(0, bat.S_MAX, 0);
+			const unsigned i = bat_candidates[c];
+			if (bats.isIgnoringPlayer(i)) continue;
+			//Collision with player
+			if (Collision::cylinderIntersection(bats.getPosition(i), bats.radius, bats.half_height,
+				player.coordinate_system.position, player.getRadius(), player.getHalfHeight()))
+			{
+				bat_hits.push(thread_index, i, i);
+			}
+		}
+	});
 
-			bat.ignore_timer = 1.0f;
+	for (unsigned i : bat_hits.merge())
+	{
+		player.hitByBat(bats.getVelocity(i));
 
-			glm::vec3 pos(player.getPosition().x, player.getPosition().y + player.getHalfHeight(), player.getPosition().z);
-			g_particle_emitter.addEffect(500,pos,0.03f,glm::vec4(1,1,0.3,1),600,Particle_Pattern::Random,2.0f,0.0f);
+		bats.hitPlayer(i);
 
-		}
+		glm::vec3 pos(player.getPosition().x, player.getPosition().y + player.getHalfHeight(), player.getPosition().z);
+		//Hits always show, so they can use the budget pickups leave free
+		g_particle_emitter.addEffect(500,pos,0.03f,glm::vec4(1,1,0.3,1),600,Particle_Pattern::Random,2.0f,0.0f,Particle_Priority::High);
 	}
-
 }
 
 
@@ -5,7 +5,10 @@
 #include "Player.h"
 #include "MovementGraph.h"
 #include "LineRenderer.h"
-#include "Bat.h"
+#include "BatSwarm.h"
+#include "CommandBuffer.h"
+
+struct RenderSnapshot;
 
 /**
  *	Overarching Game class
@@ -22,6 +25,10 @@ private:
 	const std::string SKYBOX_FILENAME = "assets/Models/Skybox.obj";
 	const std::string BAT_FILENAME = "assets/Models/BrownBat.obj";
 	const std::string WORLD_FOLDER = "assets/Worlds/";
+	const std::string GRAPH_CACHE_FOLDER = "assets/GraphCache/";
+
+	//Bats checked against the player in each collision job
+	const unsigned BAT_COLLISION_BATCH_SIZE = 256;
 
 	//Game object models for drawing
 	ModelWithShader skybox_model;
@@ -34,12 +41,27 @@ private:
 	MovementGraph world_graph;
 	Player player;
 	PickupManager pickup_manager;
-	std::vector<Bat> bats;
+	BatSwarm bats;
+	//Bats that hit the player this update, recorded by the collision jobs
+	CommandBuffer<unsigned> bat_hits;
+	//Bats near the player found in the bat grid this update
+	std::vector<unsigned> bat_candidates;
 
 	//Camerars for behind the player and overview
 	CoordinateSystem player_camera;
 	CoordinateSystem overview_camera;
 	CoordinateSystem* active_camera = &player_camera;
+	//The cameras before the last update, drawing blends from them to the cameras
+	CoordinateSystem previous_player_camera;
+	CoordinateSystem previous_overview_camera;
+
+	//The camera drawn this frame, blended from a snapshot
+	//The shadow box follows it through the pointer
+	CoordinateSystem render_camera;
+	CoordinateSystem* render_camera_pointer = &render_camera;
+
+	//The update of the particles in the GPU buffer
+	long long uploaded_update_count = -1;
 
 	//For Rotating around player with the camera
 	bool camera_float = false;
@@ -66,11 +88,16 @@ public:
 	//Empty Constructor, Init must be used to initialize game
 	Game() = default;
 
+	//Loads the movement graph for a world file from the graph cache or builds it
+	//and rebuilds the movement graph's line data
+	void initWorldGraph(const std::string& world_file_name);
 	void initWorldGraphPointLine();
 	void initBats();
 	//Initialize The models, player,world, pickup manager, shadow box
 	//lighting and camera.
-	void init();
+	//The world file is loaded from the worlds folder
+	//When headless the models, shadow box and lighting are skipped
+	void init(const std::string& world_file_name = "Basic.txt");
 
 	//Update the game based on inputs using fixed delta time
 	//Updates player and pickups
@@ -79,21 +106,28 @@ public:
 	//Updates animations for the player using variable delta time
 	void updateAnimations(double delta_time);
 
+	//Copies everything display draws that changes in update into a snapshot
+	void fillSnapshot(RenderSnapshot& snapshot) const;
+
+	//Returns a hash of the player, bats, rings, rods and score
+	//The same world, seed and inputs give the same hash on any number of threads
+	unsigned long long getStateHash() const;
+
 	//Displays weighted lines with different colors between each
 	//node in the movement graph
-	void displayMovementGraph(const glm::mat4x4& view_matrix,
+	void displayMovementGraph(const RenderSnapshot& snapshot, const glm::mat4x4& view_matrix,
 		const glm::mat4x4& projection_matrix) const;
 
-	//Render the game
+	//Render the game from a snapshot, so the game can be updated on another thread at the same time
 	//Draws everything to the depth texture
 	//Then uses Depth texture to draw everything with shadows to screen
 	//Draws the UI
-	void display();
+	void display(const RenderSnapshot& snapshot);
 
-	void displayBats(const glm::mat4x4& view_matrix,
+	void displayBats(const RenderSnapshot& snapshot, const glm::mat4x4& view_matrix,
 		const glm::mat4x4& projection_matrix, const glm::vec3& camera_position);
 
-	void displayBatsToDepthTexture(const glm::mat4& depth_view_projection_matrix);
+	void displayBatsToDepthTexture(const RenderSnapshot& snapshot, const glm::mat4& depth_view_projection_matrix);
 
 	//Destory the current world and loads the next one from the worlds folder
 	//Rebuilds the movement graph and world and resets player position and score
@@ -102,17 +136,20 @@ public:
 
 
 private:
+	//Returns the snapshot's camera a fraction of the way through the update it was taken after
+	CoordinateSystem getRenderCamera(const RenderSnapshot& snapshot, float fraction) const;
+
 	//Draws a line btween each node on the path for ring 0
-	void displayRingZeroPath(const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
+	void displayRingZeroPath(const RenderSnapshot& snapshot, const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
 
 	//Draws the id number of the node as text above each node for debugging purposes
-	void displayNodeNameplates(const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
+	void displayNodeNameplates(const RenderSnapshot& snapshot, const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
 
 	//Draws the Spheres with fading colors based on the search data obtained from the movement graph searches
-	void displaySearchPathSpheres(const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
+	void displaySearchPathSpheres(const RenderSnapshot& snapshot, const glm::mat4& view_matrix, const glm::mat4x4& projection_matrix) const;
 
 	//Render game to depth texture for shadow mapping
-	void renderToDepthTexture(glm::mat4& depth_vp);
+	void renderToDepthTexture(const RenderSnapshot& snapshot, const CoordinateSystem& render_player, glm::mat4& depth_vp);
 
 	//Player functions to move the player
 	void playerAccelerateForward(float delta_time);
@@ -5,6 +5,8 @@
 #include "DepthTexture.h"
 #include "PerformanceCounter.h"
 #include "ParticleEmitter.h"
+#include "JobSystem.h"
+#include "Vec3f.h"
 
 
 //Global External constants available to all files
@@ -43,11 +45,11 @@ const double TIME_SCALES[TIME_SCALE_COUNT + 1] = { 50.0, 20.0, 10.0, 4.0, 2.0, 1
 //Initial Camera/Player vectors
 //Sun Dir is the direction the sun is on the skybox
 const Vector3 SUN_DIR(0.34, 0.83, 0.44);
-const Vector3 CAMERA_INIT_FORWARD = Vector3(-1, 0, -1).getNormalized();
+const Vec3f CAMERA_INIT_FORWARD = Vec3f(-1, 0, -1).getNormalized();
 
-const Vector3 PLAYER_CAMERA_OFFSET = Vector3(0, 1.55f, 0);
-const Vector3 PLAYER_CAMERA_INIT_POS = PLAYER_CAMERA_OFFSET;
-const Vector3 OVERVIEW_CAMERA_INIT_POS = Vector3(100.f, 200.0f, 10.0f);
+const Vec3f PLAYER_CAMERA_OFFSET = Vec3f(0, 1.55f, 0);
+const Vec3f PLAYER_CAMERA_INIT_POS = PLAYER_CAMERA_OFFSET;
+const Vec3f OVERVIEW_CAMERA_INIT_POS = Vec3f(100.f, 200.0f, 10.0f);
 
 //Players turns 3 degrees per second
 const float TURNING_DEGREES = 3.0f;
@@ -71,6 +73,9 @@ DepthTexture g_depth_texture;
 
 ParticleEmitter g_particle_emitter;
 
+//Worker threads for the parallel parts of the update
+JobSystem g_job_system;
+
 //High precision timer for calculated delta time
 PerformanceCounter g_time_counter;
 
@@ -78,13 +83,15 @@ PerformanceCounter g_time_counter;
 //***************************************
 double g_delta_time;
 double g_update_lag = 0;
-long long g_update_count = 0;
+float g_render_fraction = 1.0f;
+std::atomic<long long> g_update_count{ 0 };
 long long g_display_count = 0;
 long long g_elapsed_time_nanoseconds = 0;
 double g_update_fps = FPS_UPDATE;
 double g_display_fps = FPS_DISPLAY;
 
 bool g_full_screen = false;
+bool g_headless = false;
 bool g_fullscreen_toggle_allowed = true;
 bool g_key_pressed[KEY_COUNT] = { false };
 
@@ -102,6 +109,11 @@ int g_mouse_locked_x = 0, g_mouse_locked_y = 0;
 int g_time_scale_id = 5;
 double g_time_scale = TIME_SCALES[g_time_scale_id];
 
+//The input from the window, copied by the simulation thread before each update
+bool g_window_key_pressed[KEY_COUNT] = { false };
+int g_window_mouse_dx = 0, g_window_mouse_dy = 0;
+int g_window_time_scale_id = g_time_scale_id;
+
 glm::mat4 g_projection_matrix = glm::mat4();
 
 float g_polygon_offset_factor = 2.0f;
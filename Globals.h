@@ -1,6 +1,7 @@
 #pragma once
 
 #define global_extern extern
+#include <atomic>
 #include <lib/glm/mat4x4.hpp>
 #include "SphereRenderer.h"
 
@@ -15,6 +16,8 @@ class DepthTexture;
 class LineRenderer;
 class PerformanceCounter;
 class ParticleEmitter;
+class JobSystem;
+class Vec3f;
 
 using ObjLibrary::Vector3;
 
@@ -52,11 +55,11 @@ global_extern const double TIME_SCALE_FACTOR;
 //Initial Camera/Player vectors
 //Sun Dir is the direction the sun is on the skybox
 global_extern const Vector3 SUN_DIR;
-global_extern const Vector3 CAMERA_INIT_FORWARD;
+global_extern const Vec3f CAMERA_INIT_FORWARD;
 
-global_extern const Vector3 PLAYER_CAMERA_OFFSET;
-global_extern const Vector3 PLAYER_CAMERA_INIT_POS;
-global_extern const Vector3 OVERVIEW_CAMERA_INIT_POS;
+global_extern const Vec3f PLAYER_CAMERA_OFFSET;
+global_extern const Vec3f PLAYER_CAMERA_INIT_POS;
+global_extern const Vec3f OVERVIEW_CAMERA_INIT_POS;
 
 //Players turns 3 degrees per second
 global_extern const float TURNING_DEGREES;
@@ -71,6 +74,10 @@ global_extern const int TIME_SCALE_COUNT;
 //***************************************
 
 global_extern bool g_full_screen;
+
+//True when running without a window or OpenGL context
+//GPU resources are not created and nothing is drawn, only the simulation runs
+global_extern bool g_headless;
 global_extern bool g_fullscreen_toggle_allowed;
 
 //Windows width and height
@@ -84,6 +91,9 @@ global_extern SphereRenderer g_sphere_renderer;
 
 global_extern ParticleEmitter g_particle_emitter;
 
+//Worker threads for the parallel parts of the update
+global_extern JobSystem g_job_system;
+
 //Texture used for shadow mapping
 global_extern DepthTexture g_depth_texture;
 
@@ -100,8 +110,13 @@ global_extern double g_delta_time;
 //Accumulated delta build up that needs to be processed in update
 global_extern double g_update_lag;
 
+//How far the display is from the last update to the next, from 0 to 1
+//Objects are drawn this far between their previous and current transforms
+global_extern float g_render_fraction;
+
 //Number of times update has be called
-global_extern long long g_update_count;
+//Counted on the simulation thread and read by the display thread
+global_extern std::atomic<long long> g_update_count;
 
 //Number of times display has been called
 global_extern long long g_display_count;
@@ -112,7 +127,7 @@ global_extern long long g_elapsed_time_nanoseconds;
 global_extern double g_update_fps;
 global_extern double g_display_fps;
 
-//Array indicating which keys are currently pressed
+//Array indicating which keys are pressed for the current update
 global_extern bool g_key_pressed[];
 
 //Current mouse location
@@ -121,6 +136,13 @@ global_extern int g_mouse_x, g_mouse_y;
 //The change in mouse since the last time the mouse data was processed
 global_extern int g_mouse_dx, g_mouse_dy;
 
+//The keys, mouse movement and time scale from the window, set by the GLUT callbacks holding the input lock
+//The simulation thread copies them into g_key_pressed, g_mouse_dx, g_mouse_dy and the time scale
+//before each update so the update runs without the lock
+global_extern bool g_window_key_pressed[];
+global_extern int g_window_mouse_dx, g_window_mouse_dy;
+global_extern int g_window_time_scale_id;
+
 //The location of the mouse when the mouse was pressed. 
 //This is used to snap the mouse back to its position so it doesn't leave the window
 global_extern int g_mouse_locked_x, g_mouse_locked_y;
@@ -0,0 +1,171 @@
+#include "GraphCheck.h"
+#include <algorithm>
+#include <cmath>
+#include "World.h"
+
+bool GraphCheck::run(const World& world, const std::string& world_name, unsigned disk_id)
+{
+	this->world_name = world_name;
+	disks_checked = 0;
+	comparisons = 0;
+	failures.clear();
+	failure_count = 0;
+
+	//The full build is kept to compare against, the other graph has disks removed and added back
+	MovementGraph full_graph;
+	full_graph.init(world.disks);
+	MovementGraph graph;
+	graph.init(world.disks);
+
+	if (disk_id != NO_DISK_FOUND)
+	{
+		checkDisk(world, graph, full_graph, disk_id);
+		return failure_count == 0;
+	}
+
+	//The same graph is used for every disk so ids that are freed and reused many times are checked as well
+	for (unsigned i = 0; i < world.disks.size(); i++)
+		checkDisk(world, graph, full_graph, i);
+	return failure_count == 0;
+}
+
+void GraphCheck::printReport(std::ostream& out) const
+{
+	out << "Graph check: " << world_name << ", " << disks_checked << " disks removed and added back, "
+		<< comparisons << " nodes compared" << std::endl;
+	for (const std::string& failure : failures)
+		out << "  " << failure << std::endl;
+	if (failure_count > failures.size())
+		out << "  and " << failure_count - failures.size() << " more" << std::endl;
+	out << (failure_count == 0 ? "Passed" : "Failed") << std::endl;
+}
+
+void GraphCheck::checkDisk(const World& world, MovementGraph& graph, const MovementGraph& full_graph, unsigned disk_id)
+{
+	const std::string step = "disk " + std::to_string(disk_id);
+	const size_t node_list_size = graph.getNodeList().size();
+	const std::vector<unsigned> start_ids = graph.getActiveNodeIds();
+	//The nodes that are not on or paired with the disk keep their ids through both steps
+	const GraphInfo kept_info = describe(graph, disk_id);
+
+	graph.removeDisk(disk_id);
+	const GraphInfo removed_info = describe(graph, NO_DISK_FOUND);
+	compare(describe(full_graph, disk_id), removed_info, step + " removed");
+	compareIds(kept_info, removed_info, step + " removed");
+	compareCounts(graph, removed_info, step + " removed");
+
+	graph.addDisk(world.disks, disk_id);
+	const GraphInfo added_info = describe(graph, NO_DISK_FOUND);
+	compare(describe(full_graph, NO_DISK_FOUND), added_info, step + " added back");
+	compareIds(kept_info, added_info, step + " added back");
+	compareCounts(graph, added_info, step + " added back");
+
+	//Adding back as many nodes as were removed takes every freed id, so the node list does not grow
+	if (graph.getNodeList().size() != node_list_size || graph.getActiveNodeIds() != start_ids)
+		addFailure(step + " added back: the freed node ids were not all reused");
+	disks_checked++;
+}
+
+GraphCheck::GraphInfo GraphCheck::describe(const MovementGraph& graph, unsigned excluded_disk_id)
+{
+	const std::vector<Node>& node_list = graph.getNodeList();
+
+	//The disk of the node each node is paired with, from its one link to another disk
+	std::vector<unsigned> pair_disk_ids(node_list.size(), NO_DISK_FOUND);
+	for (const unsigned node_id : graph.getActiveNodeIds())
+	{
+		for (const NodeLink& link : node_list[node_id].node_links)
+		{
+			if (link.disk_id != node_list[node_id].disk_id)
+				pair_disk_ids[node_id] = link.disk_id;
+		}
+	}
+
+	GraphInfo info;
+	for (const unsigned node_id : graph.getActiveNodeIds())
+	{
+		const Node& node = node_list[node_id];
+		if (node.disk_id == excluded_disk_id || pair_disk_ids[node_id] == excluded_disk_id) continue;
+
+		NodeInfo& node_info = info[NodeKey(node.disk_id, pair_disk_ids[node_id])];
+		node_info.node_id = node_id;
+		node_info.position = node.position;
+		for (const NodeLink& link : node.node_links)
+		{
+			const NodeKey dest_key(node_list[link.dest_node_id].disk_id, pair_disk_ids[link.dest_node_id]);
+			if (dest_key.first == excluded_disk_id || dest_key.second == excluded_disk_id) continue;
+			node_info.link_weights[dest_key] = link.weight;
+		}
+	}
+	return info;
+}
+
+void GraphCheck::compare(const GraphInfo& expected, const GraphInfo& actual, const std::string& step)
+{
+	if (expected.size() != actual.size())
+		addFailure(step + ": " + std::to_string(actual.size()) + " nodes, the full build has " + std::to_string(expected.size()));
+
+	for (const auto& expected_node : expected)
+	{
+		const NodeKey& key = expected_node.first;
+		const std::string node_name = "node on disk " + std::to_string(key.first) + " paired with disk " + std::to_string(key.second);
+		const auto actual_node = actual.find(key);
+		if (actual_node == actual.end())
+		{
+			addFailure(step + ": missing the " + node_name);
+			continue;
+		}
+		comparisons++;
+
+		const NodeInfo& expected_info = expected_node.second;
+		const NodeInfo& actual_info = actual_node->second;
+		if ((expected_info.position - actual_info.position).getNorm() > TOLERANCE)
+			addFailure(step + ": the " + node_name + " moved");
+		if (expected_info.link_weights.size() != actual_info.link_weights.size())
+			addFailure(step + ": the " + node_name + " has " + std::to_string(actual_info.link_weights.size())
+				+ " links, the full build has " + std::to_string(expected_info.link_weights.size()));
+
+		for (const auto& expected_link : expected_info.link_weights)
+		{
+			const auto actual_link = actual_info.link_weights.find(expected_link.first);
+			if (actual_link == actual_info.link_weights.end())
+				addFailure(step + ": the " + node_name + " is missing its link to disk " + std::to_string(expected_link.first.first));
+			else if (std::fabs(actual_link->second - expected_link.second) > TOLERANCE * std::max(1.0f, expected_link.second))
+				addFailure(step + ": the " + node_name + " has a link weight of " + std::to_string(actual_link->second)
+					+ ", the full build has " + std::to_string(expected_link.second));
+		}
+	}
+}
+
+void GraphCheck::compareIds(const GraphInfo& before, const GraphInfo& after, const std::string& step)
+{
+	for (const auto& after_node : after)
+	{
+		const auto before_node = before.find(after_node.first);
+		if (before_node != before.end() && before_node->second.node_id != after_node.second.node_id)
+			addFailure(step + ": node " + std::to_string(before_node->second.node_id) + " changed id to "
+				+ std::to_string(after_node.second.node_id));
+	}
+}
+
+void GraphCheck::compareCounts(const MovementGraph& graph, const GraphInfo& actual, const std::string& step)
+{
+	//Each link is stored on both of its nodes
+	unsigned link_ends = 0;
+	for (const auto& node : actual)
+		link_ends += node.second.link_weights.size();
+
+	if (graph.getNodeCount() != actual.size() || graph.getActiveNodeIds().size() != actual.size())
+		addFailure(step + ": the node count is " + std::to_string(graph.getNodeCount()) + " with "
+			+ std::to_string(actual.size()) + " active nodes");
+	if (graph.getNodeLinkCount() * 2 != link_ends)
+		addFailure(step + ": the link count is " + std::to_string(graph.getNodeLinkCount()) + " with "
+			+ std::to_string(link_ends / 2) + " links");
+}
+
+void GraphCheck::addFailure(const std::string& failure)
+{
+	if (failures.size() < MAX_PRINTED_FAILURES)
+		failures.push_back(failure);
+	failure_count++;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include "MovementGraph.h"
+
+class World;
+
+//Checks that removing and adding disks leaves the movement graph the same as building it again
+//Each disk checked is removed from a graph built with init and then added back. After the removal
+//the graph is compared to the full build without the disk's nodes and the nodes paired with them,
+//and after adding it back to the full build itself. Node ids differ between the two graphs,
+//so nodes are matched by their disk and the disk of the node they are paired with
+class GraphCheck
+{
+private:
+	//The most failures that are written, the rest are only counted
+	static const unsigned MAX_PRINTED_FAILURES = 20;
+	//How far positions and weights may be from the full build, they are calculated the same way
+	const float TOLERANCE = 0.0001f;
+
+	//The disk of a node and the disk of the node it is paired with, which is unique in the graph
+	typedef std::pair<unsigned, unsigned> NodeKey;
+
+	//A node of a graph with its links keyed the same way
+	struct NodeInfo
+	{
+		unsigned node_id{};
+		Vector3 position;
+		std::map<NodeKey, float> link_weights;
+	};
+	typedef std::map<NodeKey, NodeInfo> GraphInfo;
+
+	std::string world_name;
+	unsigned disks_checked{};
+	unsigned comparisons{};
+	std::vector<std::string> failures;
+	unsigned failure_count{};
+
+public:
+	GraphCheck() = default;
+
+	//Builds the graph of the world and checks removing and adding back one disk
+	//NO_DISK_FOUND checks each of the disks in turn on the same graph. Returns true if everything matched
+	bool run(const World& world, const std::string& world_name, unsigned disk_id);
+
+	//Writes how many disks were checked and the failures found
+	void printReport(std::ostream& out) const;
+
+private:
+	//Removes the disk from the graph and adds it back, comparing against the full build after each
+	void checkDisk(const World& world, MovementGraph& graph, const MovementGraph& full_graph, unsigned disk_id);
+
+	//Returns the active nodes of the graph, leaving out the nodes on or paired with the excluded disk
+	static GraphInfo describe(const MovementGraph& graph, unsigned excluded_disk_id);
+
+	//Compares a graph with the expected one and records a failure for each difference
+	void compare(const GraphInfo& expected, const GraphInfo& actual, const std::string& step);
+
+	//Records a failure for every node in both graphs whose id changed
+	void compareIds(const GraphInfo& before, const GraphInfo& after, const std::string& step);
+
+	//Checks the graph's node and link counts agree with its nodes
+	void compareCounts(const MovementGraph& graph, const GraphInfo& actual, const std::string& step);
+
+	void addFailure(const std::string& failure);
+};
@@ -0,0 +1,205 @@
+#include "HeadlessRunner.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "Game.h"
+#include "InputLog.h"
+#include "Globals.h"
+#include "PerformanceCounter.h"
+
+bool HeadlessRunner::loadScript(const std::string& filename)
+{
+	std::ifstream input_file(filename.c_str());
+	if (!input_file.is_open())
+	{
+		std::cerr << "Error: Input script \"" << filename << "\" does not exist" << std::endl;
+		return false;
+	}
+
+	events.clear();
+	std::string line;
+	unsigned line_number = 0;
+	while (getline(input_file, line))
+	{
+		line_number++;
+		std::istringstream tokens(line);
+		std::string first;
+		if (!(tokens >> first) || first[0] == '#') continue;
+
+		InputEvent event{};
+		event.tick = unsigned(atoi(first.c_str()));
+		std::string type;
+		tokens >> type;
+
+		bool valid = true;
+		if (type == "mouse")
+		{
+			event.type = Input_Type::MOUSE_MOVE;
+			valid = bool(tokens >> event.mouse_dx >> event.mouse_dy);
+		} else if (type == "down" || type == "up")
+		{
+			event.type = type == "down" ? Input_Type::KEY_DOWN : Input_Type::KEY_UP;
+			std::string key_name;
+			valid = (tokens >> key_name) && parseKey(key_name, event.key);
+		} else
+			valid = false;
+
+		if (!valid)
+		{
+			std::cerr << "Error: Input script \"" << filename << "\" line " << line_number << " is invalid" << std::endl;
+			return false;
+		}
+		events.push_back(event);
+	}
+
+	//Inputs of the same tick keep the order they were written in
+	std::stable_sort(events.begin(), events.end(),
+		[](const InputEvent& a, const InputEvent& b) { return a.tick < b.tick; });
+	return true;
+}
+
+void HeadlessRunner::useDefaultScript(unsigned tick_count)
+{
+	//One loop of the script, run forward the whole loop while turning, jumping,
+	//strafing and looking around with the mouse
+	const unsigned LOOP_TICKS = 600;
+
+	events.clear();
+	for (unsigned start = 0; start < tick_count; start += LOOP_TICKS)
+	{
+		events.push_back(InputEvent{ start, Input_Type::KEY_DOWN, 'W', 0, 0 });
+		events.push_back(InputEvent{ start + 90, Input_Type::KEY_DOWN, KEY_LEFT_ARROW, 0, 0 });
+		events.push_back(InputEvent{ start + 150, Input_Type::KEY_UP, KEY_LEFT_ARROW, 0, 0 });
+		events.push_back(InputEvent{ start + 200, Input_Type::KEY_DOWN, ' ', 0, 0 });
+		events.push_back(InputEvent{ start + 202, Input_Type::KEY_UP, ' ', 0, 0 });
+		events.push_back(InputEvent{ start + 260, Input_Type::KEY_DOWN, 'D', 0, 0 });
+		events.push_back(InputEvent{ start + 320, Input_Type::KEY_UP, 'D', 0, 0 });
+		events.push_back(InputEvent{ start + 360, Input_Type::KEY_DOWN, MOUSE_LEFT, 0, 0 });
+		for (unsigned t = 370; t < 420; t += 10)
+			events.push_back(InputEvent{ start + t, Input_Type::MOUSE_MOVE, 0, 6, 1 });
+		events.push_back(InputEvent{ start + 420, Input_Type::KEY_UP, MOUSE_LEFT, 0, 0 });
+		events.push_back(InputEvent{ start + 540, Input_Type::KEY_DOWN, KEY_RIGHT_ARROW, 0, 0 });
+		events.push_back(InputEvent{ start + 570, Input_Type::KEY_UP, KEY_RIGHT_ARROW, 0, 0 });
+		events.push_back(InputEvent{ start + 599, Input_Type::KEY_UP, 'W', 0, 0 });
+	}
+}
+
+void HeadlessRunner::run(Game& game, unsigned tick_count)
+{
+	std::fill(g_key_pressed, g_key_pressed + KEY_COUNT, false);
+	g_mouse_dx = 0;
+	g_mouse_dy = 0;
+
+	tick_times.clear();
+	tick_times.reserve(tick_count);
+
+	PerformanceCounter counter;
+	unsigned next_event = 0;
+	for (unsigned tick = 0; tick < tick_count; tick++)
+	{
+		next_event = applyInputs(tick, next_event);
+		timedUpdate(game, counter);
+	}
+
+	final_hash = game.getStateHash();
+}
+
+void HeadlessRunner::runReplay(Game& game, InputPlayer& player)
+{
+	tick_times.clear();
+
+	PerformanceCounter counter;
+	while (player.replayTick())
+		timedUpdate(game, counter);
+
+	final_hash = game.getStateHash();
+}
+
+void HeadlessRunner::printReport(std::ostream& out) const
+{
+	if (tick_times.empty())
+	{
+		out << "No ticks were run" << std::endl;
+		return;
+	}
+
+	std::vector<double> sorted_times = tick_times;
+	std::sort(sorted_times.begin(), sorted_times.end());
+	double total = 0.0;
+	for (double time : tick_times)
+		total += time;
+
+	out << std::fixed << std::setprecision(4);
+	out << "Headless run: " << tick_times.size() << " ticks of " << FRAME_TIME_UPDATE << " ms" << std::endl;
+	out << "Tick time (ms): mean " << total / tick_times.size()
+		<< "  min " << sorted_times.front()
+		<< "  median " << getPercentile(sorted_times, 0.5)
+		<< "  95% " << getPercentile(sorted_times, 0.95)
+		<< "  99% " << getPercentile(sorted_times, 0.99)
+		<< "  max " << sorted_times.back() << std::endl;
+	out << "Total update time: " << total << " ms" << std::endl;
+	out << "State hash: " << std::hex << std::setw(16) << std::setfill('0') << final_hash
+		<< std::dec << std::setfill(' ') << std::endl;
+}
+
+unsigned long long HeadlessRunner::getFinalHash() const
+{
+	return final_hash;
+}
+
+void HeadlessRunner::timedUpdate(Game& game, PerformanceCounter& counter)
+{
+	counter.start();
+	game.update(FRAME_TIME_UPDATE);
+	tick_times.push_back(counter.getCounter());
+	g_update_count++;
+}
+
+unsigned HeadlessRunner::applyInputs(unsigned tick, unsigned next_event) const
+{
+	while (next_event < events.size() && events[next_event].tick <= tick)
+	{
+		const InputEvent& event = events[next_event];
+		switch (event.type)
+		{
+		case Input_Type::KEY_DOWN:
+			g_key_pressed[event.key] = true;
+			break;
+		case Input_Type::KEY_UP:
+			g_key_pressed[event.key] = false;
+			break;
+		case Input_Type::MOUSE_MOVE:
+			g_mouse_dx += event.mouse_dx;
+			g_mouse_dy += event.mouse_dy;
+			break;
+		}
+		next_event++;
+	}
+	return next_event;
+}
+
+bool HeadlessRunner::parseKey(const std::string& name, unsigned& key)
+{
+	if (name.size() == 1 && isalnum(name[0]))
+	{
+		key = unsigned(toupper(name[0]));
+		return true;
+	}
+
+	if (name == "SPACE") key = ' ';
+	else if (name == "UP") key = KEY_UP_ARROW;
+	else if (name == "DOWN") key = KEY_DOWN_ARROW;
+	else if (name == "LEFT") key = KEY_LEFT_ARROW;
+	else if (name == "RIGHT") key = KEY_RIGHT_ARROW;
+	else if (name == "MOUSE_LEFT") key = MOUSE_LEFT;
+	else if (name == "MOUSE_RIGHT") key = MOUSE_RIGHT;
+	else return false;
+	return true;
+}
+
+double HeadlessRunner::getPercentile(const std::vector<double>& sorted_times, double fraction)
+{
+	const unsigned index = unsigned(fraction * (sorted_times.size() - 1) + 0.5);
+	return sorted_times[index];
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+
+class Game;
+class InputPlayer;
+class PerformanceCounter;
+
+//Runs the game's simulation without a window or OpenGL context
+//Game::update is called for a number of fixed ticks with inputs from a script,
+//each tick is timed and the state of the game is hashed at the end.
+//Used to profile and regression test the simulation on machines without a GPU
+class HeadlessRunner
+{
+public:
+	enum class Input_Type
+	{
+		KEY_DOWN,
+		KEY_UP,
+		MOUSE_MOVE
+	};
+
+	//An input applied before the update of a tick
+	struct InputEvent
+	{
+		unsigned tick;
+		Input_Type type;
+		//The g_key_pressed index for key events
+		unsigned key;
+		//The mouse movement for mouse events
+		int mouse_dx;
+		int mouse_dy;
+	};
+
+private:
+	std::vector<InputEvent> events;
+	std::vector<double> tick_times;
+	unsigned long long final_hash{};
+
+public:
+	HeadlessRunner() = default;
+
+	//Loads the inputs from a script, one input per line:
+	//	<tick> down <key>
+	//	<tick> up <key>
+	//	<tick> mouse <dx> <dy>
+	//Keys are a letter or digit, SPACE, UP, DOWN, LEFT, RIGHT, MOUSE_LEFT or MOUSE_RIGHT.
+	//Lines starting with # are comments. Returns false if the script could not be read
+	bool loadScript(const std::string& filename);
+
+	//Uses a built in script that runs, strafes, turns and jumps in a loop
+	void useDefaultScript(unsigned tick_count);
+
+	//Runs the game for a number of ticks of FRAME_TIME_UPDATE
+	//The game must already be initialized
+	void run(Game& game, unsigned tick_count);
+
+	//Runs the game for every tick of an input log, the input comes from the log instead of a script
+	//The game must already be initialized with the seed and world file of the log
+	void runReplay(Game& game, InputPlayer& player);
+
+	//Writes the tick time statistics and the final state hash
+	void printReport(std::ostream& out) const;
+
+	unsigned long long getFinalHash() const;
+
+	//Returns the time in milliseconds that a fraction of the ticks took no longer than
+	static double getPercentile(const std::vector<double>& sorted_times, double fraction);
+
+private:
+	//Updates the game once and records how long it took
+	void timedUpdate(Game& game, PerformanceCounter& counter);
+
+	//Applies the inputs of a tick starting at event next_event
+	//Returns the first event of a later tick
+	unsigned applyInputs(unsigned tick, unsigned next_event) const;
+
+	//Returns false if the name is not a key
+	static bool parseKey(const std::string& name, unsigned& key);
+};
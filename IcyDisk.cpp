@@ -86,8 +86,8 @@ void IcyDisk::generateHeightMap()
 			vec2Distance1ToManySIMD(dp, float(x), float(z), 200, reinterpret_cast<float*>(points.x), reinterpret_cast<float*>(points.z));
 
 			addAndSubSIMD(ap, sp, 200, reinterpret_cast<float*>(points.y), dp);
-			const float p = max(maxSIMD(200, sp), 0);
-			const float n = min(minSIMD(200, ap), 0);
+			const float p = max(maxSIMD(200, sp), 0.0f);
+			const float n = min(minSIMD(200, ap), 0.0f);
 
 			//OLD CODE that is slower
 
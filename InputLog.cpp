@@ -0,0 +1,214 @@
+#include "InputLog.h"
+#include <iostream>
+#include "Globals.h"
+
+static const unsigned INPUT_LOG_MAGIC = 0x474C4E49; //"INLG"
+static const unsigned INPUT_LOG_VERSION = 1;
+
+//What a tick record holds
+static const unsigned char TICK_KEYS = 1;
+static const unsigned char TICK_MOUSE = 2;
+static const unsigned char TICK_TIME_SCALE = 4;
+
+//Set in a key index when the key was pressed
+static const unsigned short KEY_PRESSED_BIT = 0x8000;
+
+template <typename T>
+static void writeValue(std::ofstream& file, const T& value)
+{
+	file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& file, T& value)
+{
+	return bool(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool InputRecorder::open(const std::string& filename, unsigned seed, const std::string& world_file_name)
+{
+	file.open(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cerr << "Error: Could not create input log \"" << filename << "\"" << std::endl;
+		return false;
+	}
+
+	writeValue(file, INPUT_LOG_MAGIC);
+	writeValue(file, INPUT_LOG_VERSION);
+	writeValue(file, KEY_COUNT);
+	writeValue(file, seed);
+	writeValue(file, unsigned(world_file_name.size()));
+	file.write(world_file_name.c_str(), world_file_name.size());
+
+	//The first tick records every key already held and the time scale
+	last_keys.assign(KEY_COUNT, false);
+	last_time_scale_id = -1;
+	tick_count = 0;
+	return true;
+}
+
+bool InputRecorder::isOpen() const
+{
+	return file.is_open();
+}
+
+void InputRecorder::recordTick()
+{
+	if (!file.is_open()) return;
+
+	std::vector<unsigned short> changed_keys;
+	for (unsigned i = 0; i < KEY_COUNT; i++)
+	{
+		if (g_key_pressed[i] == last_keys[i]) continue;
+		changed_keys.push_back((unsigned short)(i | (g_key_pressed[i] ? KEY_PRESSED_BIT : 0)));
+		last_keys[i] = g_key_pressed[i];
+	}
+
+	unsigned char flags = 0;
+	if (!changed_keys.empty()) flags |= TICK_KEYS;
+	if (g_mouse_dx != 0 || g_mouse_dy != 0) flags |= TICK_MOUSE;
+	if (g_time_scale_id != last_time_scale_id) flags |= TICK_TIME_SCALE;
+	writeValue(file, flags);
+
+	if (flags & TICK_KEYS)
+	{
+		writeValue(file, (unsigned short)(changed_keys.size()));
+		file.write(reinterpret_cast<const char*>(changed_keys.data()), changed_keys.size() * sizeof(unsigned short));
+	}
+	if (flags & TICK_MOUSE)
+	{
+		writeValue(file, short(g_mouse_dx));
+		writeValue(file, short(g_mouse_dy));
+	}
+	if (flags & TICK_TIME_SCALE)
+	{
+		writeValue(file, (unsigned char)(g_time_scale_id));
+		last_time_scale_id = g_time_scale_id;
+	}
+	tick_count++;
+}
+
+void InputRecorder::close()
+{
+	if (!file.is_open()) return;
+	file.close();
+	std::cout << "Recorded " << tick_count << " ticks of input" << std::endl;
+}
+
+unsigned InputRecorder::getTickCount() const
+{
+	return tick_count;
+}
+
+bool InputPlayer::open(const std::string& filename)
+{
+	file.open(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Error: Input log \"" << filename << "\" does not exist" << std::endl;
+		return false;
+	}
+
+	unsigned magic = 0, version = 0, key_count = 0, name_length = 0;
+	if (!readValue(file, magic) || !readValue(file, version) || !readValue(file, key_count) ||
+		!readValue(file, seed) || !readValue(file, name_length) ||
+		magic != INPUT_LOG_MAGIC || version != INPUT_LOG_VERSION || key_count != KEY_COUNT)
+	{
+		std::cerr << "Error: Input log \"" << filename << "\" is invalid" << std::endl;
+		file.close();
+		return false;
+	}
+
+	world_file_name.assign(name_length, ' ');
+	if (name_length > 0 && !file.read(&world_file_name[0], name_length))
+	{
+		std::cerr << "Error: Input log \"" << filename << "\" is invalid" << std::endl;
+		file.close();
+		return false;
+	}
+
+	keys.assign(KEY_COUNT, false);
+	tick_count = 0;
+	return true;
+}
+
+bool InputPlayer::isOpen() const
+{
+	return file.is_open();
+}
+
+bool InputPlayer::replayTick()
+{
+	if (!file.is_open()) return false;
+
+	unsigned char flags = 0;
+	if (!readValue(file, flags))
+	{
+		close();
+		return false;
+	}
+
+	if (flags & TICK_KEYS)
+	{
+		unsigned short count = 0;
+		readValue(file, count);
+		for (unsigned i = 0; i < count; i++)
+		{
+			unsigned short key = 0;
+			readValue(file, key);
+			const unsigned index = key & ~KEY_PRESSED_BIT;
+			if (index < KEY_COUNT)
+				keys[index] = (key & KEY_PRESSED_BIT) != 0;
+		}
+	}
+
+	//The whole key state is set every tick so input from the window cannot change the replay
+	for (unsigned i = 0; i < KEY_COUNT; i++)
+		g_key_pressed[i] = keys[i];
+
+	g_mouse_dx = 0;
+	g_mouse_dy = 0;
+	if (flags & TICK_MOUSE)
+	{
+		short dx = 0, dy = 0;
+		readValue(file, dx);
+		readValue(file, dy);
+		g_mouse_dx = dx;
+		g_mouse_dy = dy;
+	}
+
+	if (flags & TICK_TIME_SCALE)
+	{
+		unsigned char time_scale_id = 0;
+		readValue(file, time_scale_id);
+		if (time_scale_id <= TIME_SCALE_COUNT)
+		{
+			g_time_scale_id = time_scale_id;
+			g_time_scale = TIME_SCALES[time_scale_id];
+		}
+	}
+
+	tick_count++;
+	return true;
+}
+
+void InputPlayer::close()
+{
+	file.close();
+}
+
+unsigned InputPlayer::getSeed() const
+{
+	return seed;
+}
+
+const std::string& InputPlayer::getWorldFileName() const
+{
+	return world_file_name;
+}
+
+unsigned InputPlayer::getTickCount() const
+{
+	return tick_count;
+}
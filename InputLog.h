@@ -0,0 +1,74 @@
+#pragma once
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Input logs record the input of every update so a run can be replayed exactly
+//
+//The log starts with a header holding the random seed and world file the run started with.
+//Each update is then one record of what changed since the last update:
+//	1 byte of flags, then for each flag set:
+//	KEYS:       a 2 byte count and a 2 byte key index per changed key, the top bit set if pressed
+//	MOUSE:      the 2 byte mouse x and y movement used by the update
+//	TIME_SCALE: the 1 byte time scale id
+//An update with no input is a single byte.
+
+//Records g_key_pressed, the mouse movement and the time scale before each update
+class InputRecorder
+{
+private:
+	std::ofstream file;
+	std::vector<bool> last_keys;
+	int last_time_scale_id{};
+	unsigned tick_count{};
+
+public:
+	InputRecorder() = default;
+
+	//Starts a log for a run using a seed and world file
+	//Returns false if the file could not be created
+	bool open(const std::string& filename, unsigned seed, const std::string& world_file_name);
+
+	bool isOpen() const;
+
+	//Records the input used by the next update
+	void recordTick();
+
+	//Finishes the log, later ticks are not recorded
+	void close();
+
+	unsigned getTickCount() const;
+};
+
+//Replays a log by setting g_key_pressed, the mouse movement and the time scale before each update
+class InputPlayer
+{
+private:
+	std::ifstream file;
+	std::vector<bool> keys;
+	unsigned seed{};
+	std::string world_file_name;
+	unsigned tick_count{};
+
+public:
+	InputPlayer() = default;
+
+	//Opens a log and reads its header
+	//Returns false if the file could not be read or is not an input log
+	bool open(const std::string& filename);
+
+	bool isOpen() const;
+
+	//Sets the input for the next update
+	//Returns false and closes the log once every tick has been replayed
+	bool replayTick();
+
+	void close();
+
+	//The seed and world the recorded run started with
+	unsigned getSeed() const;
+	const std::string& getWorldFileName() const;
+
+	//Returns the number of ticks replayed so far
+	unsigned getTickCount() const;
+};
@@ -0,0 +1,154 @@
+#include "JobSystem.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	thread_local unsigned t_thread_index = 0;
+}
+
+JobSystem::~JobSystem()
+{
+	destroy();
+}
+
+void JobSystem::init(unsigned thread_count)
+{
+	destroy();
+
+	if (thread_count == 0)
+		thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+	queues.clear();
+	for (unsigned i = 0; i < thread_count; i++)
+		queues.push_back(std::make_unique<JobQueue>());
+
+	running = true;
+	for (unsigned i = 1; i < thread_count; i++)
+		workers.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+void JobSystem::destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		running = false;
+	}
+	wake_condition.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+	workers.clear();
+	queues.clear();
+}
+
+unsigned JobSystem::getThreadCount() const
+{
+	return std::max(1u, unsigned(queues.size()));
+}
+
+unsigned JobSystem::getThreadIndex()
+{
+	return t_thread_index;
+}
+
+void JobSystem::parallelFor(unsigned count, unsigned min_batch_size, const RangeFunction& function)
+{
+	if (count == 0) return;
+	min_batch_size = std::max(1u, min_batch_size);
+
+	const unsigned max_jobs = getThreadCount() * JOBS_PER_THREAD;
+	const unsigned job_count = std::min(max_jobs, (count + min_batch_size - 1) / min_batch_size);
+	if (workers.empty() || job_count <= 1)
+	{
+		function(0, count);
+		return;
+	}
+
+	//A second thread that is not a worker would run and queue jobs on queue 0 as well
+	//The same thread can come back in from a job it runs while waiting
+	const unsigned thread_index = getThreadIndex();
+	const std::thread::id this_thread_id = std::this_thread::get_id();
+	std::thread::id previous_caller{};
+	const bool is_outer_call = thread_index == 0 && caller_thread.compare_exchange_strong(previous_caller, this_thread_id);
+	assert(thread_index != 0 || is_outer_call || previous_caller == this_thread_id);
+
+	std::atomic<unsigned> remaining(job_count);
+
+	//Count the jobs before queueing them so a worker never takes the count below zero
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		queued_job_count += job_count;
+	}
+
+	//Deal the jobs out over the queues so each thread starts with its own share
+	for (unsigned j = 0; j < job_count; j++)
+	{
+		const unsigned begin = unsigned((unsigned long long)count * j / job_count);
+		const unsigned end = unsigned((unsigned long long)count * (j + 1) / job_count);
+		JobQueue& queue = *queues[j % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(Job{ &function, begin, end, &remaining });
+	}
+	wake_condition.notify_all();
+
+	//Help until every job of this loop is done
+	while (remaining.load() > 0)
+	{
+		if (!runJob(thread_index))
+			std::this_thread::yield();
+	}
+
+	if (is_outer_call)
+		caller_thread = std::thread::id();
+}
+
+void JobSystem::workerLoop(unsigned thread_index)
+{
+	t_thread_index = thread_index;
+	while (true)
+	{
+		if (runJob(thread_index)) continue;
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		wake_condition.wait(lock, [this]() { return !running || queued_job_count.load() > 0; });
+		if (!running) return;
+	}
+}
+
+bool JobSystem::runJob(unsigned thread_index)
+{
+	Job job{};
+	bool found = false;
+
+	//Newest job from this thread's queue first, it is most likely to be in cache
+	{
+		JobQueue& queue = *queues[thread_index];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			found = true;
+		}
+	}
+
+	//Otherwise steal the oldest job from another thread
+	for (unsigned i = 1; !found && i < queues.size(); i++)
+	{
+		JobQueue& queue = *queues[(thread_index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (!queue.jobs.empty())
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			found = true;
+		}
+	}
+	if (!found) return false;
+
+	queued_job_count--;
+	(*job.function)(job.begin, job.end);
+	job.remaining->fetch_sub(1);
+	return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//A pool of worker threads that run ranges of a parallel for loop
+//Each thread has its own job queue. A thread runs jobs from the back of its own queue
+//and steals from the front of the other queues when its queue is empty.
+//The thread calling parallelFor runs jobs as well until every job of the loop is done.
+//Every thread that is not a worker is thread 0 and uses queue 0, so only one of them may be in
+//parallelFor at a time. The game loads on the GLUT thread and then updates on the simulation
+//thread, never both at once. Jobs may call parallelFor from any thread. Debug builds assert this
+class JobSystem
+{
+public:
+	//Called with a range [begin, end) of the loop
+	typedef std::function<void(unsigned begin, unsigned end)> RangeFunction;
+
+private:
+	struct Job
+	{
+		const RangeFunction* function;
+		unsigned begin;
+		unsigned end;
+		std::atomic<unsigned>* remaining;
+	};
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	//Jobs per thread a loop is split into so threads that finish early can steal
+	const unsigned JOBS_PER_THREAD = 4;
+
+	std::vector<std::thread> workers;
+
+	//One queue per thread, queue 0 belongs to the thread calling parallelFor
+	std::vector<std::unique_ptr<JobQueue>> queues;
+
+	//Workers sleep on this while there are no jobs
+	std::mutex sleep_mutex;
+	std::condition_variable wake_condition;
+	std::atomic<unsigned> queued_job_count{};
+	bool running = false;
+
+	//The thread that is not a worker inside parallelFor, checked so two of them never share queue 0
+	std::atomic<std::thread::id> caller_thread{};
+
+public:
+	JobSystem() = default;
+	~JobSystem();
+
+	JobSystem(const JobSystem& other) = delete;
+	JobSystem& operator=(const JobSystem& other) = delete;
+
+	//Starts the worker threads. A thread count of 0 uses one thread per hardware thread
+	//The calling thread counts as one of the threads
+	void init(unsigned thread_count = 0);
+
+	//Stops and joins the worker threads
+	void destroy();
+
+	//Returns the number of threads that run jobs, including the calling thread
+	unsigned getThreadCount() const;
+
+	//Returns the index of the thread running the current code in [0, getThreadCount())
+	//Any thread that is not a worker is 0
+	static unsigned getThreadIndex();
+
+	//Splits [0, count) into ranges of at least min_batch_size and runs them on every thread
+	//Returns when every range has been run. Runs on the calling thread alone if the system
+	//has not been initialized or the loop is too small to split
+	//Only one thread that is not a worker may be in parallelFor at a time
+	void parallelFor(unsigned count, unsigned min_batch_size, const RangeFunction& function);
+
+private:
+	void workerLoop(unsigned thread_index);
+
+	//Runs one job from this thread's queue or stolen from another queue
+	//Returns false if every queue was empty
+	bool runJob(unsigned thread_index);
+};
@@ -57,7 +57,7 @@ void LeafyDisk::generateHeightMap()
 			const double uy = (double)z / (double)heightMapSize;
 			const double x2 = ux * 2.0 - 1.0;
 			const double y2 = uy * 2.0 - 1.0;
-			const double dist = min(sqrt(x2 * x2 + y2 * y2), 1);
+			const double dist = min(sqrt(x2 * x2 + y2 * y2), 1.0);
 			const double radians = atan2(y2, x2);
 
 			const double ll = pow(ux, 4) * (1 - ux) * 12.0;
@@ -65,9 +65,9 @@ void LeafyDisk::generateHeightMap()
 			const double lr = pow((1 - ux), 4) * ux * 12.0;
 			const double lsum = ll * LL + lc * LC + lr * LR;
 
-			const double ri = pow(max(1 - dist, 0), 2);
-			const double rm = sin(M_PI * min(pow(dist, 0.8) * (4 / 3), 1));
-			const double ro = max(sin(M_PI * pow(dist, 1.6)), 0);
+			const double ri = pow(max(1 - dist, 0.0), 2);
+			const double rm = sin(M_PI * min(pow(dist, 0.8) * (4 / 3), 1.0));
+			const double ro = max(sin(M_PI * pow(dist, 1.6)), 0.0);
 			const double rsum = ri * RI + rm * RM + ro * RO;
 
 			const double ai = (sqrt(dist) - dist) * 4;
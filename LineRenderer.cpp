@@ -14,8 +14,8 @@ void LineRenderer::init()
 	glBindVertexArray(VAO);
 
 	// generate and bind the buffer object
-	glGenBuffers(1, &VBO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	vertex_stream.init(sizeof(Point), STREAM_REGION_POINTS);
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_stream.getBuffer());
 
 	//Set the shader attributes
 	glEnableVertexAttribArray(0);
@@ -26,20 +26,19 @@ void LineRenderer::init()
 }
 
 
-void LineRenderer::draw(const std::vector<Point>& vertexData, const glm::mat4& vp_matrix) const
+void LineRenderer::draw(const std::vector<Point>& vertexData, const glm::mat4& vp_matrix)
 {
 	glUseProgram(line_program_id);
 
 	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	// fill with data
 	const size_t num_verts = vertexData.size();
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Point) * num_verts, &vertexData[0], GL_STREAM_DRAW);
+	const unsigned first = vertex_stream.write(vertexData.data(), num_verts);
 	glUniformMatrix4fv(mvp_id, 1, false, &(vp_matrix[0][0]));
 
 	glLineWidth(2.0f);
-	glDrawArrays(GL_LINES, 0, num_verts);
+	glDrawArrays(GL_LINES, first, num_verts);
 	glBindVertexArray(0);
 }
 
@@ -62,40 +61,37 @@ void LineRenderer::drawLinesAndClear(const glm::mat4& vp_matrix)
 	glUseProgram(line_program_id);
 
 	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	// fill with data
-
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Point) * num_verts, &points[0], GL_STREAM_DRAW);
+	const unsigned first = vertex_stream.write(points.data(), num_verts);
 	glUniformMatrix4fv(mvp_id, 1, false, &(vp_matrix[0][0]));
 
 	glLineWidth(2.0f);
-	glDrawArrays(GL_LINES, 0, num_verts);
+	glDrawArrays(GL_LINES, first, num_verts);
 	glBindVertexArray(0);
 	points.clear();
 
 }
 
-void LineRenderer::drawPointList(const std::vector<Point>& point_list, const glm::mat4& vp_matrix) const
+void LineRenderer::drawPointList(const std::vector<Point>& point_list, const glm::mat4& vp_matrix)
 {
 	const size_t num_verts = point_list.size();
 	if (num_verts == 0) return;
 	glUseProgram(line_program_id);
 
 	glBindVertexArray(VAO);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
 
 	// fill with data
-	glBufferData(GL_ARRAY_BUFFER, sizeof(Point) * num_verts, &point_list[0], GL_STREAM_DRAW);
+	const unsigned first = vertex_stream.write(point_list.data(), num_verts);
 	glUniformMatrix4fv(mvp_id, 1, false, &(vp_matrix[0][0]));
 
 	glLineWidth(2.0f);
-	glDrawArrays(GL_LINES, 0, num_verts);
+	glDrawArrays(GL_LINES, first, num_verts);
 	glBindVertexArray(0);
 
 }
 
-void LineRenderer::draw(const std::vector<Vector3>& points, const glm::vec4& color, const glm::mat4& vp_matrix) const
+void LineRenderer::draw(const std::vector<Vector3>& points, const glm::vec4& color, const glm::mat4& vp_matrix)
 {
 	std::vector<Point> vertex_data;
 	vertex_data.resize(points.size() * 2 - 2);
@@ -110,7 +106,7 @@ void LineRenderer::draw(const std::vector<Vector3>& points, const glm::vec4& col
 	draw(vertex_data, vp_matrix);
 }
 
-void LineRenderer::draw(const Vector3& p1, const Vector3& p2, const glm::vec4& color, const glm::mat4& vp_matrix)  const
+void LineRenderer::draw(const Vector3& p1, const Vector3& p2, const glm::vec4& color, const glm::mat4& vp_matrix)
 {
 	std::vector<Point> vertex_data;
 	vertex_data.resize(2);
@@ -2,6 +2,7 @@
 #include "lib/GetGlutWithShaders.h"
 #include "lib/ObjLibrary/Vector3.h"
 #include "lib/glm/glm.hpp"
+#include "StreamBuffer.h"
 #include <vector>
 using ObjLibrary::Vector3;
 
@@ -31,7 +32,11 @@ private:
 	const std::string line_shader_frag = "line.frag";
 	std::vector<Point> points;
 
-	GLuint VAO{}, VBO{};
+	//The points drawn this frame follow each other in the stream
+	const unsigned STREAM_REGION_POINTS = 65536;
+
+	GLuint VAO{};
+	StreamBuffer vertex_stream;
 	GLuint line_program_id{};
 
 	//Uniform location
@@ -48,14 +53,14 @@ public:
 	void preAllocateLine(unsigned size);
 
 	//Draws Lines connecting the specified 2 points using the giving color and vp matrix
-	void draw(const Vector3& p1, const Vector3& p2, const glm::vec4& color, const glm::mat4& vp_matrix) const;
+	void draw(const Vector3& p1, const Vector3& p2, const glm::vec4& color, const glm::mat4& vp_matrix);
 
 	//Draws Lines connecting the specified pooints using the giving color and mvp matrix
-	void draw(const std::vector<Vector3>& points, const glm::vec4& color, const glm::mat4& vp_matrix) const;
+	void draw(const std::vector<Vector3>& points, const glm::vec4& color, const glm::mat4& vp_matrix);
 
 	//Draws Lines using the specified point vertexData, and mxp_matrix
 	//Each line requires two vertexes, to draw a line between 3 points, the second point must be duplicated
-	void draw(const std::vector<Point>& vertexData, const glm::mat4& vp_matrix) const;
+	void draw(const std::vector<Point>& vertexData, const glm::mat4& vp_matrix);
 
 	//Add a line to the points vector
 	void addLine(const glm::vec3& p1, const glm::vec3& p2, const glm::vec4& color);
@@ -64,6 +69,6 @@ public:
 	void drawLinesAndClear(const glm::mat4& vp_matrix);
 
 	//Draws the lines of the provided point_list vector
-	void drawPointList(const std::vector<Point>& point_list, const glm::mat4& vp_matrix) const;
+	void drawPointList(const std::vector<Point>& point_list, const glm::mat4& vp_matrix);
 };
 
@@ -0,0 +1,114 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+	const HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	file_handle = file;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr)
+	{
+		close();
+		return false;
+	}
+	size = size_t(file_size.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+	if (file_handle != nullptr) CloseHandle(file_handle);
+	data = nullptr;
+	mapping_handle = nullptr;
+	file_handle = nullptr;
+	size = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filename)
+{
+	close();
+
+	file_descriptor = ::open(filename.c_str(), O_RDONLY);
+	if (file_descriptor < 0) return false;
+
+	struct stat file_stat;
+	if (fstat(file_descriptor, &file_stat) != 0 || file_stat.st_size == 0)
+	{
+		close();
+		return false;
+	}
+
+	void* mapping = mmap(nullptr, size_t(file_stat.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	if (mapping == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	data = static_cast<const char*>(mapping);
+	size = size_t(file_stat.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr) munmap(const_cast<char*>(data), size);
+	if (file_descriptor >= 0) ::close(file_descriptor);
+	data = nullptr;
+	file_descriptor = -1;
+	size = 0;
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return data != nullptr;
+}
+
+const char* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+//A read only view of a whole file mapped into memory
+//The data stays valid until the file is closed or the MappedFile is destroyed
+class MappedFile
+{
+private:
+	const char* data = nullptr;
+	size_t size = 0;
+
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#else
+	int file_descriptor = -1;
+#endif
+
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile& other) = delete;
+	MappedFile& operator=(const MappedFile& other) = delete;
+
+	//Maps the file into memory. Returns false if the file can not be opened or is empty
+	bool open(const std::string& filename);
+
+	//Unmaps the file
+	void close();
+
+	bool isOpen() const;
+	const char* getData() const;
+	size_t getSize() const;
+};
@@ -1,5 +1,33 @@
 #include "MovementGraph.h"
-#include "UpdatablePriorityQueue.h"
+#include "MappedFile.h"
+#include "PerformanceCounter.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+
+extern JobSystem g_job_system;
+
+namespace
+{
+	//The start of a graph cache file
+	//It is followed by the node positions (3 doubles per node), the index of the first link of each
+	//node plus the end (node_count + 1 unsigneds), the node disk ids, the link destination node ids,
+	//the link weights (floats) and a 1 or 0 per disk for if the disk is in the graph
+	struct GraphCacheHeader
+	{
+		unsigned magic;
+		unsigned version;
+		unsigned long long key;
+		unsigned disk_count;
+		unsigned node_count;
+		unsigned link_count;
+		unsigned padding;
+	};
+
+	//The fewest disks in a job of the graph building loops
+	const unsigned MIN_DISKS_PER_JOB = 64;
+}
 
 void MovementGraph::destroy()
 {
@@ -7,7 +35,10 @@ void MovementGraph::destroy()
 	node_count = 0;
 	node_list.clear();
 	disk_node_list.clear();
-	search_data.clear();
+	free_node_ids.clear();
+	active_node_ids.clear();
+	disk_grid.clear();
+	search_context = SearchContext();
 	memorized_search_data.clear();
 }
 
@@ -15,49 +46,345 @@ void MovementGraph::init(const std::vector<std::unique_ptr<Disk>>& disks)
 {
 	const unsigned size = disks.size();
 	assert(size > 0);
-	a_star_visits = 0;
-	dijkstra_visits = 0;
 	node_list.resize(0);
+	disk_node_list.clear();
 	disk_node_list.resize(size);
+	free_node_ids.clear();
 
+	//The graph is built in the same order as linking every overlapping pair (i, j) with i < j
+	//in order would. Pair p gets node ids 2p on disk i and 2p + 1 on disk j, so the node ids
+	//and link order do not depend on the number of threads
 
-	for (unsigned i = 0; i < size; i++)
+	//Broadphase
+	//Find the overlapping disks after each disk using the disk grid
+	initDiskGrid(disks);
+
+	std::vector<std::vector<unsigned>> disk_neighbours(size);
+	g_job_system.parallelFor(size, MIN_DISKS_PER_JOB, [&](unsigned begin, unsigned end)
 	{
-		for (unsigned j = i + 1; j < size; j++)
+		std::vector<unsigned> candidates;
+		for (unsigned i = begin; i < end; i++)
 		{
 			const Disk& disk_i = *disks[i];
-			const Disk& disk_j = *disks[j];
-			//No collision
-			if (!Collision::circleIntersection(
-				float(disk_i.position.x), float(disk_i.position.z), disk_i.radius + collision_offset,
-				float(disk_j.position.x), float(disk_j.position.z), disk_j.radius + collision_offset))
-				continue;
+			candidates.clear();
+			//Candidates come back sorted so the pairs of disk i are in order of j
+			disk_grid.query(float(disk_i.position.x), float(disk_i.position.z), disk_i.radius + collision_offset, candidates);
+			for (const unsigned j : candidates)
+			{
+				if (j > i && isDiskOverlap(disk_i, *disks[j]))
+					disk_neighbours[i].push_back(j);
+			}
+		}
+	});
 
-			const Vector3 position_i = calculateNodePosition(disk_i, disk_j);
-			const Vector3 position_j = calculateNodePosition(disk_j, disk_i);
+	//The index of the first pair of each disk
+	std::vector<unsigned> pair_start(size + 1, 0);
+	for (unsigned i = 0; i < size; i++)
+		pair_start[i + 1] = pair_start[i] + disk_neighbours[i].size();
+	const unsigned pair_count = pair_start[size];
 
-			unsigned node_id_i = addNode(position_i, i);
-			unsigned node_id_j = addNode(position_j, j);
+	//Create the two nodes of every pair and the weight between them
+	node_list.resize(pair_count * 2);
+	std::vector<float> pair_weights(pair_count);
+	g_job_system.parallelFor(size, MIN_DISKS_PER_JOB, [&](unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; i++)
+		{
+			const Disk& disk_i = *disks[i];
+			for (unsigned k = 0; k < disk_neighbours[i].size(); k++)
+			{
+				const unsigned j = disk_neighbours[i][k];
+				const Disk& disk_j = *disks[j];
+				const unsigned pair = pair_start[i] + k;
+				const unsigned node_id_i = pair * 2;
+				const unsigned node_id_j = pair * 2 + 1;
+
+				node_list[node_id_i] = Node(node_id_i, i, calculateNodePosition(disk_i, disk_j));
+				node_list[node_id_j] = Node(node_id_j, j, calculateNodePosition(disk_j, disk_i));
+				pair_weights[pair] = calculateWeightBetweenDisks(disks, node_id_i, node_id_j);
+			}
+		}
+	});
 
-			const float weight_ij = calculateWeightBetweenDisks(disks, node_id_i, node_id_j);
-			addLink(i, node_id_i, j, node_id_j, weight_ij);
+	//Nodes on each disk in the order they were created
+	for (unsigned i = 0; i < size; i++)
+	{
+		for (unsigned k = 0; k < disk_neighbours[i].size(); k++)
+		{
+			const unsigned pair = pair_start[i] + k;
+			disk_node_list[i].push_back(pair * 2);
+			disk_node_list[disk_neighbours[i][k]].push_back(pair * 2 + 1);
+		}
+	}
+
+	//Link the nodes of each disk
+	//Each node links to its pair first and then to the other nodes on its disk in creation order
+	std::vector<unsigned> disk_link_counts(size, 0);
+	g_job_system.parallelFor(size, MIN_DISKS_PER_JOB, [&](unsigned begin, unsigned end)
+	{
+		std::vector<float> weights;
+		for (unsigned d = begin; d < end; d++)
+		{
+			const std::vector<unsigned>& nodes = disk_node_list[d];
+			const unsigned count = nodes.size();
 
-			for (auto& node_id_k : disk_node_list[i])
+			//Weights are calculated from the newer node to the older node
+			weights.resize(count * count);
+			for (unsigned b = 0; b < count; b++)
 			{
-				const float weight_ik = calculateWeightSameDisk(disks, node_id_i, node_id_k);
-				addLink(i, node_id_i, node_list[node_id_k].disk_id, node_id_k, weight_ik);
+				for (unsigned a = 0; a < b; a++)
+				{
+					const float weight = calculateWeightSameDisk(disks, nodes[b], nodes[a]);
+					weights[a * count + b] = weight;
+					weights[b * count + a] = weight;
+				}
 			}
-			for (auto& node_id_k : disk_node_list[j])
+
+			for (unsigned k = 0; k < count; k++)
 			{
-				const float weight_jk = calculateWeightSameDisk(disks, node_id_j, node_id_k);
-				addLink(j, node_id_j, node_list[node_id_k].disk_id, node_id_k, weight_jk);
+				Node& node = node_list[nodes[k]];
+				const unsigned pair_node_id = node.node_id ^ 1u;
+				node.node_links.reserve(count);
+				node.node_links.emplace_back(node.node_id, pair_node_id, node_list[pair_node_id].disk_id,
+					pair_weights[node.node_id / 2]);
+
+				for (unsigned a = 0; a < count; a++)
+				{
+					if (a == k) continue;
+					node.node_links.emplace_back(node.node_id, nodes[a], d, weights[k * count + a]);
+				}
 			}
+			disk_link_counts[d] = count * (count - 1) / 2;
+		}
+	});
+
+	node_count = pair_count * 2;
+	active_node_ids.resize(node_count);
+	std::iota(active_node_ids.begin(), active_node_ids.end(), 0u);
+	node_link_count = pair_count;
+	for (const unsigned link_count : disk_link_counts)
+		node_link_count += link_count;
+}
+
+void MovementGraph::addDisk(const std::vector<std::unique_ptr<Disk>>& disks, unsigned disk_id)
+{
+	assert(disk_id < disks.size());
+	assert(!disk_grid.contains(disk_id));
+	if (disk_node_list.size() < disks.size())
+		disk_node_list.resize(disks.size());
+
+	const Disk& disk = *disks[disk_id];
+	const float x = float(disk.position.x);
+	const float z = float(disk.position.z);
 
-			disk_node_list[i].push_back(node_id_i);
-			disk_node_list[j].push_back(node_id_j);
+	//Only the disks sharing a grid cell can overlap this disk
+	std::vector<unsigned> neighbours;
+	disk_grid.query(x, z, disk.radius + collision_offset, neighbours);
+
+	for (const unsigned neighbour_id : neighbours)
+	{
+		if (!isDiskOverlap(disk, *disks[neighbour_id]))
+			continue;
+
+		linkDisks(disks, disk_id, neighbour_id);
+	}
+	disk_grid.insert(disk_id, x, z, disk.radius + collision_offset);
+}
+
+void MovementGraph::removeDisk(unsigned disk_id)
+{
+	if (!disk_grid.contains(disk_id)) return;
+	disk_grid.remove(disk_id);
+
+	//Copied because removing the nodes removes them from the list
+	const std::vector<unsigned> disk_nodes = disk_node_list[disk_id];
+	for (const unsigned node_id : disk_nodes)
+	{
+		//The node on the other side of a link between disks
+		//only exists because of this disk so it goes as well
+		std::vector<unsigned> partner_nodes;
+		for (const NodeLink& link : node_list[node_id].node_links)
+		{
+			if (link.disk_id != disk_id)
+				partner_nodes.push_back(link.dest_node_id);
 		}
+
+		for (const unsigned partner_id : partner_nodes)
+			removeNode(partner_id);
+		removeNode(node_id);
 	}
-	search_data = std::vector<NodeSearchData>(node_list.size(), NodeSearchData());
+}
+
+void MovementGraph::initCached(const std::vector<std::unique_ptr<Disk>>& disks, const std::string& world_filename,
+	const std::string& cache_filename)
+{
+	PerformanceCounter p{};
+	p.start();
+	const unsigned long long key = calculateCacheKey(world_filename);
+	if (key != 0 && load(disks, cache_filename, key))
+	{
+		std::cout << "movement graph cache load time: " << p.getCounter() << "ms" << std::endl;
+		return;
+	}
+
+	init(disks);
+	std::cout << "movement graph creation time: " << p.getCounter() << "ms" << std::endl;
+
+	if (key != 0 && !save(cache_filename, key))
+		std::cerr << "Warning: Could not write movement graph cache \"" << cache_filename << "\"" << std::endl;
+}
+
+bool MovementGraph::save(const std::string& filename, unsigned long long key) const
+{
+	const unsigned count = node_list.size();
+
+	GraphCacheHeader header{};
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.key = key;
+	header.disk_count = disk_node_list.size();
+	header.node_count = count;
+
+	std::vector<double> positions(count * 3);
+	std::vector<unsigned> link_starts(count + 1);
+	std::vector<unsigned> disk_ids(count);
+	std::vector<unsigned> link_dests;
+	std::vector<float> link_weights;
+	std::vector<unsigned> disks_in_graph(header.disk_count);
+	link_dests.reserve(node_link_count * 2);
+	link_weights.reserve(node_link_count * 2);
+
+	for (unsigned i = 0; i < count; i++)
+	{
+		const Node& node = node_list[i];
+		positions[i * 3 + 0] = node.position.x;
+		positions[i * 3 + 1] = node.position.y;
+		positions[i * 3 + 2] = node.position.z;
+		disk_ids[i] = node.disk_id;
+		link_starts[i] = link_dests.size();
+		for (const NodeLink& link : node.node_links)
+		{
+			link_dests.push_back(link.dest_node_id);
+			link_weights.push_back(link.weight);
+		}
+	}
+	link_starts[count] = link_dests.size();
+	header.link_count = link_dests.size();
+
+	for (unsigned d = 0; d < header.disk_count; d++)
+		disks_in_graph[d] = disk_grid.contains(d) ? 1 : 0;
+
+	std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) return false;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(positions.data()), positions.size() * sizeof(double));
+	file.write(reinterpret_cast<const char*>(link_starts.data()), link_starts.size() * sizeof(unsigned));
+	file.write(reinterpret_cast<const char*>(disk_ids.data()), disk_ids.size() * sizeof(unsigned));
+	file.write(reinterpret_cast<const char*>(link_dests.data()), link_dests.size() * sizeof(unsigned));
+	file.write(reinterpret_cast<const char*>(link_weights.data()), link_weights.size() * sizeof(float));
+	file.write(reinterpret_cast<const char*>(disks_in_graph.data()), disks_in_graph.size() * sizeof(unsigned));
+	return file.good();
+}
+
+bool MovementGraph::load(const std::vector<std::unique_ptr<Disk>>& disks, const std::string& filename,
+	unsigned long long key)
+{
+	destroy();
+
+	MappedFile file;
+	if (!file.open(filename)) return false;
+	if (file.getSize() < sizeof(GraphCacheHeader)) return false;
+
+	const GraphCacheHeader& header = *reinterpret_cast<const GraphCacheHeader*>(file.getData());
+	if (header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.key != key
+		|| header.disk_count != disks.size())
+		return false;
+
+	const unsigned count = header.node_count;
+	const unsigned link_count = header.link_count;
+	const size_t expected_size = sizeof(GraphCacheHeader) + size_t(count) * 3 * sizeof(double)
+		+ (size_t(count) * 2 + 1 + link_count + header.disk_count) * sizeof(unsigned) + size_t(link_count) * sizeof(float);
+	if (file.getSize() != expected_size) return false;
+
+	//The arrays are read in place from the mapped file and copied into the nodes below
+	const char* data = file.getData() + sizeof(GraphCacheHeader);
+	const double* positions = reinterpret_cast<const double*>(data);
+	data += size_t(count) * 3 * sizeof(double);
+	const unsigned* link_starts = reinterpret_cast<const unsigned*>(data);
+	data += (size_t(count) + 1) * sizeof(unsigned);
+	const unsigned* disk_ids = reinterpret_cast<const unsigned*>(data);
+	data += size_t(count) * sizeof(unsigned);
+	const unsigned* link_dests = reinterpret_cast<const unsigned*>(data);
+	data += size_t(link_count) * sizeof(unsigned);
+	const float* link_weights = reinterpret_cast<const float*>(data);
+	data += size_t(link_count) * sizeof(float);
+	const unsigned* disks_in_graph = reinterpret_cast<const unsigned*>(data);
+
+	//Reject files that would index out of range
+	if (link_starts[count] != link_count) return false;
+	for (unsigned i = 0; i < count; i++)
+	{
+		if (link_starts[i] > link_starts[i + 1]) return false;
+		if (disk_ids[i] != NO_DISK_FOUND && disk_ids[i] >= header.disk_count) return false;
+	}
+	for (unsigned e = 0; e < link_count; e++)
+	{
+		if (link_dests[e] >= count || disk_ids[link_dests[e]] == NO_DISK_FOUND) return false;
+	}
+
+	disk_node_list.resize(header.disk_count);
+	node_list.resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		Node& node = node_list[i];
+		node = Node(i, disk_ids[i], Vector3(positions[i * 3 + 0], positions[i * 3 + 1], positions[i * 3 + 2]));
+
+		//Removed nodes are kept so the ids stay the same
+		if (disk_ids[i] == NO_DISK_FOUND)
+		{
+			free_node_ids.push_back(i);
+			continue;
+		}
+		node_count++;
+		active_node_ids.push_back(i);
+		disk_node_list[disk_ids[i]].push_back(i);
+
+		node.node_links.reserve(link_starts[i + 1] - link_starts[i]);
+		for (unsigned e = link_starts[i]; e < link_starts[i + 1]; e++)
+			node.node_links.emplace_back(i, link_dests[e], disk_ids[link_dests[e]], link_weights[e]);
+	}
+	node_link_count = link_count / 2;
+
+	//Removed disks stay out of the grid so they can be added again
+	disk_grid.init(disk_grid_cell_size);
+	for (unsigned d = 0; d < header.disk_count; d++)
+	{
+		if (disks_in_graph[d] == 0) continue;
+		const Disk& disk = *disks[d];
+		disk_grid.insert(d, float(disk.position.x), float(disk.position.z), disk.radius + collision_offset);
+	}
+	return true;
+}
+
+unsigned long long MovementGraph::calculateCacheKey(const std::string& world_filename)
+{
+	MappedFile file;
+	if (!file.open(world_filename)) return 0;
+
+	//FNV-1a
+	unsigned long long hash = 14695981039346656037ull;
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(file.getData());
+	for (size_t i = 0; i < file.getSize(); i++)
+	{
+		hash ^= data[i];
+		hash *= 1099511628211ull;
+	}
+	hash ^= CACHE_VERSION;
+	hash *= 1099511628211ull;
+
+	//0 means the key could not be calculated
+	return hash == 0 ? 1 : hash;
 }
 
 MovementGraph::~MovementGraph()
@@ -65,13 +392,23 @@ MovementGraph::~MovementGraph()
 	destroy();
 }
 
-std::deque<unsigned> MovementGraph::dijkstraSearch(unsigned node_start_id, unsigned node_end_id)
+void MovementGraph::dijkstraSearch(unsigned node_start_id, unsigned node_end_id, Path& path)
 {
-	resetSearchData();
+	dijkstraSearch(node_start_id, node_end_id, path, search_context);
+}
+
+void MovementGraph::dijkstraSearch(unsigned node_start_id, unsigned node_end_id, Path& path,
+	SearchContext& context) const
+{
+	resetSearchData(context);
+	std::vector<NodeSearchData>& search_data = context.search_data;
+	std::vector<unsigned>& visited_nodes = context.visited_nodes;
+	unsigned& dijkstra_visits = context.dijkstra_visits;
 
 	dijkstra_visits = 0;
-	UpdatablePriorityQueue<float> queue_start;
-	queue_start.setCapacityAndMaximumQueueSize(node_list.size(), node_list.size());
+	visited_nodes.clear();
+	UpdatablePriorityQueue<float>& queue_start = context.open_list_start;
+	resetOpenList(queue_start);
 
 
 	search_data[node_start_id].start.path_node = node_start_id;
@@ -80,17 +417,23 @@ std::deque<unsigned> MovementGraph::dijkstraSearch(unsigned node_start_id, unsig
 		.start.heuristic;
 	queue_start.enqueueOrSetPriority(node_start_id, search_data[node_start_id].start.priority);
 
-
-	while (true)
+	//The open list runs out if the end can not be reached
+	bool found = false;
+	while (!queue_start.isQueueEmpty())
 	{
 		//Current node we are at
 		const unsigned curr = queue_start.peekAndDequeue();
 
 		dijkstra_visits++;
 		//Goal Found, return path
-		if (curr == node_end_id) break;
+		if (curr == node_end_id)
+		{
+			found = true;
+			break;
+		}
 
 		search_data[curr].start.visited = true;
+		visited_nodes.push_back(curr);
 
 		//Look through all linked nodes and update if path is shorter
 		for (auto& link : node_list[curr].node_links)
@@ -114,15 +457,30 @@ std::deque<unsigned> MovementGraph::dijkstraSearch(unsigned node_start_id, unsig
 			}
 		}
 	}
-	return getPath(node_start_id, node_end_id);
+
+	if (found)
+		getPath(context, node_start_id, node_end_id, path);
+	else
+		path.clear();
 }
 
-std::deque<unsigned> MovementGraph::aStarSearch(unsigned node_start_id, unsigned node_end_id)
+void MovementGraph::aStarSearch(unsigned node_start_id, unsigned node_end_id, Path& path)
 {
-	resetSearchDataWithHeuristics(node_start_id, node_end_id);
+	aStarSearch(node_start_id, node_end_id, path, search_context);
+}
+
+void MovementGraph::aStarSearch(unsigned node_start_id, unsigned node_end_id, Path& path,
+	SearchContext& context) const
+{
+	resetSearchDataWithHeuristics(context, node_start_id, node_end_id);
+	std::vector<NodeSearchData>& search_data = context.search_data;
+	std::vector<unsigned>& visited_nodes = context.visited_nodes;
+	unsigned& a_star_visits = context.a_star_visits;
+
 	a_star_visits = 0;
-	UpdatablePriorityQueue<float> queue_start;
-	queue_start.setCapacityAndMaximumQueueSize(node_list.size(), node_list.size());
+	visited_nodes.clear();
+	UpdatablePriorityQueue<float>& queue_start = context.open_list_start;
+	resetOpenList(queue_start);
 
 
 	search_data[node_start_id].start.path_node = node_start_id;
@@ -131,15 +489,22 @@ std::deque<unsigned> MovementGraph::aStarSearch(unsigned node_start_id, unsigned
 		.start.heuristic;
 	queue_start.enqueueOrSetPriority(node_start_id, search_data[node_start_id].start.priority);
 
+	//The open list runs out if the end can not be reached
+	bool found = false;
 	while (!queue_start.isQueueEmpty())
 	{
 		const unsigned curr = queue_start.peekAndDequeue();
 		a_star_visits++;
 		//Goal Found, return path
-		if (curr == node_end_id) break;
+		if (curr == node_end_id)
+		{
+			found = true;
+			break;
+		}
 
 		//This node has been visited
 		search_data[curr].start.visited = true;
+		visited_nodes.push_back(curr);
 
 		//Look through all linked nodes and update if path is shorter
 		for (const NodeLink& link : node_list[curr].node_links)
@@ -167,23 +532,37 @@ std::deque<unsigned> MovementGraph::aStarSearch(unsigned node_start_id, unsigned
 		}
 	}
 
-	return getPath(node_start_id, node_end_id);
+	if (found)
+		getPath(context, node_start_id, node_end_id, path);
+	else
+		path.clear();
+}
+
+void MovementGraph::mmSearch(unsigned node_start_id, unsigned node_end_id, Path& path)
+{
+	mmSearch(node_start_id, node_end_id, path, search_context);
 }
 
-std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned node_end_id)
+void MovementGraph::mmSearch(unsigned node_start_id, unsigned node_end_id, Path& path,
+	SearchContext& context) const
 {
 	//Clear search data and fill heuristics
-	resetSearchDataWithHeuristics(node_start_id, node_end_id);
+	resetSearchDataWithHeuristics(context, node_start_id, node_end_id);
+	std::vector<NodeSearchData>& search_data = context.search_data;
+	std::vector<unsigned>& visited_nodes = context.visited_nodes;
+	unsigned& mm_visits = context.mm_visits;
+
 	mm_visits = 0;
+	visited_nodes.clear();
 	//Open List 1
-	UpdatablePriorityQueue<float> queue_start;
+	UpdatablePriorityQueue<float>& queue_start = context.open_list_start;
 	//Open List 2
-	UpdatablePriorityQueue<float> queue_end;
+	UpdatablePriorityQueue<float>& queue_end = context.open_list_end;
 	//Current Node
 	unsigned curr = NO_VERTEX_FOUND;
 
-	queue_start.setCapacityAndMaximumQueueSize(node_list.size(), node_list.size());
-	queue_end.setCapacityAndMaximumQueueSize(node_list.size(), node_list.size());
+	resetOpenList(queue_start);
+	resetOpenList(queue_end);
 
 	//Add start node to Open List 1
 	search_data[node_start_id].start.path_node = node_start_id;
@@ -199,7 +578,8 @@ std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned no
 		+ search_data[node_end_id].end.heuristic;
 	queue_end.enqueueOrSetPriority(node_end_id, search_data[node_end_id].end.priority);
 
-	//If both are empty no path found
+	//If either is empty its side has been searched without meeting the other, so there is no path
+	bool found = false;
 	while (!queue_start.isQueueEmpty() && !queue_end.isQueueEmpty())
 	{
 		//Look at both open lists
@@ -218,7 +598,11 @@ std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned no
 		{
 			curr = queue_start.peekAndDequeue();
 			//Goal Found if node is on opposite closed list
-			if (search_data[curr].end.visited) break;
+			if (search_data[curr].end.visited)
+			{
+				found = true;
+				break;
+			}
 
 			//Get the seach data from correct direction
 			curr_node_search_data = &(search_data[curr].start);
@@ -227,7 +611,11 @@ std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned no
 		{
 			curr = queue_end.peekAndDequeue();
 			//Goal Found if node is on opposite closed list
-			if (search_data[curr].start.visited) break;
+			if (search_data[curr].start.visited)
+			{
+				found = true;
+				break;
+			}
 
 			//Get the seach data from correct direction
 			curr_node_search_data = &(search_data[curr].end);
@@ -240,6 +628,7 @@ std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned no
 		//Mark this node as visited
 		//Put it on the closed list
 		curr_node_search_data->visited = true;
+		visited_nodes.push_back(curr);
 
 		//Look through all linked nodes and update if path is shorter
 		for (const NodeLink& link : node_list[curr].node_links)
@@ -273,26 +662,34 @@ std::deque<unsigned> MovementGraph::mmSearch(unsigned node_start_id, unsigned no
 			}
 		}
 	}
+	if (!found)
+	{
+		path.clear();
+		return;
+	}
+
 	//The current node is the meet in the middle node
 	//Mark that it has visited from both direction
 	//It is on both Closed List 1 and 2
+	if (!search_data[curr].start.visited && !search_data[curr].end.visited)
+		visited_nodes.push_back(curr);
 	search_data[curr].end.visited = true;
 	search_data[curr].start.visited = true;
 
 	//Build and return the path
-	return getmmPath(node_start_id, curr, node_end_id);
+	getmmPath(context, node_start_id, curr, node_end_id, path);
 }
 
-float MovementGraph::getPathCost(std::deque<unsigned> q) const
+float MovementGraph::getPathCost(const Path& path) const
 {
-	if (q.empty()) return 0;
+	if (path.empty()) return 0;
 	float cost = 0;
-	for (unsigned i = 0; i < q.size() - 1; i++)
+	for (unsigned i = 0; i < path.size() - 1; i++)
 	{
 		//find link
-		for (const auto j : node_list[q[i]].node_links)
+		for (const auto j : node_list[path[i]].node_links)
 		{
-			if (j.dest_node_id == q[i + 1])
+			if (j.dest_node_id == path[i + 1])
 				cost += j.weight;
 		}
 	}
@@ -301,13 +698,22 @@ float MovementGraph::getPathCost(std::deque<unsigned> q) const
 
 void MovementGraph::memorizeLastSearch()
 {
-	memorized_a_star_visits = a_star_visits;
-	memorized_dijkstra_visits = dijkstra_visits;
-	memorized_mm_visits = mm_visits;
-	memorized_search_data = search_data;
+	memorizeLastSearch(search_context);
+}
+
+void MovementGraph::memorizeLastSearch(const SearchContext& context)
+{
+	memorized_a_star_visits = context.a_star_visits;
+	memorized_dijkstra_visits = context.dijkstra_visits;
+	memorized_mm_visits = context.mm_visits;
+
+	//Only the visited nodes are copied, the vector keeps its capacity between searches
+	memorized_search_data.clear();
+	for (const unsigned node_id : context.visited_nodes)
+		memorized_search_data.emplace_back(node_id, context.search_data[node_id]);
 }
 
-const std::vector<NodeSearchData>& MovementGraph::getMemorizedSearchData() const
+const std::vector<MemorizedNode>& MovementGraph::getMemorizedSearchData() const
 {
 	return memorized_search_data;
 }
@@ -332,6 +738,16 @@ const std::vector<Node>& MovementGraph::getNodeList() const
 	return node_list;
 }
 
+const std::vector<unsigned>& MovementGraph::getActiveNodeIds() const
+{
+	return active_node_ids;
+}
+
+bool MovementGraph::isNodeActive(unsigned node_id) const
+{
+	return node_id < node_list.size() && node_list[node_id].disk_id != NO_DISK_FOUND;
+}
+
 unsigned MovementGraph::getNodeCount() const
 {
 	return node_count;
@@ -342,60 +758,79 @@ unsigned MovementGraph::getNodeLinkCount() const
 	return node_link_count;
 }
 
-std::deque<unsigned> MovementGraph::getPath(unsigned node_start_id, unsigned node_end_id)
+void MovementGraph::getPath(const SearchContext& context, unsigned node_start_id, unsigned node_end_id, Path& path)
 {
-	std::deque<unsigned> path;
+	const std::vector<NodeSearchData>& search_data = context.search_data;
+
+	//Walk back from the end so each node goes before the previous one
+	path.clear();
 	while (node_end_id != node_start_id)
 	{
-		path.push_front(node_end_id);
+		path.pushFront(node_end_id);
 		node_end_id = search_data[node_end_id].start.path_node;
 	}
-
-	return path;
 }
 
-std::deque<unsigned> MovementGraph::getmmPath(unsigned node_start_id, unsigned node_meeting_id,
-	unsigned node_end_id)
+void MovementGraph::getmmPath(const SearchContext& context, unsigned node_start_id, unsigned node_meeting_id,
+	unsigned node_end_id, Path& path)
 {
-	std::deque<unsigned> path;
+	const std::vector<NodeSearchData>& search_data = context.search_data;
 
-	//Start at middle and go to start for path
-	unsigned curr_node = node_meeting_id;
-
-	//Note: This won't push the start node because it is not part of the path
-	while (curr_node != node_start_id)
-	{
-		path.push_front(curr_node);
-		curr_node = search_data[curr_node].start.path_node;
-	}
+	path.clear();
 
 	//Start at middle and go to end for path
-	curr_node = node_meeting_id;
+	unsigned curr_node = node_meeting_id;
 
-	//Skip the meeting node here so we dont push it on the queue twice
+	//Skip the meeting node here so we dont push it on the path twice
 	if (curr_node != node_end_id)
 		curr_node = search_data[curr_node].end.path_node;
 
 	while (curr_node != node_end_id)
 	{
-		path.push_back(curr_node);
+		path.pushFront(curr_node);
 		curr_node = search_data[curr_node].end.path_node;
 	}
 
 	//Push the end node
-	path.push_back(node_end_id);
+	path.pushFront(node_end_id);
 
-	return path;
+	//This half was walked towards the end so flip it
+	path.reverse();
+
+	//Start at middle and go to start for path
+	curr_node = node_meeting_id;
+
+	//Note: This won't push the start node because it is not part of the path
+	while (curr_node != node_start_id)
+	{
+		path.pushFront(curr_node);
+		curr_node = search_data[curr_node].start.path_node;
+	}
+}
+
+void MovementGraph::resetOpenList(UpdatablePriorityQueue<float>& open_list) const
+{
+	//Only reallocate when the graph has grown or shrunk since the last search
+	if (open_list.getCapacity() != node_list.size())
+		open_list.setCapacityAndMaximumQueueSize(node_list.size(), node_list.size());
+	else
+		open_list.clear();
 }
 
-void MovementGraph::resetSearchData()
+void MovementGraph::resetSearchData(SearchContext& context) const
 {
+	//Resizing only allocates when the graph has grown since the context was last used
+	std::vector<NodeSearchData>& search_data = context.search_data;
+	search_data.resize(node_list.size());
 	for (auto& node : search_data)
 		node.init();
 }
 
-void MovementGraph::resetSearchDataWithHeuristics(unsigned node_start_id, unsigned node_end_id)
+void MovementGraph::resetSearchDataWithHeuristics(SearchContext& context, unsigned node_start_id,
+	unsigned node_end_id) const
 {
+	std::vector<NodeSearchData>& search_data = context.search_data;
+	search_data.resize(node_list.size());
 	for (unsigned i = 0; i < search_data.size(); i++)
 	{
 		search_data[i].start.init();
@@ -406,19 +841,101 @@ void MovementGraph::resetSearchDataWithHeuristics(unsigned node_start_id, unsign
 	}
 }
 
-float MovementGraph::heuristicCostEstimate(unsigned link_node_id, unsigned node_end_id)
+float MovementGraph::heuristicCostEstimate(unsigned link_node_id, unsigned node_end_id) const
 {
 	return float(node_list[link_node_id].position.getDistance(node_list[node_end_id].position));
 }
 
 unsigned MovementGraph::addNode(const Vector3& position, unsigned disk_index)
 {
-	const unsigned id = node_list.size();
-	node_list.emplace_back(id, disk_index, position);
+	unsigned id;
+	if (!free_node_ids.empty())
+	{
+		id = free_node_ids.back();
+		free_node_ids.pop_back();
+		node_list[id] = Node(id, disk_index, position);
+	} else
+	{
+		id = node_list.size();
+		node_list.emplace_back(id, disk_index, position);
+	}
 	node_count++;
+	active_node_ids.insert(std::lower_bound(active_node_ids.begin(), active_node_ids.end(), id), id);
 	return id;
 }
 
+void MovementGraph::removeNode(unsigned node_id)
+{
+	Node& node = node_list[node_id];
+
+	//Remove the links pointing back to this node
+	for (const NodeLink& link : node.node_links)
+	{
+		std::vector<NodeLink>& dest_links = node_list[link.dest_node_id].node_links;
+		dest_links.erase(std::remove_if(dest_links.begin(), dest_links.end(),
+			[node_id](const NodeLink& l) { return l.dest_node_id == node_id; }), dest_links.end());
+		node_link_count--;
+	}
+
+	std::vector<unsigned>& disk_nodes = disk_node_list[node.disk_id];
+	disk_nodes.erase(std::remove(disk_nodes.begin(), disk_nodes.end(), node_id), disk_nodes.end());
+
+	node.node_links.clear();
+	node.disk_id = NO_DISK_FOUND;
+
+	free_node_ids.push_back(node_id);
+	node_count--;
+	active_node_ids.erase(std::lower_bound(active_node_ids.begin(), active_node_ids.end(), node_id));
+}
+
+void MovementGraph::initDiskGrid(const std::vector<std::unique_ptr<Disk>>& disks)
+{
+	disk_grid.init(disk_grid_cell_size);
+	for (unsigned i = 0; i < disks.size(); i++)
+	{
+		const Disk& disk = *disks[i];
+		disk_grid.insert(i, float(disk.position.x), float(disk.position.z), disk.radius + collision_offset);
+	}
+}
+
+bool MovementGraph::isDiskOverlap(const Disk& disk_i, const Disk& disk_j) const
+{
+	return Collision::circleIntersection(
+		float(disk_i.position.x), float(disk_i.position.z), disk_i.radius + collision_offset,
+		float(disk_j.position.x), float(disk_j.position.z), disk_j.radius + collision_offset);
+}
+
+void MovementGraph::linkDisks(const std::vector<std::unique_ptr<Disk>>& disks, unsigned disk_id_i, unsigned disk_id_j)
+{
+	const unsigned i = disk_id_i;
+	const unsigned j = disk_id_j;
+	const Disk& disk_i = *disks[i];
+	const Disk& disk_j = *disks[j];
+
+	const Vector3 position_i = calculateNodePosition(disk_i, disk_j);
+	const Vector3 position_j = calculateNodePosition(disk_j, disk_i);
+
+	unsigned node_id_i = addNode(position_i, i);
+	unsigned node_id_j = addNode(position_j, j);
+
+	const float weight_ij = calculateWeightBetweenDisks(disks, node_id_i, node_id_j);
+	addLink(i, node_id_i, j, node_id_j, weight_ij);
+
+	for (auto& node_id_k : disk_node_list[i])
+	{
+		const float weight_ik = calculateWeightSameDisk(disks, node_id_i, node_id_k);
+		addLink(i, node_id_i, node_list[node_id_k].disk_id, node_id_k, weight_ik);
+	}
+	for (auto& node_id_k : disk_node_list[j])
+	{
+		const float weight_jk = calculateWeightSameDisk(disks, node_id_j, node_id_k);
+		addLink(j, node_id_j, node_list[node_id_k].disk_id, node_id_k, weight_jk);
+	}
+
+	disk_node_list[i].push_back(node_id_i);
+	disk_node_list[j].push_back(node_id_j);
+}
+
 void MovementGraph::addLink(unsigned disk_id_i, unsigned node_id_i, unsigned disk_id_j, unsigned node_id_j,
 	float weight)
 {
@@ -1,11 +1,15 @@
 #pragma once
 #include "Collision.h"
-#include <deque>
 #include <memory>
+#include <string>
 #include "Disk.h"
+#include "SpatialGrid.h"
+#include "Path.h"
+#include "UpdatablePriorityQueue.h"
 
 static const float HIGH_VALUE = FLT_MAX;
 static const unsigned NO_VERTEX_FOUND = -1;
+static const unsigned NO_DISK_FOUND = -1;
 
 //The acquired search data per node when a search algorith is run
 struct SearchData
@@ -40,6 +44,38 @@ struct NodeSearchData
 	void init() { start.init(); end.init(); }
 };
 
+//The search data of a node that was visited in a memorized search
+struct MemorizedNode
+{
+	unsigned node_id{};
+	NodeSearchData search_data{};
+
+	MemorizedNode() = default;
+	MemorizedNode(unsigned node_id, const NodeSearchData& search_data)
+		: node_id(node_id), search_data(search_data)
+	{};
+};
+
+//The working memory of a search
+//Searches using different contexts can run on different threads at the same time
+struct SearchContext
+{
+	//The search data used for pathfinding
+	std::vector<NodeSearchData> search_data{};
+
+	//The nodes put on a closed list by the last search
+	std::vector<unsigned> visited_nodes{};
+
+	//The open lists used by the searches, kept between searches to reuse their memory
+	UpdatablePriorityQueue<float> open_list_start{};
+	UpdatablePriorityQueue<float> open_list_end{};
+
+	//Counters to see how each algorithm performs
+	unsigned a_star_visits{};
+	unsigned dijkstra_visits{};
+	unsigned mm_visits{};
+};
+
 struct NodeLink;
 
 //The data of each node in the movement graph
@@ -78,20 +114,21 @@ private:
 	//Offset for collision checking to include disks almost touching
 	const float collision_offset = 0.1f;
 	const float node_offset = 0.7f;
+	//Width of the cells in the disk grid
+	const float disk_grid_cell_size = 16.0f;
 
-	//The search data used for pathfinding
-	std::vector<NodeSearchData> search_data{};
+	//Identifies graph cache files and their layout
+	static const unsigned CACHE_MAGIC = 0x4647474D; //"MGGF"
+	static const unsigned CACHE_VERSION = 1;
 
-	//Counters to see how each algorithm performs
-	unsigned a_star_visits{};
-	unsigned dijkstra_visits{};
-	unsigned mm_visits{};
+	//Used by the searches that are not given a context
+	SearchContext search_context{};
 
 	unsigned node_count{};
 	unsigned node_link_count{};
 
-	//The data after a search memorization is called
-	std::vector<NodeSearchData> memorized_search_data{};
+	//The data of the visited nodes after a search memorization is called
+	std::vector<MemorizedNode> memorized_search_data{};
 	unsigned memorized_a_star_visits{};
 	unsigned memorized_dijkstra_visits{};
 	unsigned memorized_mm_visits{};
@@ -102,6 +139,15 @@ private:
 	//The list of nodes of the graph
 	std::vector<Node> node_list;
 
+	//Ids of removed nodes that can be reused so the other node ids stay stable
+	std::vector<unsigned> free_node_ids;
+
+	//Ids of the nodes that have not been removed, in increasing order
+	std::vector<unsigned> active_node_ids;
+
+	//The disks in the graph bucketed by position to find overlapping disks
+	SpatialGrid disk_grid;
+
 public:
 
 	MovementGraph() = default;
@@ -109,30 +155,67 @@ public:
 	//Initilize the Node and Node Links of the movement graph using the disks data
 	void init(const std::vector<std::unique_ptr<Disk>>& disks);
 
+	//Adds the nodes and links for a disk that has been added to the disks vector
+	//Only the disks overlapping it are linked so the cost depends on its neighbourhood
+	void addDisk(const std::vector<std::unique_ptr<Disk>>& disks, unsigned disk_id);
+
+	//Removes the nodes of a disk and the nodes its neighbours had towards it
+	//The removed node ids are reused by later additions, all other node ids are unchanged
+	void removeDisk(unsigned disk_id);
+
+	//Loads the graph from the cache file if it was saved for the same world file
+	//Otherwise builds the graph with init and saves it to the cache file
+	void initCached(const std::vector<std::unique_ptr<Disk>>& disks, const std::string& world_filename,
+		const std::string& cache_filename);
+
+	//Writes the nodes and links to a binary cache file tagged with a key
+	//Links are stored in compressed sparse row order. Returns false if the file could not be written
+	bool save(const std::string& filename, unsigned long long key) const;
+
+	//Reads the nodes and links from a memory mapped cache file
+	//The links are copied out of the file into each node's node_links, because the searches and
+	//addDisk/removeDisk work on those. For 8000 disks (27000 nodes, 56200 links) loading takes
+	//about 11ms against about 24ms for init, most of it making the per node link vectors
+	//Returns false and leaves the graph empty if the file is missing, invalid, or has a different key
+	bool load(const std::vector<std::unique_ptr<Disk>>& disks, const std::string& filename, unsigned long long key);
+
+	//Returns the key a graph built from a world file is cached under
+	//It is a hash of the file contents and the cache version. Returns 0 if the file can not be read
+	static unsigned long long calculateCacheKey(const std::string& world_filename);
+
 	//Clean up the vectors of data and clear variables
 	~MovementGraph();
 	void destroy();
 
 
+	//The search functions fill path with the nodes after the start node up to the end node
+	//The path's memory is reused so searching into the same path again does not allocate
+	//Searches given a context only read the graph, so each thread can search with its own context
+	//If the end can not be reached from the start the path is left empty
+
 	//Performs dijstra's search algorithm to find optimal path between 2 nodes
-	std::deque<unsigned> dijkstraSearch(unsigned node_start_id, unsigned node_end_id);
+	void dijkstraSearch(unsigned node_start_id, unsigned node_end_id, Path& path);
+	void dijkstraSearch(unsigned node_start_id, unsigned node_end_id, Path& path, SearchContext& context) const;
 
 	//Performs A* search algorithm to find optimal path between 2 nodes
 	//Uses the 3D distance between the nodes as the heuristic
-	std::deque<unsigned> aStarSearch(unsigned node_start_id, unsigned node_end_id);
+	void aStarSearch(unsigned node_start_id, unsigned node_end_id, Path& path);
+	void aStarSearch(unsigned node_start_id, unsigned node_end_id, Path& path, SearchContext& context) const;
 
 	//Performs double ended A* search algorithm to find optimal path between 2 nodes
 	//Uses the 3D distance between the nodes as the heuristic
-	std::deque<unsigned> mmSearch(unsigned node_start_id, unsigned node_end_id);
+	void mmSearch(unsigned node_start_id, unsigned node_end_id, Path& path);
+	void mmSearch(unsigned node_start_id, unsigned node_end_id, Path& path, SearchContext& context) const;
 
 	//Returns the total cost given a path that was the result of a search
-	float getPathCost(std::deque<unsigned> q) const;
+	float getPathCost(const Path& path) const;
 
-	//Memorizes the search data of the last search that was completed
+	//Memorizes the search data of the nodes visited by the last search that was completed
 	void memorizeLastSearch();
+	void memorizeLastSearch(const SearchContext& context);
 
-	//Returns the search data of the last search that was completed
-	const std::vector<NodeSearchData>& getMemorizedSearchData() const;
+	//Returns the search data of the nodes visited by the memorized search
+	const std::vector<MemorizedNode>& getMemorizedSearchData() const;
 
 	//Returns the number of nodes that were visited (put on closed list) for each of the
 	//search algorithms after they have been memorized
@@ -143,6 +226,12 @@ public:
 	//Returns the node list
 	const std::vector<Node>& getNodeList() const;
 
+	//Returns the ids of the nodes that have not been removed, in increasing order
+	const std::vector<unsigned>& getActiveNodeIds() const;
+
+	//Returns if the node id belongs to a node that has not been removed
+	bool isNodeActive(unsigned node_id) const;
+
 	//Returns number of nodes (vertices) in the graph
 	unsigned getNodeCount() const;
 
@@ -152,24 +241,42 @@ public:
 private:
 	//Helpers for Search functions
 
-	//Builds and returns the path after a search has been performed
-	std::deque<unsigned> getPath(unsigned node_start_id, unsigned node_end_id);
-	std::deque<unsigned> getmmPath(unsigned node_start_id, unsigned node_meeting_id, unsigned node_end_id);
+	//Builds the path after a search has been performed
+	static void getPath(const SearchContext& context, unsigned node_start_id, unsigned node_end_id, Path& path);
+	static void getmmPath(const SearchContext& context, unsigned node_start_id, unsigned node_meeting_id,
+		unsigned node_end_id, Path& path);
 
-	//Clears the search data
-	void resetSearchData();
+	//Empties an open list and sizes it to the node list
+	void resetOpenList(UpdatablePriorityQueue<float>& open_list) const;
+
+	//Clears the search data and sizes it to the node list
+	void resetSearchData(SearchContext& context) const;
 	//Clears the search data and updates all of the nodes with their heuristic data
 	//based on the start and end nodes
-	void resetSearchDataWithHeuristics(unsigned node_start_id, unsigned node_end_id);
+	void resetSearchDataWithHeuristics(SearchContext& context, unsigned node_start_id, unsigned node_end_id) const;
 
 	//Returns the heurisitic cost which 3D distance between the nodes
-	float heuristicCostEstimate(unsigned link_node_id, unsigned node_end_id);
+	float heuristicCostEstimate(unsigned link_node_id, unsigned node_end_id) const;
 
 	//Helpers to initialized Movement graph
 
 	//Adds a node at a position for a disk
+	//Reuses the id of a removed node if there is one
 	unsigned addNode(const Vector3& position, unsigned disk_index);
 
+	//Removes a node and all links to it and puts its id on the free list
+	void removeNode(unsigned node_id);
+
+	//Puts every disk in the disk grid
+	void initDiskGrid(const std::vector<std::unique_ptr<Disk>>& disks);
+
+	//Returns if two disks are close enough to be linked
+	bool isDiskOverlap(const Disk& disk_i, const Disk& disk_j) const;
+
+	//Adds a node on each of two overlapping disks, links them together
+	//and links each to the other nodes already on its disk
+	void linkDisks(const std::vector<std::unique_ptr<Disk>>& disks, unsigned disk_id_i, unsigned disk_id_j);
+
 	//Adds the link between two nodes with a given weight
 	//A link is added on both nodes to the other node
 	void addLink(unsigned disk_id_i, unsigned node_id_i, unsigned disk_id_j, unsigned node_id_j, float weight);
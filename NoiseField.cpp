@@ -1,5 +1,6 @@
 #include "NoiseField.h"
 #include <cmath>
+#include <climits>
 
 NoiseField::NoiseField(float grid_size, float a, unsigned x1, unsigned x2, unsigned y1, unsigned y2, unsigned q0, unsigned q1,
 	unsigned q2)
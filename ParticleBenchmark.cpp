@@ -0,0 +1,174 @@
+#include "ParticleBenchmark.h"
+#include <algorithm>
+#include <iomanip>
+#include "HeadlessRunner.h"
+#include "JobSystem.h"
+#include "PerformanceCounter.h"
+#include "World.h"
+#include "Globals.h"
+
+bool ParticleBenchmark::parseCase(const std::string& name, Bench_Case& bench_case)
+{
+	if (name == "idle")
+		bench_case = Bench_Case::IDLE;
+	else if (name == "burst")
+		bench_case = Bench_Case::BURST;
+	else if (name == "saturation")
+		bench_case = Bench_Case::SATURATION;
+	else if (name == "sort")
+		bench_case = Bench_Case::SORT;
+	else
+		return false;
+	return true;
+}
+
+void ParticleBenchmark::setWorld(const World* world)
+{
+	this->world = world;
+}
+
+void ParticleBenchmark::run(ParticleEmitter& emitter, Bench_Case bench_case, unsigned tick_count)
+{
+	switch (bench_case)
+	{
+	case Bench_Case::IDLE: case_name = "idle"; break;
+	case Bench_Case::BURST: case_name = "burst"; break;
+	case Bench_Case::SATURATION: case_name = "saturation"; break;
+	case Bench_Case::SORT: case_name = "sort"; break;
+	}
+
+	emitter.clear();
+	emitter.setCollisionWorld(world);
+	tick_times.clear();
+	tick_times.reserve(tick_count);
+	live_counts.clear();
+	live_counts.reserve(tick_count);
+	sort_times.clear();
+
+	//Effects are sized from the camera of the last update, so it is above the first explosion before it
+	glm::vec3 camera_position = getExplosionPosition(0) + CAMERA_OFFSET;
+	emitter.update(FRAME_TIME_UPDATE, camera_position);
+	const ParticleCounters start_counters = emitter.getCounters();
+
+	//Every particle is high priority, so the whole of a MAX_PARTICLES budget is filled
+	//They live one tick longer than the case, a longer life would make the effect's reach cover the whole world
+	const unsigned start_budget = emitter.getParticleBudget();
+	if (bench_case == Bench_Case::SORT)
+	{
+		sort_times.reserve(tick_count);
+		emitter.setParticleBudget(MAX_PARTICLES);
+		emitter.addEffect(MAX_PARTICLES, getExplosionPosition(0), 0.03f, glm::vec4(1, 1, 0.5, 1), float((tick_count + 1) * FRAME_TIME_UPDATE),
+			Particle_Pattern::Random, 1.5f, 0.15f, Particle_Priority::High);
+	}
+
+	PerformanceCounter counter;
+	unsigned explosion_count = 0;
+	for (unsigned tick = 0; tick < tick_count; tick++)
+	{
+		counter.start();
+		if (bench_case == Bench_Case::SATURATION || (bench_case == Bench_Case::BURST && tick % BURST_INTERVAL == 0))
+		{
+			addExplosion(emitter, explosion_count++);
+			camera_position = getExplosionPosition(explosion_count) + CAMERA_OFFSET;
+		}
+		emitter.update(FRAME_TIME_UPDATE, camera_position);
+		emitter.copyParticleData(particle_data, particle_origin);
+		tick_times.push_back(counter.getCounter());
+		live_counts.push_back(unsigned(particle_data.size()));
+
+		//The sort only reads what the update left, so running it again gives the same order
+		if (bench_case == Bench_Case::SORT)
+		{
+			counter.start();
+			emitter.sortParticles();
+			sort_times.push_back(counter.getCounter());
+		}
+	}
+
+	particle_budget = emitter.getParticleBudget();
+	emitter.setParticleBudget(start_budget);
+	const ParticleCounters& end_counters = emitter.getCounters();
+	counters.requested = end_counters.requested - start_counters.requested;
+	counters.spawned = end_counters.spawned - start_counters.spawned;
+	counters.culled_by_distance = end_counters.culled_by_distance - start_counters.culled_by_distance;
+	counters.culled_by_budget = end_counters.culled_by_budget - start_counters.culled_by_budget;
+}
+
+void ParticleBenchmark::printReport(std::ostream& out) const
+{
+	if (tick_times.empty())
+	{
+		out << "No ticks were run" << std::endl;
+		return;
+	}
+
+	std::vector<double> sorted_times = tick_times;
+	std::sort(sorted_times.begin(), sorted_times.end());
+	double total = 0.0;
+	for (double time : tick_times)
+		total += time;
+	unsigned long long live_total = 0;
+	for (unsigned count : live_counts)
+		live_total += count;
+	const double requested = double(std::max(counters.requested, 1ull));
+
+	out << std::fixed << std::setprecision(4);
+	out << "Particle benchmark: " << case_name << ", " << tick_times.size() << " ticks of " << FRAME_TIME_UPDATE << " ms, "
+		<< g_job_system.getThreadCount() << " job threads" << (world ? ", colliding with the world" : "") << std::endl;
+	out << "Tick time (ms): mean " << total / tick_times.size()
+		<< "  min " << sorted_times.front()
+		<< "  median " << HeadlessRunner::getPercentile(sorted_times, 0.5)
+		<< "  95% " << HeadlessRunner::getPercentile(sorted_times, 0.95)
+		<< "  99% " << HeadlessRunner::getPercentile(sorted_times, 0.99)
+		<< "  max " << sorted_times.back() << std::endl;
+	out << std::setprecision(0);
+	out << "Live particles: mean " << double(live_total) / live_counts.size()
+		<< "  peak " << *std::max_element(live_counts.begin(), live_counts.end())
+		<< "  budget " << particle_budget << std::endl;
+	out << "Particles requested " << counters.requested << "  spawned " << counters.spawned
+		<< std::setprecision(1)
+		<< "  culled by distance " << 100.0 * counters.culled_by_distance / requested << "%"
+		<< "  culled by budget " << 100.0 * counters.culled_by_budget / requested << "%" << std::endl;
+
+	if (!sort_times.empty())
+	{
+		std::vector<double> sorted_sort_times = sort_times;
+		std::sort(sorted_sort_times.begin(), sorted_sort_times.end());
+		double sort_total = 0.0;
+		for (double time : sort_times)
+			sort_total += time;
+
+		out << std::setprecision(4);
+		out << "Sort time (ms): mean " << sort_total / sort_times.size()
+			<< "  median " << HeadlessRunner::getPercentile(sorted_sort_times, 0.5)
+			<< "  95% " << HeadlessRunner::getPercentile(sorted_sort_times, 0.95)
+			<< "  max " << sorted_sort_times.back() << std::endl;
+		out << "Sort budget " << SORT_BUDGET_MS << " ms: 95% of sorts "
+			<< (HeadlessRunner::getPercentile(sorted_sort_times, 0.95) <= SORT_BUDGET_MS ? "within" : "over") << " budget" << std::endl;
+	}
+}
+
+void ParticleBenchmark::addExplosion(ParticleEmitter& emitter, unsigned explosion) const
+{
+	const glm::vec3 position = getExplosionPosition(explosion);
+
+	static const glm::vec4 COLORS[EXPLOSION_EFFECTS] =
+	{
+		glm::vec4(0.5, 1, 0.5, 1), glm::vec4(1, 0.5, 0.5, 1), glm::vec4(0.5, 0.5, 1, 1),
+		glm::vec4(1, 1, 0.5, 1), glm::vec4(0.5, 1, 1, 1), glm::vec4(1, 0.5, 1, 1),
+	};
+	for (const glm::vec4& color : COLORS)
+		emitter.addEffect(EXPLOSION_PARTICLES, position, 0.03f, color, 2500.0f, Particle_Pattern::Random, 1.5f, 0.15f);
+}
+
+glm::vec3 ParticleBenchmark::getExplosionPosition(unsigned explosion) const
+{
+	if (!world || world->disks.empty())
+		return glm::vec3(0.0f);
+
+	//Each explosion is above the center of the next disk, where a ring would be picked up
+	const Disk& disk = *world->disks[explosion % world->disks.size()];
+	const float x = float(disk.position.x);
+	const float z = float(disk.position.z);
+	return glm::vec3(x, world->getHeightAtPointPosition(x, z) + 1.0f, z);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ostream>
+#include "lib/glm/glm.hpp"
+#include "ParticleEmitter.h"
+
+class World;
+
+//Times the particle emitter without a window or OpenGL context
+//Each case adds pickup explosions the way the game does for a number of ticks of FRAME_TIME_UPDATE.
+//A tick adds the case's effects, updates the emitter and copies its GPU data like a snapshot does,
+//and is timed as a whole. Used to compare changes to the particles on the same machine
+class ParticleBenchmark
+{
+public:
+	enum class Bench_Case
+	{
+		//No particles, the cost of an update with nothing to do
+		IDLE,
+		//One explosion every BURST_INTERVAL ticks, like picking up a ring now and then
+		BURST,
+		//One explosion every tick, so the particle budget stays full
+		SATURATION,
+		//MAX_PARTICLES live particles that last the whole case, the sort is also timed on its own
+		SORT,
+	};
+
+private:
+	//An explosion is EXPLOSION_EFFECTS effects of EXPLOSION_PARTICLES particles,
+	//the same as PickupManager::pickupParticleExplosion
+	static const unsigned EXPLOSION_EFFECTS = 6;
+	static const unsigned EXPLOSION_PARTICLES = 500;
+	static const unsigned BURST_INTERVAL = 160;
+	//The longest the sort may take at MAX_PARTICLES, in milliseconds
+	const double SORT_BUDGET_MS = 1.0;
+
+	//The camera moves above the next explosion after each one, like the player heading to the next ring
+	const glm::vec3 CAMERA_OFFSET = glm::vec3(0.0f, 10.0f, 0.0f);
+
+	//Explosions are spread over the disks of the world, or all at the origin without one
+	const World* world{};
+
+	std::string case_name;
+	std::vector<double> tick_times;
+	//The time of sortParticles alone after each tick of the sort case
+	std::vector<double> sort_times;
+	std::vector<unsigned> live_counts;
+	unsigned particle_budget{};
+	ParticleCounters counters;
+
+	//Holds the GPU data copied each tick, like the snapshot's
+	std::vector<ParticleVertex> particle_data;
+	glm::vec3 particle_origin;
+
+public:
+	ParticleBenchmark() = default;
+
+	//Returns false if the name is not a case
+	static bool parseCase(const std::string& name, Bench_Case& bench_case);
+
+	//Particles bounce off the world's disks and explosions are spread over them
+	//nullptr puts every explosion at the origin with no ground to bounce off
+	void setWorld(const World* world);
+
+	//Clears the emitter and runs a case on it for a number of ticks
+	void run(ParticleEmitter& emitter, Bench_Case bench_case, unsigned tick_count);
+
+	//Writes the tick time statistics, the live particle counts and how many particles were culled
+	//The sort case also writes the sort time statistics against SORT_BUDGET_MS
+	void printReport(std::ostream& out) const;
+
+private:
+	//Adds one explosion, the nth of the case
+	void addExplosion(ParticleEmitter& emitter, unsigned explosion) const;
+
+	//Returns the position of the nth explosion of the case
+	glm::vec3 getExplosionPosition(unsigned explosion) const;
+};
@@ -1,4 +1,12 @@
 #include "ParticleEmitter.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include "JobSystem.h"
+#include "Globals.h"
+#include "World.h"
+
+extern JobSystem g_job_system;
 
 void ParticleEmitter::init()
 {
@@ -10,6 +18,7 @@ void ParticleEmitter::init()
 	view_projection_matrix_id = glGetUniformLocation(shader_program_id, "view_projection_matrix");
 	camera_right_worldspace_id = glGetUniformLocation(shader_program_id, "camera_right_worldspace");
 	camera_up_worldspace_id = glGetUniformLocation(shader_program_id, "camera_up_worldspace");
+	particle_origin_id = glGetUniformLocation(shader_program_id, "particle_origin");
 
 	// The VBO containing the 4 vertices of the particles.
 	static const GLfloat vertex_buffer_data[] = {
@@ -27,35 +36,26 @@ void ParticleEmitter::init()
 	glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_buffer_data), vertex_buffer_data, GL_STATIC_DRAW);
 
 	// The VBO containing the positions and sizes of the particles
-	glGenBuffers(1, &VBO_particles);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO_particles);
-	// Initialize with empty (NULL) buffer : it will be updated later, each frame.
-	glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES * 8 * sizeof(GLfloat), NULL, GL_STREAM_DRAW);
+	// Each region holds every particle so each upload is one write
+	particle_stream.init(sizeof(ParticleVertex), MAX_PARTICLES);
 
 	// 1rst attribute buffer : vertices
 	glEnableVertexAttribArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, VBO_vertex);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
 
-	//position
+	//position and size
 	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO_particles);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 32, (void*)0);
-	
-	//size
-	glEnableVertexAttribArray(2);
-	//glBindBuffer(GL_ARRAY_BUFFER, VBO_particles);
-	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 32, (void*)12);
-	
+	glBindBuffer(GL_ARRAY_BUFFER, particle_stream.getBuffer());
+	glVertexAttribPointer(1, 4, GL_HALF_FLOAT, GL_FALSE, sizeof(ParticleVertex), (void*)0);
+
 	//color
-	glEnableVertexAttribArray(3);
-	//glBindBuffer(GL_ARRAY_BUFFER, VBO_particles);
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 32, (void*)16);
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ParticleVertex), (void*)8);
 
 	glVertexAttribDivisor(0, 0);
-	glVertexAttribDivisor(2, 1);
 	glVertexAttribDivisor(1, 1);
-	glVertexAttribDivisor(3, 1);
+	glVertexAttribDivisor(2, 1);
 
 	glBindVertexArray(0);
 
@@ -63,75 +63,458 @@ void ParticleEmitter::init()
 }
 
 void ParticleEmitter::addEffect(unsigned num_particles, glm::vec3 position, float size, glm::vec4 color, float duration,
-	Particle_Pattern pattern, float velocity_factor, float gravity_factor)
+	Particle_Pattern pattern, float velocity_factor, float gravity_factor, Particle_Priority priority)
 {
-	unsigned p_i = findUnusedParticleIndex();
-	for (unsigned i = 0; i < num_particles; i++)
+	counters.requested += num_particles;
+
+	const unsigned scaled_particles = unsigned(float(num_particles) * getDetailScale(position, duration, velocity_factor) + 0.5f);
+	counters.culled_by_distance += num_particles - scaled_particles;
+	num_particles = scaled_particles;
+
+	//Live particles are never replaced by new ones
+	unsigned priority_budget = particle_budget;
+	if (priority == Particle_Priority::Low)
+		priority_budget = unsigned(float(particle_budget) * LOW_PRIORITY_SHARE);
+	else if (priority == Particle_Priority::Normal)
+		priority_budget = unsigned(float(particle_budget) * NORMAL_PRIORITY_SHARE);
+	const unsigned free_particles = particle_count < priority_budget ? priority_budget - particle_count : 0;
+	if (num_particles > free_particles)
+	{
+		counters.culled_by_budget += num_particles - free_particles;
+		num_particles = free_particles;
+	}
+	counters.spawned += num_particles;
+
+	//The effects of a pickup start at the same place, so they share a region
+	if (collision_world && num_particles > 0)
 	{
-		if (p_i + i > MAX_PARTICLES) p_i = findUnusedParticleIndex() - i;
+		const float reach = velocity_factor * duration / 1000.0f;
+		if (!collision_regions.empty() && collision_regions.back().x == position.x &&
+			collision_regions.back().z == position.z && collision_regions.back().reach >= reach)
+			collision_regions.back().life_ms = std::max(collision_regions.back().life_ms, duration);
+		else
+			collision_regions.push_back({ position.x, position.z, reach, duration });
+	}
 
-		Particle& p = particles[p_i + i];
-		p.data.position = position;
-		p.data.size = size;
-		p.data.color = color;
-		p.duration_ms = duration;
-		p.life = duration;
-		p.gravity_factor = gravity_factor;
+	//Every particle of the effect has the same size and color, packed the way the vertex shader reads them
+	//The size is a half float in the high 16 bits, the color is 8 bits per channel from red in the lowest byte
+	const unsigned effect_size_bits = unsigned(_mm_cvtsi128_si32(halfFromFloatSSE(_mm_set1_ps(size)))) << 16;
+	unsigned effect_color_bits = 0;
+	for (unsigned c = 0; c < 3; c++)
+		effect_color_bits |= unsigned(std::round(std::min(std::max(color[c], 0.0f), 1.0f) * 255.0f)) << (c * 8);
 
+	for (unsigned i = 0; i < num_particles; i++)
+	{
+		const unsigned p = particle_count++;
+		position_x[p] = position.x;
+		position_y[p] = position.y;
+		position_z[p] = position.z;
+		size_bits[p] = effect_size_bits;
+		color_bits[p] = effect_color_bits;
+		duration_ms[p] = duration;
+		life[p] = duration;
+		this->gravity_factor[p] = gravity_factor;
+
+		glm::vec3 velocity(0.0f);
 		if (pattern == Particle_Pattern::Random)
 		{
-			p.velocity = glm::normalize(glm::vec3(Random::randf(-1, 1), Random::randf(-1, 1), Random::randf(-1, 1))) * velocity_factor *  Random::randf(0,1);
+			velocity = glm::normalize(glm::vec3(randf(-1, 1), randf(-1, 1), randf(-1, 1))) * velocity_factor *  randf(0,1);
 		}else if (pattern == Particle_Pattern::Up)
 		{
-			p.velocity = glm::normalize(glm::vec3(Random::randf(-1, 1), Random::randf(Random::randf(0,0.7f), 1), Random::randf(-1, 1))) * velocity_factor * Random::randf(0,1);
+			velocity = glm::normalize(glm::vec3(randf(-1, 1), randf(randf(0,0.7f), 1), randf(-1, 1))) * velocity_factor * randf(0,1);
 		}
+		velocity_x[p] = velocity.x;
+		velocity_y[p] = velocity.y;
+		velocity_z[p] = velocity.z;
+	}
+}
 
+void ParticleEmitter::setParticleBudget(unsigned budget)
+{
+	particle_budget = std::min(budget, MAX_PARTICLES);
+}
 
+unsigned ParticleEmitter::getParticleBudget() const
+{
+	return particle_budget;
+}
+
+const ParticleCounters& ParticleEmitter::getCounters() const
+{
+	return counters;
+}
+
+void ParticleEmitter::clear()
+{
+	particle_count = 0;
+	collision_regions.clear();
+	collision_disks.clear();
+	random_generator.seed(RANDOM_SEED);
+}
+
+void ParticleEmitter::setCollisionWorld(const World* world)
+{
+	collision_world = world;
+	collision_regions.clear();
+	collision_disks.clear();
+	disk_max_heights.clear();
+	if (world)
+	{
+		for (const auto& disk : world->disks)
+			disk_max_heights.push_back(disk->getMaxHeight());
 	}
 }
 
+float ParticleEmitter::getDetailScale(const glm::vec3& position, float duration, float velocity_factor) const
+{
+	//The furthest a particle travels from the effect's position, ignoring gravity
+	const float reach = velocity_factor * duration / 1000.0f;
+	const float distance = glm::length(position - particle_origin);
+	if (distance <= reach)
+		return 1.0f;
+
+	//The share of the screen height the effect covers at its distance
+	const float screen_height = 2.0f * distance * float(tan(glm::radians(FOV) / 2.0));
+	const float screen_fraction = 2.0f * reach / screen_height;
+	return glm::clamp(screen_fraction / FULL_DETAIL_SCREEN_FRACTION, MIN_DETAIL_SCALE, 1.0f);
+}
+
+float ParticleEmitter::randf(float min, float max)
+{
+	std::uniform_real_distribution<float> distribution(min, max);
+	return distribution(random_generator);
+}
+
 void ParticleEmitter::update(double delta_time_ms, const glm::vec3& camera_position)
 {
-	particle_count = 0;
-	for (int i = 0; i < MAX_PARTICLES; i++)
+	//The batches do not depend on the number of threads, so neither does the particle order
+	const unsigned batch_count = (particle_count + PARTICLE_BATCH_SIZE - 1) / PARTICLE_BATCH_SIZE;
+	batch_live_counts.resize(batch_count);
+	batch_sort_counts.resize(batch_count);
+	particle_origin = camera_position;
+	updateCollisionDisks(float(delta_time_ms));
+
+	g_job_system.parallelFor(batch_count, 1, [this, delta_time_ms, &camera_position](unsigned begin, unsigned end)
 	{
+		for (unsigned b = begin; b < end; b++)
+		{
+			const unsigned batch_begin = b * PARTICLE_BATCH_SIZE;
+			const unsigned batch_end = std::min(batch_begin + PARTICLE_BATCH_SIZE, particle_count);
+			batch_live_counts[b] = updateBatch(batch_begin, batch_end, float(delta_time_ms), camera_position);
+		}
+	});
+
+	fillBatchGaps(batch_count);
+	sortParticles();
+}
+
+void ParticleEmitter::updateCollisionDisks(float delta_time_ms)
+{
+	collision_regions.erase(std::remove_if(collision_regions.begin(), collision_regions.end(),
+		[delta_time_ms](CollisionRegion& region)
+	{
+		region.life_ms -= delta_time_ms;
+		return region.life_ms <= 0.0f;
+	}), collision_regions.end());
+
+	collision_disks.clear();
+	for (const CollisionRegion& region : collision_regions)
+		collision_world->getDisksNear(region.x, region.z, region.reach, collision_disks);
+	std::sort(collision_disks.begin(), collision_disks.end());
+	collision_disks.erase(std::unique(collision_disks.begin(), collision_disks.end()), collision_disks.end());
+
+	collision_max_height = 0.0f;
+	collision_min_x.clear();
+	collision_max_x.clear();
+	collision_min_z.clear();
+	collision_max_z.clear();
+	for (const unsigned disk_id : collision_disks)
+	{
+		const Disk* disk = collision_world->disks[disk_id].get();
+		collision_max_height = std::max(collision_max_height, disk_max_heights[disk_id]);
+		collision_min_x.push_back(float(disk->position.x) - disk->radius);
+		collision_max_x.push_back(float(disk->position.x) + disk->radius);
+		collision_min_z.push_back(float(disk->position.z) - disk->radius);
+		collision_max_z.push_back(float(disk->position.z) + disk->radius);
+	}
+
+	//An empty box has its minimum above its maximum, so it never overlaps anything
+	const size_t padded_size = (collision_disks.size() + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+	collision_min_x.resize(padded_size, FLT_MAX);
+	collision_max_x.resize(padded_size, -FLT_MAX);
+	collision_min_z.resize(padded_size, FLT_MAX);
+	collision_max_z.resize(padded_size, -FLT_MAX);
+}
 
-		Particle& p = particles[i]; // shortcut
+void ParticleEmitter::collideWithGround(simd_float x, simd_float& y, simd_float z,
+	simd_float& vx, simd_float& vy, simd_float& vz, simd_float& gravity) const
+{
+	//Particles without gravity are floating or have settled, the rest are mostly above every disk they can reach
+	const simd_float zero = simdSet1(0.0f);
+	const simd_float tested = simdAndNot(simdLessEqual(gravity, zero), simdLess(y, simdSet1(collision_max_height)));
+	if (simdMoveMask(tested) == 0)
+		return;
+
+	//The box around the particles, to skip the disks none of them are over without testing each
+	float x_lanes[SIMD_WIDTH], z_lanes[SIMD_WIDTH];
+	simdStore(x_lanes, x);
+	simdStore(z_lanes, z);
+	float min_x = x_lanes[0], max_x = x_lanes[0], min_z = z_lanes[0], max_z = z_lanes[0];
+	for (unsigned lane = 1; lane < SIMD_WIDTH; lane++)
+	{
+		min_x = std::min(min_x, x_lanes[lane]);
+		max_x = std::max(max_x, x_lanes[lane]);
+		min_z = std::min(min_z, z_lanes[lane]);
+		max_z = std::max(max_z, z_lanes[lane]);
+	}
+	const simd_float group_min_x = simdSet1(min_x);
+	const simd_float group_max_x = simdSet1(max_x);
+	const simd_float group_min_z = simdSet1(min_z);
+	const simd_float group_max_z = simdSet1(max_z);
+
+	//The height of the first disk each particle is on, like World::getHeightAtPointPosition
+	//Masks start with no lanes set
+	simd_float ground = zero;
+	simd_float on_disk = zero;
+	simd_float on_ground = zero;
+	for (unsigned first = 0; first < collision_disks.size(); first += SIMD_WIDTH)
+	{
+		//The disks from first whose boxes overlap the particles' box
+		const simd_float overlap = simdAnd(
+			simdAnd(simdLessEqual(simdLoad(&collision_min_x[first]), group_max_x), simdLessEqual(group_min_x, simdLoad(&collision_max_x[first]))),
+			simdAnd(simdLessEqual(simdLoad(&collision_min_z[first]), group_max_z), simdLessEqual(group_min_z, simdLoad(&collision_max_z[first]))));
+		for (int overlap_mask = simdMoveMask(overlap); overlap_mask != 0; overlap_mask &= overlap_mask - 1)
+		{
+			unsigned lane = 0;
+			while (!(overlap_mask & (1 << lane)))
+				lane++;
+			const unsigned disk_id = collision_disks[first + lane];
+			const Disk* disk = collision_world->disks[disk_id].get();
+
+			const simd_float dx = simdSub(x, simdSet1(float(disk->position.x)));
+			const simd_float dz = simdSub(z, simdSet1(float(disk->position.z)));
+			const simd_float radius = simdSet1(disk->radius);
+			const simd_float inside = simdAndNot(on_disk,
+				simdLessEqual(simdAdd(simdMul(dx, dx), simdMul(dz, dz)), simdMul(radius, radius)));
+			on_disk = simdOr(on_disk, inside);
+
+			//Particles above the disk's highest point can not be below its ground
+			const simd_float low = simdAnd(simdAnd(inside, tested), simdLess(y, simdSet1(disk_max_heights[disk_id])));
+			if (simdMoveMask(low) == 0)
+				continue;
+
+			ground = simdSelect(low, disk->getHeightsAtPositions(x, z), ground);
+			on_ground = simdOr(on_ground, low);
+		}
+	}
 
-		if (p.life <= 0.0f) continue;
+	const simd_float below = simdAnd(on_ground, simdLess(y, ground));
+	if (simdMoveMask(below) == 0)
+		return;
+
+	//Only particles moving down bounce, ones already moving up are just lifted
+	const simd_float falling = simdAnd(below, simdLess(vy, zero));
+	const simd_float friction = simdSet1(BOUNCE_FRICTION);
+	y = simdSelect(below, ground, y);
+	vy = simdSelect(falling, simdMul(vy, simdSet1(-BOUNCE_RESTITUTION)), vy);
+	vx = simdSelect(falling, simdMul(vx, friction), vx);
+	vz = simdSelect(falling, simdMul(vz, friction), vz);
+
+	//A particle that bounces slower than SETTLE_SPEED stops where it is and is not tested again
+	const simd_float settle_speed = simdSet1(SETTLE_SPEED);
+	const simd_float settled = simdAnd(falling, simdLess(vy, settle_speed));
+	vx = simdAndNot(settled, vx);
+	vy = simdAndNot(settled, vy);
+	vz = simdAndNot(settled, vz);
+	gravity = simdAndNot(settled, gravity);
+}
 
+unsigned ParticleEmitter::updateBatch(unsigned begin, unsigned end, float delta_time_ms, const glm::vec3& camera_position)
+{
+	const simd_float zero = simdSet1(0.0f);
+	const simd_float delta_time = simdSet1(delta_time_ms);
+	const simd_float delta_time_seconds = simdSet1(delta_time_ms / 1000.0f);
+	// Simulate simple physics : gravity and bouncing off the ground
+	const simd_float gravity_step = simdSet1(float(-9.80f / 1000.0) * delta_time_ms);
+	//The GPU data positions are relative to the camera
+	const simd_float camera_x = simdSet1(camera_position.x);
+	const simd_float camera_y = simdSet1(camera_position.y);
+	const simd_float camera_z = simdSet1(camera_position.z);
+	const simd_float max_alpha = simdSet1(255.0f);
+	const __m128i max_key = _mm_set1_epi32(SORT_KEY_MASK);
+
+	//The particles that died, in increasing order
+	unsigned dead_particles[PARTICLE_BATCH_SIZE];
+	unsigned dead_count = 0;
+
+	for (unsigned i = begin; i < end; i += SIMD_WIDTH)
+	{
 		// Decrease life
-		p.life -= float(delta_time_ms);
-		if (p.life > 0.0f)
+		const simd_float new_life = simdSub(simdLoad(&life[i]), delta_time);
+		simdStore(&life[i], new_life);
+
+		simd_float gravity = simdLoad(&gravity_factor[i]);
+		simd_float vx = simdLoad(&velocity_x[i]);
+		simd_float vy = simdAdd(simdLoad(&velocity_y[i]), simdMul(gravity_step, gravity));
+		simd_float vz = simdLoad(&velocity_z[i]);
+
+		const simd_float px = simdAdd(simdLoad(&position_x[i]), simdMul(vx, delta_time_seconds));
+		simd_float py = simdAdd(simdLoad(&position_y[i]), simdMul(vy, delta_time_seconds));
+		const simd_float pz = simdAdd(simdLoad(&position_z[i]), simdMul(vz, delta_time_seconds));
+		if (!collision_disks.empty())
+		{
+			collideWithGround(px, py, pz, vx, vy, vz, gravity);
+			simdStore(&velocity_x[i], vx);
+			simdStore(&velocity_z[i], vz);
+			simdStore(&gravity_factor[i], gravity);
+		}
+		simdStore(&velocity_y[i], vy);
+		simdStore(&position_x[i], px);
+		simdStore(&position_y[i], py);
+		simdStore(&position_z[i], pz);
+
+		const simd_float dx = simdSub(px, camera_x);
+		const simd_float dy = simdSub(py, camera_y);
+		const simd_float dz = simdSub(pz, camera_z);
+		const simd_float camera_distance = simdAdd(simdAdd(simdMul(dx, dx), simdMul(dy, dy)), simdMul(dz, dz));
+
+		// Fill the GPU buffer
+		const simd_float alpha = simdMin(simdMax(simdMul(simdDiv(new_life, simdLoad(&duration_ms[i])), max_alpha), zero), max_alpha);
+		for (unsigned part = 0; part < SIMD_SSE_PARTS; part++)
+		{
+			const unsigned k = i + 4 * part;
+
+			//A squared distance is a positive float, so its bits sort in the same order it does
+			//The top bits are inverted so the farthest particle has the smallest key
+			const __m128i distance_bits = _mm_castps_si128(simdGetSSEPart(camera_distance, part));
+			const __m128i key = _mm_sub_epi32(max_key, _mm_and_si128(_mm_srli_epi32(distance_bits, 32 - SORT_KEY_BITS - 1), max_key));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&sort_keys[k]), _mm_slli_epi32(key, SORT_INDEX_BITS));
+
+			const __m128i half_x = halfFromFloatSSE(simdGetSSEPart(dx, part));
+			const __m128i half_y = halfFromFloatSSE(simdGetSSEPart(dy, part));
+			const __m128i half_z = halfFromFloatSSE(simdGetSSEPart(dz, part));
+			const __m128i alpha_bits = _mm_slli_epi32(_mm_cvtps_epi32(simdGetSSEPart(alpha, part)), 24);
+
+			const __m128i position_xy = _mm_or_si128(half_x, _mm_slli_epi32(half_y, 16));
+			const __m128i position_z_size = _mm_or_si128(half_z, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&size_bits[k])));
+			const __m128i color = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&color_bits[k])), alpha_bits);
+			storeInterleaved3SSE(&particle_data[k], position_xy, position_z_size, color);
+		}
+
+		//Padding lanes after the last particle are not checked
+		int dead_mask = simdMoveMask(simdLessEqual(new_life, zero));
+		if (end - i < SIMD_WIDTH)
+			dead_mask &= (1 << (end - i)) - 1;
+		for (unsigned lane = 0; dead_mask != 0; lane++, dead_mask >>= 1)
 		{
+			if (dead_mask & 1)
+				dead_particles[dead_count++] = i + lane;
+		}
+	}
 
-			// Simulate simple physics : gravity only, no collisions
-			p.velocity += glm::vec3(0.0f, -9.80f/1000.0, 0.0f) * float(delta_time_ms) * p.gravity_factor;
-			p.data.position += p.velocity * float(delta_time_ms) / 1000.0f;
-			p.camera_distance = glm::length2(p.data.position - camera_position);
-			p.data.color.a = p.life/ p.duration_ms;
-			//ParticlesContainer[i].pos += glm::vec3(0.0f,10.0f, 0.0f) * (float)delta;
+	//From the back, so the last particle moved into a slot is always one that lived
+	unsigned live_end = end;
+	while (dead_count > 0)
+	{
+		dead_count--;
+		live_end--;
+		moveParticle(live_end, dead_particles[dead_count]);
+	}
 
-			// Fill the GPU buffer
-			for (unsigned j = 0; j < 8; j++)
-				particle_data[8 * particle_count + j] = p.array_data[j];
+	//Count the sort digits here so it is done in parallel, moving particles
+	//between batches afterwards does not change the totals
+	SortCounts& counts = batch_sort_counts[begin / PARTICLE_BATCH_SIZE];
+	counts = SortCounts();
+	for (unsigned i = begin; i < live_end; i++)
+	{
+		counts.low[(sort_keys[i] >> SORT_INDEX_BITS) & 0xff]++;
+		counts.high[sort_keys[i] >> (SORT_INDEX_BITS + 8)]++;
+	}
+	return live_end - begin;
+}
 
-			
-		} else
+void ParticleEmitter::fillBatchGaps(unsigned batch_count)
+{
+	//The prefix sum of the batches' live counts is the new particle count
+	unsigned live_count = 0;
+	for (unsigned b = 0; b < batch_count; b++)
+		live_count += batch_live_counts[b];
+
+	//Gaps before live_count are filled from the back with live particles after it
+	unsigned source_batch = batch_count;
+	unsigned source_begin = 0;
+	unsigned source_end = 0;
+	for (unsigned b = 0; b < batch_count && b * PARTICLE_BATCH_SIZE < live_count; b++)
+	{
+		const unsigned gap_end = std::min((b + 1) * PARTICLE_BATCH_SIZE, live_count);
+		for (unsigned gap = b * PARTICLE_BATCH_SIZE + batch_live_counts[b]; gap < gap_end; gap++)
 		{
-			// Particles that just died will be put at the end of the buffer in SortParticles();
-			p.camera_distance = -1.0f;
+			while (source_end == source_begin)
+			{
+				source_batch--;
+				source_begin = std::max(source_batch * PARTICLE_BATCH_SIZE, live_count);
+				source_end = std::max(source_batch * PARTICLE_BATCH_SIZE + batch_live_counts[source_batch], source_begin);
+			}
+			source_end--;
+			moveParticle(source_end, gap);
 		}
+	}
 
-		particle_count++;
+	particle_count = live_count;
+}
 
+void ParticleEmitter::sortParticles()
+{
+	//Turn the digit counts into the index each digit's particles start at
+	SortCounts offsets;
+	for (const SortCounts& counts : batch_sort_counts)
+	{
+		for (unsigned d = 0; d < 256; d++)
+			offsets.low[d] += counts.low[d];
+		for (unsigned d = 0; d < 128; d++)
+			offsets.high[d] += counts.high[d];
+	}
+	unsigned low_total = 0;
+	for (unsigned d = 0; d < 256; d++)
+	{
+		const unsigned count = offsets.low[d];
+		offsets.low[d] = low_total;
+		low_total += count;
+	}
+	unsigned high_total = 0;
+	for (unsigned d = 0; d < 128; d++)
+	{
+		const unsigned count = offsets.high[d];
+		offsets.high[d] = high_total;
+		high_total += count;
+	}
 
+	//Each entry is a key above the particle's index
+	for (unsigned i = 0; i < particle_count; i++)
+	{
+		const unsigned entry = sort_keys[i] | i;
+		sort_entries[offsets.low[(entry >> SORT_INDEX_BITS) & 0xff]++] = entry;
 	}
 
-	//glBindBuffer(GL_ARRAY_BUFFER, VBO_vertex);
-	glBindBuffer(GL_ARRAY_BUFFER, VBO_particles);
-	glBufferData(GL_ARRAY_BUFFER, MAX_PARTICLES * 8 * sizeof(GLfloat), NULL, GL_STREAM_DRAW); // Buffer orphaning, a common way to improve streaming perf. See above link for details.
-	glBufferSubData(GL_ARRAY_BUFFER, 0, particle_count * sizeof(GLfloat) * 8, particle_data);
+	//Stable, so particles with the same high digit stay ordered by the low digit
+	for (unsigned j = 0; j < particle_count; j++)
+	{
+		const unsigned entry = sort_entries[j];
+		sorted_data[offsets.high[entry >> (SORT_INDEX_BITS + 8)]++] = particle_data[entry & SORT_INDEX_MASK];
+	}
+}
+
+void ParticleEmitter::copyParticleData(std::vector<ParticleVertex>& data, glm::vec3& origin) const
+{
+	data.assign(sorted_data, sorted_data + particle_count);
+	origin = particle_origin;
+}
+
+void ParticleEmitter::upload(const std::vector<ParticleVertex>& data, const glm::vec3& origin)
+{
+	uploaded_count = unsigned(data.size());
+	uploaded_origin = origin;
+	uploaded_first = particle_stream.write(data.data(), uploaded_count);
 }
 
 void ParticleEmitter::draw(const glm::mat4& view_matrix, const glm::mat4& projection_matrix) const
@@ -144,35 +527,31 @@ void ParticleEmitter::draw(const glm::mat4& view_matrix, const glm::mat4& projec
 	glUniformMatrix4fv(view_projection_matrix_id, 1, GL_FALSE, glm::value_ptr(projection_matrix * view_matrix));
 	glUniform3f(camera_right_worldspace_id, view_matrix[0][0], view_matrix[1][0], view_matrix[2][0]);
 	glUniform3f(camera_up_worldspace_id, view_matrix[0][1], view_matrix[1][1], view_matrix[2][1]);
+	glUniform3f(particle_origin_id, uploaded_origin.x, uploaded_origin.y, uploaded_origin.z);
 
 	glBindVertexArray(VAO);
 
 	//glDrawArrays(GL_TRIANGLE_STRIP,0,4);
-	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particle_count);
+	//The instanced attributes start at the uploaded particles
+	glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, uploaded_count, uploaded_first);
 
 	glBindVertexArray(0);
 }
 
-unsigned ParticleEmitter::findUnusedParticleIndex()
+void ParticleEmitter::moveParticle(unsigned from, unsigned to)
 {
-
-	for (unsigned i = last_used_particle; i < MAX_PARTICLES; i++)
-	{
-		if (particles[i].duration_ms <= 0)
-		{
-			last_used_particle = i;
-			return i;
-		}
-	}
-
-	for (unsigned i = 0; i < last_used_particle; i++)
-	{
-		if (particles[i].duration_ms <= 0)
-		{
-			last_used_particle = i;
-			return i;
-		}
-	}
-
-	return 0; // All particles are taken, override the first one
+	position_x[to] = position_x[from];
+	position_y[to] = position_y[from];
+	position_z[to] = position_z[from];
+	velocity_x[to] = velocity_x[from];
+	velocity_y[to] = velocity_y[from];
+	velocity_z[to] = velocity_z[from];
+	size_bits[to] = size_bits[from];
+	color_bits[to] = color_bits[from];
+	duration_ms[to] = duration_ms[from];
+	life[to] = life[from];
+	gravity_factor[to] = gravity_factor[from];
+	sort_keys[to] = sort_keys[from];
+
+	particle_data[to] = particle_data[from];
 }
@@ -5,40 +5,50 @@
 #include "lib/GetGlutWithShaders.h"
 #include "lib/ObjLibrary/ObjShader.h"
 #include "lib/ObjLibrary/Vector3.h"
-#include "Random.h"
+#include "SIMD.h"
+#include "StreamBuffer.h"
+#include <random>
+#include <vector>
 
 
+class World;
+
 constexpr unsigned MAX_PARTICLES = 100000;
 
+//The GPU data of one particle
+//Position and size are half floats, the position is relative to the origin of the update
+//that wrote it so half floats are precise near the camera. The color is RGBA8
+struct ParticleVertex
+{
+	unsigned short position_size[4];
+	unsigned char color[4];
+};
+static_assert(sizeof(ParticleVertex) == 12, "ParticleVertex must be packed");
+
 enum Particle_Pattern
 {
 	Random,
 	Up,
 };
 
-#pragma pack(push, 1)
-struct Particle_Data
+//How much of the particle budget an effect may use
+//Lower priority effects stop spawning earlier so there is always room for higher ones
+enum class Particle_Priority
 {
-	glm::vec3 position{ 0.0f };
-	float size{};
-	glm::vec4 color{ 1.0f };
-	Particle_Data() = default;
+	Low,
+	Normal,
+	High,
 };
-#pragma pack(pop)
 
-struct Particle
+//Particles asked for by effects and what happened to them, counted since the emitter was made
+struct ParticleCounters
 {
-	union
-	{
-		struct Particle_Data data {};
-		float array_data[8];
-	};
-	glm::vec3 velocity{ 0.0f };
-	float duration_ms{};
-	float life{};
-	float camera_distance{};
-	float gravity_factor{};
-	Particle() {};
+	unsigned long long requested{};
+	unsigned long long spawned{};
+	//Not spawned because the effect was small on the screen
+	unsigned long long culled_by_distance{};
+	//Not spawned because the budget for the effect's priority was used
+	unsigned long long culled_by_budget{};
 };
 
 class ParticleEmitter
@@ -49,32 +59,191 @@ class ParticleEmitter
 	const std::string shader_frag = "particle.frag";
 
 	GLuint VAO{};
-	GLuint VBO_vertex{}, VBO_particles{};
+	GLuint VBO_vertex{};
+	//The GPU data of the particles, a new region of it is written for each upload
+	StreamBuffer particle_stream;
 	GLuint shader_program_id{};
 
 	//Uniform location
 	GLuint camera_right_worldspace_id{};
 	GLuint camera_up_worldspace_id{};
 	GLuint view_projection_matrix_id{};
-
-	Particle particles[MAX_PARTICLES];
-	float particle_data[MAX_PARTICLES * 8] = {};
+	GLuint particle_origin_id{};
+
+	//Every array holds one value per particle, so SIMD_WIDTH particles are updated at a time
+	//The live particles are kept packed at the front, the slots after them are free
+	//A particle that dies is replaced by the last live one, so nothing loops over dead particles
+	//The arrays are padded by SIMD_WIDTH so the last group of particles can be read whole
+	static constexpr unsigned PARTICLE_CAPACITY = MAX_PARTICLES + SIMD_WIDTH;
+	float position_x[PARTICLE_CAPACITY] = {};
+	float position_y[PARTICLE_CAPACITY] = {};
+	float position_z[PARTICLE_CAPACITY] = {};
+	float velocity_x[PARTICLE_CAPACITY] = {};
+	float velocity_y[PARTICLE_CAPACITY] = {};
+	float velocity_z[PARTICLE_CAPACITY] = {};
+	//The half float size in the high 16 bits, ready to join with the position's z
+	unsigned size_bits[PARTICLE_CAPACITY] = {};
+	//RGB8 with no alpha, the alpha is set from the life left
+	unsigned color_bits[PARTICLE_CAPACITY] = {};
+	float duration_ms[PARTICLE_CAPACITY] = {};
+	float life[PARTICLE_CAPACITY] = {};
+	float gravity_factor[PARTICLE_CAPACITY] = {};
+	//The particle's sort key from its camera distance, in the high SORT_KEY_BITS bits
+	unsigned sort_keys[PARTICLE_CAPACITY] = {};
 	unsigned particle_count{};
-	unsigned last_used_particle{};
+
+	//The GPU data of each live particle, written by update straight from the arrays
+	ParticleVertex particle_data[PARTICLE_CAPACITY] = {};
+	//The GPU data ordered from the farthest particle to the nearest, so blending is drawn back to front
+	ParticleVertex sorted_data[PARTICLE_CAPACITY] = {};
+	//The camera position of the last update, the GPU data positions are relative to it
+	glm::vec3 particle_origin{ 0.0f };
+
+	//Particles in each job of the update, a multiple of SIMD_WIDTH
+	//Each job writes the particles and GPU data of its own batch only
+	static constexpr unsigned PARTICLE_BATCH_SIZE = 4096;
+
+	//The particles left alive in each batch by the last update, packed at the front of the batch
+	std::vector<unsigned> batch_live_counts;
+
+	//A sort entry is a key of the squared camera distance's top float bits (without the sign)
+	//above the particle's index. 15 bits keep 7 bits of mantissa, enough to order particles
+	//that are more than 0.4% apart in distance
+	static constexpr unsigned SORT_INDEX_BITS = 17;
+	static constexpr unsigned SORT_INDEX_MASK = (1 << SORT_INDEX_BITS) - 1;
+	static constexpr unsigned SORT_KEY_BITS = 32 - SORT_INDEX_BITS;
+	static constexpr unsigned SORT_KEY_MASK = (1 << SORT_KEY_BITS) - 1;
+	static_assert(PARTICLE_CAPACITY <= SORT_INDEX_MASK + 1, "Particle indices must fit in a sort entry");
+
+	//How many particles have each low 8 bit and high 7 bit digit of the key
+	struct SortCounts
+	{
+		unsigned low[256] = {};
+		unsigned high[128] = {};
+	};
+	//Counted by each batch for the particles it left alive
+	std::vector<SortCounts> batch_sort_counts;
+
+	//The sort entries after the pass on the low digit
+	unsigned sort_entries[PARTICLE_CAPACITY] = {};
+	//Effects spawn fewer particles as they get smaller on the screen
+	//An effect whose reach covers FULL_DETAIL_SCREEN_FRACTION of the screen height spawns
+	//every particle, one further away spawns a share matching its size, down to MIN_DETAIL_SCALE
+	static constexpr float FULL_DETAIL_SCREEN_FRACTION = 0.25f;
+	static constexpr float MIN_DETAIL_SCALE = 0.05f;
+
+	//The live particles effects of each priority may fill, as shares of the budget
+	static constexpr float LOW_PRIORITY_SHARE = 0.5f;
+	static constexpr float NORMAL_PRIORITY_SHARE = 0.8f;
+	unsigned particle_budget = MAX_PARTICLES / 2;
+	ParticleCounters counters;
+
+	//Particles have their own generator so how many are spawned does not change the game's random numbers
+	static constexpr unsigned RANDOM_SEED = 409;
+	std::mt19937 random_generator{ RANDOM_SEED };
+
+	//The world particles bounce off, or nullptr if they fall through it
+	const World* collision_world{};
+	//How much of its vertical speed a particle keeps when it bounces, and of its horizontal speed
+	static constexpr float BOUNCE_RESTITUTION = 0.4f;
+	static constexpr float BOUNCE_FRICTION = 0.7f;
+	//A particle that bounces up slower than this stops on the ground
+	static constexpr float SETTLE_SPEED = 0.1f;
+
+	//The circle an effect's particles can reach and the time until they have all died
+	struct CollisionRegion
+	{
+		float x{}, z{};
+		float reach{};
+		float life_ms{};
+	};
+	std::vector<CollisionRegion> collision_regions;
+	//The highest point of each disk in the collision world
+	std::vector<float> disk_max_heights;
+	//The disks any live effect can reach, found once per update and tested by every particle
+	std::vector<unsigned> collision_disks;
+	float collision_max_height{};
+	//The box around each collision disk, padded to a multiple of SIMD_WIDTH with empty boxes
+	//so SIMD_WIDTH disks are tested against a group of particles at a time
+	std::vector<float> collision_min_x;
+	std::vector<float> collision_max_x;
+	std::vector<float> collision_min_z;
+	std::vector<float> collision_max_z;
+
+	//The particles in the GPU buffer from the last upload
+	unsigned uploaded_first{};
+	unsigned uploaded_count{};
+	glm::vec3 uploaded_origin{ 0.0f };
+
+	//Times sortParticles on its own
+	friend class ParticleBenchmark;
 
 public:
 	ParticleEmitter() = default;
 
 	void init();
 
-	void addEffect(unsigned num_particles, glm::vec3 position, float size, glm::vec4 color, float duration, Particle_Pattern pattern, float velocity_factor, float gravity_factor);
+	//Adds up to num_particles particles, fewer when the effect is far from the camera of the last update
+	//Particles that do not fit in the budget for the priority are not added
+	void addEffect(unsigned num_particles, glm::vec3 position, float size, glm::vec4 color, float duration, Particle_Pattern pattern,
+		float velocity_factor, float gravity_factor, Particle_Priority priority = Particle_Priority::Normal);
+
+	//Sets how many particles may be alive at once, at most MAX_PARTICLES
+	void setParticleBudget(unsigned budget);
 
+	unsigned getParticleBudget() const;
+
+	const ParticleCounters& getCounters() const;
+
+	//Removes every particle and the effects they came from
+	//The particles spawned afterwards are the same as a new emitter's
+	void clear();
+
+	//Makes particles bounce off the disks of the world, nullptr makes them fall through
+	//Must be called again after the world's disks change
+	void setCollisionWorld(const World* world);
+
+	//Moves the particles and fills the GPU data of the particles that are alive
 	void update(double delta_time_ms, const glm::vec3& camera_position);
 
+	//Copies the GPU data filled by the last update, farthest particle first, and the origin its positions are relative to
+	//The vector keeps its memory so copying every update does not allocate
+	void copyParticleData(std::vector<ParticleVertex>& data, glm::vec3& origin) const;
+
+	//Replaces the GPU buffer with GPU data copied from an update
+	//Must be called on the thread with the OpenGL context
+	void upload(const std::vector<ParticleVertex>& data, const glm::vec3& origin);
+
 	void draw(const glm::mat4& view_matrix, const glm::mat4& projection_matrix) const;
+
 private:
-	unsigned findUnusedParticleIndex();
+	//Returns the share of an effect's particles to spawn from how big it is on the screen
+	float getDetailScale(const glm::vec3& position, float duration, float velocity_factor) const;
+
+	float randf(float min, float max);
+
+	//Forgets the effects that have died and finds the disks the live ones can reach
+	void updateCollisionDisks(float delta_time_ms);
+
+	//Moves the particles below the ground of the collision disks back up and bounces them
+	//Particles that settle on the ground lose their velocity and gravity
+	void collideWithGround(simd_float x, simd_float& y, simd_float z,
+		simd_float& vx, simd_float& vy, simd_float& vz, simd_float& gravity) const;
+
+	//Updates the particles in [begin, end) and packs the ones left alive at the front
+	//Returns the number left alive
+	unsigned updateBatch(unsigned begin, unsigned end, float delta_time_ms, const glm::vec3& camera_position);
+
+	//Moves the live particles after the batches' total live count into the gaps
+	//left by dead particles before it, so the live particles are packed again
+	void fillBatchGaps(unsigned batch_count);
+
+	//Fills the sorted GPU data from the live particles' sort keys
+	//Uses a least significant digit radix sort with a pass on each digit
+	void sortParticles();
 
+	//Copies a particle and its GPU data into another slot
+	void moveParticle(unsigned from, unsigned to);
 };
 
 
@@ -0,0 +1,46 @@
+#include "Path.h"
+#include <algorithm>
+#include <cassert>
+
+void Path::clear()
+{
+	reversed_nodes.clear();
+}
+
+bool Path::empty() const
+{
+	return reversed_nodes.empty();
+}
+
+unsigned Path::size() const
+{
+	return unsigned(reversed_nodes.size());
+}
+
+unsigned Path::front() const
+{
+	assert(!empty());
+	return reversed_nodes.back();
+}
+
+void Path::popFront()
+{
+	assert(!empty());
+	reversed_nodes.pop_back();
+}
+
+void Path::pushFront(unsigned node_id)
+{
+	reversed_nodes.push_back(node_id);
+}
+
+void Path::reverse()
+{
+	std::reverse(reversed_nodes.begin(), reversed_nodes.end());
+}
+
+unsigned Path::operator[](unsigned i) const
+{
+	assert(i < size());
+	return reversed_nodes[reversed_nodes.size() - 1 - i];
+}
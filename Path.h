@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+
+//The node ids of a path found by a MovementGraph search
+//The nodes are stored back to front so the path is built by walking back from the goal
+//and consumed from the front without moving the remaining nodes.
+//The storage keeps its capacity when cleared so refilling a path does not allocate
+class Path
+{
+private:
+	//The remaining nodes in reverse order, the front of the path is the last element
+	std::vector<unsigned> reversed_nodes;
+
+public:
+	Path() = default;
+
+	//Removes every node but keeps the memory
+	void clear();
+
+	//Returns if there are no nodes left on the path
+	bool empty() const;
+
+	//Returns the number of nodes left on the path
+	unsigned size() const;
+
+	//Returns the next node on the path
+	unsigned front() const;
+
+	//Removes the next node from the path
+	void popFront();
+
+	//Adds a node before the front of the path
+	void pushFront(unsigned node_id);
+
+	//Reverses the order of the nodes left on the path
+	void reverse();
+
+	//Returns the node i steps from the front of the path
+	unsigned operator[](unsigned i) const;
+};
@@ -1,4 +1,5 @@
 #include "PickupManager.h"
+#include <algorithm>
 #include "Collision.h"
 #include "lib/glm/gtc/matrix_transform.hpp"
 #include "LineRenderer.h"
@@ -10,11 +11,14 @@
 #include "Rod.h"
 #include "cassert"
 #include "ParticleEmitter.h"
+#include "JobSystem.h"
+#include "StateHash.h"
 
 using ObjLibrary::Vector3;
 
 extern LineRenderer g_line_renderer;
 extern ParticleEmitter g_particle_emitter;
+extern JobSystem g_job_system;
 
 PickupManager::PickupManager()
 {}
@@ -28,23 +32,79 @@ void PickupManager::init(const World& w, MovementGraph& mg, const ModelWithShade
 	world_graph = &mg;
 	rod_model = &rod;
 	ring_model = &ring;
+	ring_grid.init(PICKUP_GRID_CELL_SIZE);
+	rod_grid.init(PICKUP_GRID_CELL_SIZE);
 
 	//Init disks and rods
 	for (auto& ptr : world->disks)
 	{
-		Vector3 pos = ptr->position;
-		pos.y = world->getHeightAtPointPosition(float(pos.x), float(pos.z));
+		Vec3f pos(ptr->position);
+		pos.y = world->getHeightAtPointPosition(pos.x, pos.z);
 		addRod(pos, ptr->type + 1);
 		addRing();
 	}
 }
 
-void PickupManager::update(const double delta_time)
+void PickupManager::update(const double delta_time, const LodView& view)
 {
-	for (auto& ring : rings)
+	last_delta_time = delta_time;
+	if (ring_lod.size() != rings.size())
+		ring_lod.resize(rings.size());
+	ring_lod.beginTick(view);
+
+	//Moving only reads the world and movement graph
+	g_job_system.parallelFor(rings.size(), RING_BATCH_SIZE, [this, delta_time](unsigned begin, unsigned end)
+	{
+		for (unsigned i = begin; i < end; i++)
+		{
+			//Rings the LOD skips keep their previous transform so they are drawn moving over their whole interval
+			if (ring_lod.schedule(i, rings[i].coordinate_system.getPosition(), delta_time))
+			{
+				const double ring_delta_time = ring_lod.takeAccumulatedTime(i);
+				rings[i].savePreviousTransform(ring_delta_time);
+				rings[i].move(ring_delta_time, ring_lod.isVisible(i));
+			}
+		}
+	});
+	ring_lod.countBands();
+
+	//Destinations use random numbers so they are chosen in ring order on this thread
+	//Ring 0's search is memorized for display so it is searched on this thread afterwards
+	path_requests.clear();
+	path_destinations.clear();
+	unsigned ring_zero_slot = NOT_LIVE;
+	unsigned ring_zero_destination = 0;
+	for (unsigned i = 0; i < rings.size(); i++)
 	{
-		if (!ring.pickedUp)
-			ring.update(delta_time);
+		Ring& ring = rings[i];
+		const Vec3f& position = ring.coordinate_system.getPosition();
+		ring_grid.move(ring.index, position.x, position.z, ring.radius);
+
+		if (!ring.needs_path) continue;
+		if (ring.index == 0)
+		{
+			ring_zero_slot = i;
+			ring_zero_destination = ring.chooseDestination();
+			continue;
+		}
+		path_requests.push_back(i);
+		path_destinations.push_back(ring.chooseDestination());
+	}
+
+	if (search_contexts.size() < g_job_system.getThreadCount())
+		search_contexts.resize(g_job_system.getThreadCount());
+
+	g_job_system.parallelFor(path_requests.size(), 1, [this](unsigned begin, unsigned end)
+	{
+		SearchContext& context = search_contexts[JobSystem::getThreadIndex()];
+		for (unsigned i = begin; i < end; i++)
+			rings[path_requests[i]].followPathTo(path_destinations[i], &context);
+	});
+
+	if (ring_zero_slot != NOT_LIVE)
+	{
+		rings[ring_zero_slot].followPathTo(ring_zero_destination, &search_contexts[0]);
+		world_graph->memorizeLastSearch(search_contexts[0]);
 	}
 }
 
@@ -64,26 +124,55 @@ void PickupManager::pickupParticleExplosion(const glm::vec3& position)
 
 void PickupManager::checkForPickups(const Player& player)
 {
-	for (auto& ring : rings)
+	pickup_commands.init(g_job_system.getThreadCount());
+	const Vec3f player_position = player.coordinate_system.getPosition();
+	const unsigned ring_index_count = ring_slots.size();
+
+	ring_candidates.clear();
+	rod_candidates.clear();
+	ring_grid.query(player_position.x, player_position.z, player.getRadius(), ring_candidates);
+	rod_grid.query(player_position.x, player_position.z, player.getRadius(), rod_candidates);
+	const unsigned ring_candidate_count = ring_candidates.size();
+
+	//Rings and rods are checked as one range, rods after rings
+	g_job_system.parallelFor(ring_candidate_count + rod_candidates.size(), PICKUP_BATCH_SIZE,
+		[this, &player, &player_position, ring_index_count, ring_candidate_count](unsigned begin, unsigned end)
 	{
-		if (!ring.pickedUp)
-			if (Collision::cylinderIntersection(player.coordinate_system.getPosition(), player.getRadius(), player.getHalfHeight(), ring.coordinate_system.position, ring.radius, ring.halfHeight))
+		const unsigned thread_index = JobSystem::getThreadIndex();
+		for (unsigned c = begin; c < end; c++)
+		{
+			if (c < ring_candidate_count)
 			{
-				ring.pickedUp = true;
-				score += ring.pointValue;
-				pickupParticleExplosion(glm::vec3(ring.coordinate_system.position));
+				const unsigned i = ring_candidates[c];
+				const Ring& ring = rings[ring_slots[i]];
+				if (Collision::cylinderIntersection(player_position, player.getRadius(), player.getHalfHeight(), ring.coordinate_system.position, ring.radius, ring.halfHeight))
+					pickup_commands.push(thread_index, i, PickupCommand{ true, i });
+			} else
+			{
+				const unsigned i = rod_candidates[c - ring_candidate_count];
+				const Rod& rod = rods[rod_slots[i]];
+				if (Collision::cylinderIntersection(player_position, player.getRadius(), player.getHalfHeight(), rod.coordinate_system.position, rod.radius, rod.halfHeight))
+					pickup_commands.push(thread_index, ring_index_count + i, PickupCommand{ false, i });
 			}
-	}
+		}
+	});
 
-	for (auto& rod : rods)
+	//Score and particles are applied on this thread in ring then rod order
+	for (const PickupCommand& command : pickup_commands.merge())
 	{
-		if (!rod.pickedUp)
-			if (Collision::cylinderIntersection(player.coordinate_system.getPosition(), player.getRadius(), player.getHalfHeight(), rod.coordinate_system.position, rod.radius, rod.halfHeight))
-			{
-				rod.pickedUp = true;
-				score += rod.pointValue;
-				pickupParticleExplosion(glm::vec3(rod.coordinate_system.position));
-			}
+		if (command.is_ring)
+		{
+			const unsigned slot = ring_slots[command.index];
+			score += rings[slot].pointValue;
+			pickupParticleExplosion(glm::vec3(rings[slot].coordinate_system.position));
+			removeRing(slot);
+		} else
+		{
+			const unsigned slot = rod_slots[command.index];
+			score += rods[slot].pointValue;
+			pickupParticleExplosion(glm::vec3(rods[slot].coordinate_system.position));
+			removeRod(slot);
+		}
 	}
 }
 
@@ -92,14 +181,88 @@ int PickupManager::getScore() const
 	return score;
 }
 
-void PickupManager::addRod(Vector3 pos, unsigned score_value)
+const SimulationLod& PickupManager::getRingLod() const
+{
+	return ring_lod;
+}
+
+void PickupManager::addRod(const Vec3f& pos, unsigned score_value)
 {
-	rods.emplace_back(*rod_model, pos, score_value);
+	const unsigned index = rod_slots.size();
+	rod_slots.push_back(rods.size());
+	rods.emplace_back(index, *rod_model, pos, score_value);
+	rod_grid.insert(index, pos.x, pos.z, rods.back().radius);
 }
 
 void PickupManager::addRing()
 {
-	rings.emplace_back(rings.size(), *world, world_graph, *ring_model);
+	const unsigned index = ring_slots.size();
+	ring_slots.push_back(rings.size());
+	rings.emplace_back(index, *world, world_graph, *ring_model);
+	const Vec3f& position = rings.back().coordinate_system.getPosition();
+	ring_grid.insert(index, position.x, position.z, Ring::radius);
+}
+
+const Ring* PickupManager::getRing(unsigned index) const
+{
+	if (index >= ring_slots.size() || ring_slots[index] == NOT_LIVE)
+		return nullptr;
+	return &rings[ring_slots[index]];
+}
+
+unsigned PickupManager::getRingCount() const
+{
+	return rings.size();
+}
+
+unsigned PickupManager::getRodCount() const
+{
+	return rods.size();
+}
+
+void PickupManager::hashState(StateHash& hash) const
+{
+	hash.add(score);
+	hash.add(unsigned(rings.size()));
+	for (const Ring& ring : rings)
+	{
+		hash.add(ring.index);
+		hash.add(ring.curr_node_id);
+		hash.add(ring.target_node_id);
+		hash.add(ring.coordinate_system.getPosition());
+	}
+	hash.add(unsigned(rods.size()));
+	for (const Rod& rod : rods)
+		hash.add(rod.index);
+}
+
+void PickupManager::removeRing(unsigned slot)
+{
+	assert(slot < rings.size());
+	ring_grid.remove(rings[slot].index);
+	ring_slots[rings[slot].index] = NOT_LIVE;
+
+	if (slot != rings.size() - 1)
+	{
+		rings[slot] = std::move(rings.back());
+		ring_slots[rings[slot].index] = slot;
+	}
+	rings.pop_back();
+	ring_lod.swapRemove(slot);
+}
+
+void PickupManager::removeRod(unsigned slot)
+{
+	assert(slot < rods.size());
+	rod_grid.remove(rods[slot].index);
+	rod_slots[rods[slot].index] = NOT_LIVE;
+
+	if (slot != rods.size() - 1)
+	{
+		rods[slot] = std::move(rods.back());
+		rod_slots[rods[slot].index] = slot;
+	}
+	rods.pop_back();
 }
 
 void PickupManager::draw(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix) const
@@ -112,7 +275,6 @@ void PickupManager::draw(const glm::mat4x4& view_matrix, const glm::mat4x4& proj
 	//Call draw on each rod
 	for (auto const& rod : rods)
 	{
-		if (rod.pickedUp) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
 		model_matrix = glm::translate(model_matrix, glm::vec3(rod.coordinate_system.position));
 		glm::mat4x4 mvp_matrix = projection_matrix * view_matrix *  model_matrix;
@@ -121,7 +283,6 @@ void PickupManager::draw(const glm::mat4x4& view_matrix, const glm::mat4x4& proj
 	}
 	for (auto const& ring : rings)
 	{
-		if (ring.pickedUp) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
 		model_matrix = glm::translate(model_matrix, glm::vec3(ring.coordinate_system.position));
 		model_matrix = glm::rotate(model_matrix, (float(atan2(ring.coordinate_system.forward.x, ring.coordinate_system.forward.z))), glm::vec3(0, 1, 0));
@@ -147,13 +308,31 @@ void PickupManager::draw(const glm::mat4x4& view_matrix, const glm::mat4x4& proj
 
 }
 
-void PickupManager::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix)
+void PickupManager::getTransforms(PickupTransforms& transforms) const
 {
-	drawOptimized(view_matrix, projection_matrix, glm::vec3(0, 0, 0));
-}
+	transforms.previous_rings.resize(rings.size());
+	transforms.rings.resize(rings.size());
+	transforms.ring_fraction_starts.resize(rings.size());
+	transforms.ring_fraction_steps.resize(rings.size());
+	for (unsigned i = 0; i < rings.size(); i++)
+	{
+		transforms.previous_rings[i] = rings[i].previous_coordinate_system;
+		transforms.rings[i] = rings[i].coordinate_system;
+
+		//Rings that have not moved yet have the same previous and current coordinate systems
+		const double interval = rings[i].update_interval;
+		const double elapsed = i < ring_lod.size() ? ring_lod.getAccumulatedTime(i) : 0.0;
+		transforms.ring_fraction_starts[i] = interval > 0.0 ? float(elapsed / interval) : 1.0f;
+		transforms.ring_fraction_steps[i] = interval > 0.0 ? float(last_delta_time / interval) : 0.0f;
+	}
 
+	transforms.rods.resize(rods.size());
+	for (unsigned i = 0; i < rods.size(); i++)
+		transforms.rods[i] = rods[i].coordinate_system.position;
+}
 
-void PickupManager::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos)
+void PickupManager::drawOptimized(const PickupTransforms& transforms, float fraction,
+	const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos) const
 {
 	const ObjLibrary::ObjShader::ShaderUniforms& uniforms = ObjLibrary::ObjShader::activateShader();
 	rod_model->getMaterial(0).activate(uniforms);;
@@ -161,11 +340,10 @@ void PickupManager::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat
 	const  glm::mat4 vp_matrix = projection_matrix * view_matrix;
 
 	//Call draw on each rod
-	for (auto const& rod : rods)
+	for (const Vec3f& rod_position : transforms.rods)
 	{
-		if (rod.pickedUp) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
-		model_matrix = glm::translate(model_matrix, glm::vec3(rod.coordinate_system.position));
+		model_matrix = glm::translate(model_matrix, glm::vec3(rod_position));
 		glm::mat4x4 mvp_matrix = vp_matrix *  model_matrix;
 
 		glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
@@ -175,12 +353,12 @@ void PickupManager::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat
 
 	ring_model->getMaterial(0).activate(uniforms);
 	//Call draw on each ring
-	for (auto const& ring : rings)
+	for (unsigned i = 0; i < transforms.rings.size(); i++)
 	{
-		if (ring.pickedUp) continue;
+		const CoordinateSystem render = interpolateRing(transforms, i, fraction);
 		glm::mat4x4 model_matrix = glm::mat4();
-		model_matrix = glm::translate(model_matrix, glm::vec3(ring.coordinate_system.position));
-		model_matrix = glm::rotate(model_matrix, (float(atan2(ring.coordinate_system.forward.x, ring.coordinate_system.forward.z))), glm::vec3(0, 1, 0));
+		model_matrix = glm::translate(model_matrix, glm::vec3(render.position));
+		model_matrix = glm::rotate(model_matrix, (float(atan2(render.forward.x, render.forward.z))), glm::vec3(0, 1, 0));
 		glm::mat4x4 mvp_matrix = vp_matrix *  model_matrix;
 
 		glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
@@ -191,13 +369,18 @@ void PickupManager::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat
 
 }
 
+CoordinateSystem PickupManager::interpolateRing(const PickupTransforms& transforms, unsigned i, float fraction)
+{
+	const float ring_fraction = transforms.ring_fraction_starts[i] + transforms.ring_fraction_steps[i] * fraction;
+	return CoordinateSystem::interpolate(transforms.previous_rings[i], transforms.rings[i], std::min(ring_fraction, 1.0f));
+}
+
 void PickupManager::drawDepth(const glm::mat4x4& depth_view_projection_matrix) const
 {
-		MeshWithShader mesh = rings[0].model->getMesh(0, 0);
+		MeshWithShader mesh = ring_model->getMesh(0, 0);
 
 	for (auto const& ring : rings)
 	{
-		if (ring.pickedUp) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
 		model_matrix = glm::translate(model_matrix, glm::vec3(ring.coordinate_system.position));
 		
@@ -206,10 +389,9 @@ void PickupManager::drawDepth(const glm::mat4x4& depth_view_projection_matrix) c
 		mesh.draw();
 	}
 	
-	mesh = rods[0].model->getMesh(0, 0);
+	mesh = rod_model->getMesh(0, 0);
 	for (auto const& rod : rods)
 	{
-		if (rod.pickedUp) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
 		model_matrix = glm::translate(model_matrix, glm::vec3(rod.coordinate_system.position));
 	
@@ -219,29 +401,29 @@ void PickupManager::drawDepth(const glm::mat4x4& depth_view_projection_matrix) c
 	}
 }
 
-void PickupManager::drawDepthOptimized(const Vector3& position, float radius, const glm::mat4x4& depth_view_projection_matrix) const
+void PickupManager::drawDepthOptimized(const PickupTransforms& transforms, float fraction,
+	const Vec3f& position, float radius, const glm::mat4x4& depth_view_projection_matrix) const
 {
-		MeshWithShader mesh = rings[0].model->getMesh(0, 0);
+		MeshWithShader mesh = ring_model->getMesh(0, 0);
 
-	for (auto const& ring : rings)
+	for (unsigned i = 0; i < transforms.rings.size(); i++)
 	{
-		if (ring.pickedUp) continue;
-		if(position.getDistanceSquared(ring.coordinate_system.position) > pow(radius + ring.radius, 2)) continue;
+		if(position.getDistanceSquared(transforms.rings[i].position) > pow(radius + Ring::radius, 2)) continue;
+		const CoordinateSystem render = interpolateRing(transforms, i, fraction);
 		glm::mat4x4 model_matrix = glm::mat4();
-		model_matrix = glm::translate(model_matrix, glm::vec3(ring.coordinate_system.position));
+		model_matrix = glm::translate(model_matrix, glm::vec3(render.position));
 		
 		glm::mat4x4 depth_mvp = depth_view_projection_matrix * model_matrix;
 		g_depth_texture.setDepthMVP(depth_mvp);
 		mesh.draw();
 	}
 	
-	mesh = rods[0].model->getMesh(0, 0);
-	for (auto const& rod : rods)
+	mesh = rod_model->getMesh(0, 0);
+	for (const Vec3f& rod_position : transforms.rods)
 	{
-		if (rod.pickedUp) continue;
-		if(position.getDistanceSquared(rod.coordinate_system.position) > pow(radius + rod.radius, 2)) continue;
+		if(position.getDistanceSquared(rod_position) > pow(radius + Rod::radius, 2)) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
-		model_matrix = glm::translate(model_matrix, glm::vec3(rod.coordinate_system.position));
+		model_matrix = glm::translate(model_matrix, glm::vec3(rod_position));
 	
 		glm::mat4x4 depth_mvp = depth_view_projection_matrix * model_matrix;
 		g_depth_texture.setDepthMVP(depth_mvp);
@@ -254,5 +436,10 @@ void PickupManager::destroy()
 {
 	rings.clear();
 	rods.clear();
+	ring_slots.clear();
+	rod_slots.clear();
+	ring_lod.resize(0);
+	ring_grid.clear();
+	rod_grid.clear();
 	score = 0;
 }
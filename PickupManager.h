@@ -5,17 +5,39 @@
 #include "lib/ObjLibrary/ModelWithShader.h"
 #include "Ring.h"
 #include "Rod.h"
+#include "CommandBuffer.h"
+#include "SimulationLod.h"
+#include "SpatialGrid.h"
 
 using ObjLibrary::ModelWithShader;
 
 class World;
 class MovementGraph;
 class Player;
+class StateHash;
 
+//Copies of the rings and rods that have not been picked up
+//Drawn instead of the pickups so they can be drawn while the pickups update on another thread
+struct PickupTransforms
+{
+	//Each ring before and after its last update
+	std::vector<CoordinateSystem> previous_rings;
+	std::vector<CoordinateSystem> rings;
+
+	//How far through each ring's last update interval the snapshot is, and how much further one tick takes it
+	//Rings the LOD moves every few ticks are drawn moving over all of those ticks
+	std::vector<float> ring_fraction_starts;
+	std::vector<float> ring_fraction_steps;
+	std::vector<Vec3f> rods;
+};
 
 //Contains the rings and rods pickups
 //Draws the rings and rods
 //Updates the rings and rods
+//Only rings and rods that have not been picked up are stored. They are kept packed at the
+//front of their vectors and removed by moving the last one into their place, so their
+//position in the vector changes. Each ring and rod has an index that never changes to
+//find it by
 
 
 class PickupManager
@@ -24,14 +46,56 @@ private:
 	ModelWithShader const* rod_model;
 	ModelWithShader const* ring_model;
 
-public:
+	//The rings and rods that have not been picked up
 	std::vector<Ring> rings;
-private:
 	std::vector<Rod> rods;
 
+	//The position in rings or rods of each ring or rod index, NOT_LIVE once picked up
+	const unsigned NOT_LIVE = 0xFFFFFFFF;
+	std::vector<unsigned> ring_slots;
+	std::vector<unsigned> rod_slots;
+
 	World const* world;
 	MovementGraph* world_graph;
 	unsigned int score;
+
+	//Rings and rods per job when updating on the job system
+	const unsigned RING_BATCH_SIZE = 64;
+	const unsigned PICKUP_BATCH_SIZE = 256;
+
+	//The width of the cells in the ring and rod grids
+	const float PICKUP_GRID_CELL_SIZE = 8.0f;
+
+	//Rings and rods that have not been picked up by position
+	//Picked up rings and rods are removed
+	SpatialGrid ring_grid;
+	SpatialGrid rod_grid;
+
+	//Rings and rods near the player found in the grids this update
+	std::vector<unsigned> ring_candidates;
+	std::vector<unsigned> rod_candidates;
+
+	//A ring or rod the player touched, found on a worker thread and applied in order
+	//The index is the ring or rod's index as its position changes when others are removed
+	struct PickupCommand
+	{
+		bool is_ring;
+		unsigned index;
+	};
+	CommandBuffer<PickupCommand> pickup_commands;
+
+	//Rings far from the player move less often
+	SimulationLod ring_lod;
+
+	//The length of the last tick, the time a snapshot's rings are drawn moving over before the next tick
+	double last_delta_time{};
+
+	//The search memory of each thread finding new ring paths
+	std::vector<SearchContext> search_contexts;
+
+	//The positions in rings of the rings that need a new path this update and the node each is going to
+	std::vector<unsigned> path_requests;
+	std::vector<unsigned> path_destinations;
 public:
 	PickupManager();
 
@@ -40,29 +104,52 @@ public:
 
 	//Updates every the position of each ring that hasnt been picked up
 	//Uses data from the world
-	void update(double delta_time);
+	//Rings are moved and search for new paths on the job system
+	//Rings far from the view's focus are moved less often by the ring LOD
+	void update(double delta_time, const LodView& view);
 	void pickupParticleExplosion(const glm::vec3& position);
 
 	//Checks if a position has collided with a ring or rod to know if they have been picked
-	//up and increments the score and marks them to no longer be drawn or updated
+	//up and increments the score and removes them
+	//Only rings and rods in the grid cells around the player are checked
+	//The checks run on the job system and the pickups are applied in ring then rod order
 	void checkForPickups(const Player& player);
 
 	int getScore()const;
 
+	//Returns the scheduler deciding how often each ring moves
+	const SimulationLod& getRingLod() const;
+
 	//Adds a new rod at a position with a score value
-	void addRod(ObjLibrary::Vector3 pos, unsigned int score_value);
+	void addRod(const Vec3f& pos, unsigned int score_value);
 
 	//Adds a ring, rings are given random positions from the movement graph
 	void addRing();
 
+	//Returns the ring with an index or nullptr if it has been picked up
+	//The pointer is valid until the next update or checkForPickups
+	const Ring* getRing(unsigned index) const;
+
+	//Returns the number of rings and rods that have not been picked up
+	unsigned getRingCount() const;
+	unsigned getRodCount() const;
+
+	//Adds the score and the rings and rods not picked up to a state hash
+	void hashState(StateHash& hash) const;
+
 	//Draws the rings and rods regardless of the model chosen
 	void draw(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix) const ;
 	void draw(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos) const;
 
 
-	//Draws the rings and rods optimally given the specific models by reducing material and mesh swaps
-	void drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix);
-	void drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos);
+	//Copies the coordinate systems of the rings and the positions of the rods
+	//The vectors keep their memory so copying every update does not allocate
+	void getTransforms(PickupTransforms& transforms) const;
+
+	//Draws copied rings and rods optimally given the specific models by reducing material and mesh swaps
+	//Rings are drawn a fraction of the way through the tick after the snapshot, along their own update interval
+	void drawOptimized(const PickupTransforms& transforms, float fraction,
+		const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos) const;
 
 	//Draw all of the disks to the depthRTT Shader
 	//depthMatrixID is the uniform location for the DepthMVP matrix that will be calculated here
@@ -70,9 +157,18 @@ public:
 
 	//Draws the rings and rods that are only within a radius of a position (most likely player position)
 	//If they are outside radius they will not be in the shadow map anyway so we don't need to draw them
-	void drawDepthOptimized(const ObjLibrary::Vector3& position, float radius, const glm::mat4x4& depth_view_projection_matrix) const;
+	void drawDepthOptimized(const PickupTransforms& transforms, float fraction,
+		const Vec3f& position, float radius, const glm::mat4x4& depth_view_projection_matrix) const;
 
 	//Destroys the vectors of rings and rods and reset score
 	void destroy();
+
+private:
+	//Removes a picked up ring or rod by moving the last one into its place
+	void removeRing(unsigned slot);
+	void removeRod(unsigned slot);
+
+	//Returns ring i of the transforms where it is drawn a fraction of the way through the next tick
+	static CoordinateSystem interpolateRing(const PickupTransforms& transforms, unsigned i, float fraction);
 };
 
@@ -5,12 +5,14 @@
 #include "lib/glm/gtc/matrix_transform.hpp"
 
 extern DepthTexture depth_texture;
+extern bool g_headless;
 
 void Player::init(const World& world)
 {
 
 	reset(world);
-	model.init();
+	if (!g_headless)
+		model.init();
 }
 
 void Player::updateAnimation(double delta_time)
@@ -21,20 +23,21 @@ void Player::updateAnimation(double delta_time)
 void Player::update(const World& world, double delta_time_seconds)
 {
 
-	Vector3 old_pos = getPosition();
-	Vector3 new_pos = old_pos + (velocity * delta_time_seconds);
+	const float delta_time = float(delta_time_seconds);
+	Vec3f old_pos = getPosition();
+	Vec3f new_pos = old_pos + (velocity * delta_time);
 
-	float height = world.getHeightAtCirclePosition(float(new_pos.x), float(new_pos.z), radius);
+	float height = world.getHeightAtCirclePosition(new_pos.x, new_pos.z, radius);
 
 	if (jumping)
 	{
 
-		velocity = velocity + Vector3(0, -9.8, 0) * delta_time_seconds;
+		velocity = velocity + Vec3f(0, -9.8f, 0) * delta_time;
 
 		//Check collision with disk
-		if (world.isCylinderCollisionWithDisk(Vector3(new_pos.x, new_pos.y, new_pos.z) + PLAYER_OFFSET, radius, 0.8f))
+		if (world.isCylinderCollisionWithDisk(new_pos + PLAYER_OFFSET, radius, 0.8f))
 		{
-			if (world.isCylinderCollisionWithDisk(Vector3(old_pos.x, old_pos.y, old_pos.z) + PLAYER_OFFSET, radius, 0.8f))
+			if (world.isCylinderCollisionWithDisk(old_pos + PLAYER_OFFSET, radius, 0.8f))
 			{
 				//Landing
 				jumping = false;
@@ -63,7 +66,7 @@ void Player::update(const World& world, double delta_time_seconds)
 
 			//Apply friction
 			float friction = world.getFrictionAtPosition(float(new_pos.x), float(new_pos.z));
-			velocity = velocity * pow(friction, delta_time_seconds);
+			velocity = velocity * std::pow(friction, delta_time);
 
 			//Apply Sliding
 			float min_slope = world.getSlopeFactorAtPosition(float(new_pos.x), float(new_pos.z));
@@ -89,7 +92,7 @@ void Player::update(const World& world, double delta_time_seconds)
 			if (slope > min_slope)
 			{
 				float a = ((slope - min_slope) * 10.0f) * float(delta_time_seconds);
-				Vector3 accel(min_dir.x, 0, min_dir.y);
+				Vec3f accel(float(min_dir.x), 0, float(min_dir.y));
 				accel *= a;
 				addAcceleration(accel);
 			}
@@ -114,12 +117,19 @@ void Player::update(const World& world, double delta_time_seconds)
 
 void Player::reset(const World& world)
 {
-	Vector3 pos = world.disks[0]->position;
-	pos.y = world.getHeightAtPointPosition(float(pos.x), float(pos.z));
+	Vec3f pos(world.disks[0]->position);
+	pos.y = world.getHeightAtPointPosition(pos.x, pos.z);
 	coordinate_system.setPosition(pos);
 	coordinate_system.setOrientation(PLAYER_INIT_FORWARD);
-	velocity = Vector3::ZERO;
+	velocity = Vec3f();
 	jumping = false;
+	//Snap to the reset position instead of sliding to it
+	savePreviousTransform();
+}
+
+void Player::savePreviousTransform()
+{
+	previous_coordinate_system = coordinate_system;
 }
 
 void Player::transitionAnimationTo(Player_State state)
@@ -133,50 +143,58 @@ bool Player::isStanding() const
 	return (model.getState() == Player_State::Standing);
 }
 
-void Player::setPosition(Vector3 pos)
+void Player::setPosition(const Vec3f& pos)
 {
 	coordinate_system.setPosition(pos);
 }
 
-Vector3 Player::getPosition() const
+Vec3f Player::getPosition() const
 {
 	return coordinate_system.getPosition();
 }
 
-Vector3 Player::getVelocity() const
+Vec3f Player::getVelocity() const
 {
 	return velocity;
 }
 
-void Player::draw(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix,
-	const glm::vec3& camera_position) const
+AnimationPose Player::getAnimationPose() const
+{
+	return model.getPose();
+}
+
+void Player::draw(const CoordinateSystem& render_coordinate_system, const AnimationPose& pose,
+	const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_position) const
 {
-	Vector3 pos = coordinate_system.getPosition();
-	pos.y += 0.8;
-	const Vector3& forward = coordinate_system.getForward();
+	const CoordinateSystem& render = render_coordinate_system;
+	Vec3f pos = render.getPosition();
+	pos.y += 0.8f;
+	const Vec3f& forward = render.getForward();
 	//Draw the player
 	glm::mat4 model_matrix = glm::mat4();
 	model_matrix = translate(model_matrix, glm::vec3(pos));
 	model_matrix = rotate(model_matrix, (float(atan2(forward.x, forward.z)) - float(MathHelper::M_PI_2)),
-		glm::vec3(coordinate_system.getUp()));
+		glm::vec3(render.getUp()));
 
 
-	model.draw(model_matrix, view_matrix, projection_matrix, camera_position);
+	model.draw(pose, model_matrix, view_matrix, projection_matrix, camera_position);
 }
 
-void Player::drawToDepth(const glm::mat4x4& depth_view_projection_matrix) const
+void Player::drawToDepth(const CoordinateSystem& render_coordinate_system, const AnimationPose& pose,
+	const glm::mat4x4& depth_view_projection_matrix) const
 {
-	Vector3 pos = coordinate_system.getPosition();
-	pos.y += 0.8;
-	Vector3 forward = coordinate_system.getForward();
+	const CoordinateSystem& render = render_coordinate_system;
+	Vec3f pos = render.getPosition();
+	pos.y += 0.8f;
+	Vec3f forward = render.getForward();
 	glm::mat4 model_matrix = glm::mat4();
 	model_matrix = glm::translate(model_matrix, glm::vec3(pos));
 
-	model_matrix = glm::rotate(model_matrix, (float(atan2(forward.x, forward.z)) - float(MathHelper::M_PI_2)), glm::vec3(coordinate_system.getUp()));;
+	model_matrix = glm::rotate(model_matrix, (float(atan2(forward.x, forward.z)) - float(MathHelper::M_PI_2)), glm::vec3(render.getUp()));;
 	glm::mat4 depth_mvp = depth_view_projection_matrix * model_matrix;
 
 	g_depth_texture.setDepthMVP(depth_mvp);
-	model.drawToDepth();
+	model.drawToDepth(pose);
 }
 
 float Player::getRadius() const
@@ -189,7 +207,7 @@ float Player::getHalfHeight() const
 	return half_height;
 }
 
-void Player::addAcceleration(const Vector3& a)
+void Player::addAcceleration(const Vec3f& a)
 {
 	if (!jumping)
 		velocity += a;
@@ -198,13 +216,13 @@ void Player::addAcceleration(const Vector3& a)
 void Player::jump()
 {
 	if (jumping) return;
-	velocity = coordinate_system.getForward() * JUMP_FORWARD_SPEED + Vector3(0, JUMP_UP_SPEED, 0);
+	velocity = coordinate_system.getForward() * JUMP_FORWARD_SPEED + Vec3f(0, JUMP_UP_SPEED, 0);
 	model.transitionTo(Player_State::Jumping);
 	jumping = true;
 
 }
 
-void Player::hitByBat(const Vector3& bat_velocity)
+void Player::hitByBat(const Vec3f& bat_velocity)
 {
 	
 	if (jumping)
@@ -212,7 +230,7 @@ void Player::hitByBat(const Vector3& bat_velocity)
 		velocity += bat_velocity.getNormalized() * 7.0f;
 	} else
 	{
-		Vector3 bat_vel = bat_velocity;
+		Vec3f bat_vel = bat_velocity;
 		bat_vel.y = 0;
 		velocity = bat_vel.getNormalized() * 5.0f;
 		velocity.y = 5.0f;
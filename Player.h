@@ -7,9 +7,9 @@
 
 using ObjLibrary::Vector3;
 
-static const Vector3 PLAYER_OFFSET = Vector3(0.0f, 0.8f, 0.0f);
-static const Vector3 PLAYER_INIT_POS = Vector3(0.0f, 0.0f, 0.0f) + PLAYER_OFFSET;
-static const Vector3 PLAYER_INIT_FORWARD = Vector3(0, 0, -1);
+static const Vec3f PLAYER_OFFSET = Vec3f(0.0f, 0.8f, 0.0f);
+static const Vec3f PLAYER_INIT_POS = Vec3f(0.0f, 0.0f, 0.0f) + PLAYER_OFFSET;
+static const Vec3f PLAYER_INIT_FORWARD = Vec3f(0, 0, -1);
 
 //Meters per 1000 milliseconds
 static const float JUMP_FORWARD_SPEED = 8.0;
@@ -21,10 +21,12 @@ class Player
 public:
 	//Position and Orientation
 	CoordinateSystem coordinate_system;
+	//Position and Orientation before the last update, drawing blends from it to coordinate_system
+	CoordinateSystem previous_coordinate_system;
 
 private:
 	PlayerAnimatedModel model;
-	Vector3 velocity;
+	Vec3f velocity;
 	const float radius = 0.25f;
 	const float half_height = 0.8f;
 	bool jumping;
@@ -39,25 +41,37 @@ public:
 
 	void reset(const World& world);;
 
+	//Saves the coordinate system before it is changed by an update
+	void savePreviousTransform();
+
 	void transitionAnimationTo(Player_State state);
 
 	bool isStanding() const;
 
-	void setPosition(Vector3 pos);
-	Vector3 getPosition() const;
-	Vector3 getVelocity() const;
+	void setPosition(const Vec3f& pos);
+	Vec3f getPosition() const;
+	Vec3f getVelocity() const;
+
+	//Returns the state and frame of the player's animation
+	AnimationPose getAnimationPose() const;
 
-	void draw(const glm::mat4x4& view_matrix,
+	//Draws the player at a coordinate system with an animation pose
+	//Both are copies so the player can be drawn while it is updated on another thread
+	void draw(const CoordinateSystem& render_coordinate_system,
+		const AnimationPose& pose,
+		const glm::mat4x4& view_matrix,
 		const glm::mat4x4& projection_matrix,
 		const glm::vec3& camera_position) const;
 
-	void drawToDepth(const glm::mat4x4& depth_view_projection_matrix) const;
+	void drawToDepth(const CoordinateSystem& render_coordinate_system,
+		const AnimationPose& pose,
+		const glm::mat4x4& depth_view_projection_matrix) const;
 
 	float getRadius() const;
 	float getHalfHeight() const;
 
-	void addAcceleration(const Vector3& a);
+	void addAcceleration(const Vec3f& a);
 	void jump();
 
-	void hitByBat(const Vector3& bat_velocity);
+	void hitByBat(const Vec3f& bat_velocity);
 };
@@ -1,5 +1,5 @@
 #include "PlayerAnimatedModel.h"
-#include <lib/glm/gtc/matrix_transform.inl>
+#include "lib/glm/gtc/matrix_transform.hpp"
 #include "MathHelper.h"
 
 void PlayerAnimatedModel::init()
@@ -43,6 +43,15 @@ Player_State PlayerAnimatedModel::getState() const
 	return state;
 }
 
+AnimationPose PlayerAnimatedModel::getPose() const
+{
+	AnimationPose pose;
+	pose.state = state;
+	pose.run_state = run_state;
+	pose.time_into_frame = time_into_frame;
+	return pose;
+}
+
 void PlayerAnimatedModel::updateAnimation(double delta_time)
 {
 	int i = int(run_state);
@@ -80,11 +89,11 @@ void PlayerAnimatedModel::updateAnimation(double delta_time)
 	}
 }
 
-void PlayerAnimatedModel::draw(const glm::mat4x4& model_matrix, const glm::mat4x4& view_matrix,
+void PlayerAnimatedModel::draw(const AnimationPose& pose, const glm::mat4x4& model_matrix, const glm::mat4x4& view_matrix,
 	const glm::mat4x4& projection_matrix, const glm::vec3& camera_position) const
 {
 	glm::mat4 model = model_matrix;
-	switch (state)
+	switch (pose.state)
 	{
 	case Player_State::Running:
 	case Player_State::Strafing:
@@ -93,14 +102,14 @@ void PlayerAnimatedModel::draw(const glm::mat4x4& model_matrix, const glm::mat4x
 	}
 
 	const glm::mat4 model_view_projection_matrix = projection_matrix * view_matrix * model;
-	switch (state)
+	switch (pose.state)
 	{
 	case Player_State::Running:
 	case Player_State::Strafing:
 	case Player_State::Reversing:
 	{
-		float tween = time_into_frame / run_frames[(int)run_state].duration;
-		run_frames[(int)run_state].model.draw(tween, model, view_matrix, model_view_projection_matrix,
+		float tween = pose.time_into_frame / run_frames[(int)pose.run_state].duration;
+		run_frames[(int)pose.run_state].model.draw(tween, model, view_matrix, model_view_projection_matrix,
 			camera_position);
 		break;
 	}
@@ -118,25 +127,25 @@ void PlayerAnimatedModel::draw(const glm::mat4x4& model_matrix, const glm::mat4x
 	}
 }
 
-void PlayerAnimatedModel::drawToDepth() const
+void PlayerAnimatedModel::drawToDepth(const AnimationPose& pose) const
 {
 
-	switch (state)
+	switch (pose.state)
 	{
 	case Player_State::Running:
 	case Player_State::Reversing:
 	case Player_State::Strafing:
 	{
-		float tween = time_into_frame / run_frames[(int)run_state].duration;
+		float tween = pose.time_into_frame / run_frames[(int)pose.run_state].duration;
 		g_depth_texture.enableTween(tween);
 
-		const unsigned int mat_count = run_frames[(int)run_state].model.getMaterialCount();
+		const unsigned int mat_count = run_frames[(int)pose.run_state].model.getMaterialCount();
 		for (unsigned int i = 0; i < mat_count; i++)
 		{
-			const unsigned int mesh_count = run_frames[(int)run_state].model.getMeshCount(i);
+			const unsigned int mesh_count = run_frames[(int)pose.run_state].model.getMeshCount(i);
 			for (unsigned int j = 0; j < mesh_count; j++)
 			{
-				const MeshWithShader& m = run_frames[(int)run_state].model.getMesh(i, j);
+				const MeshWithShader& m = run_frames[(int)pose.run_state].model.getMesh(i, j);
 				m.draw();
 			}
 		}
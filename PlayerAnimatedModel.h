@@ -29,6 +29,15 @@ enum class Run_State
 	StartReverse = 6
 };
 
+//The animation state drawn for a frame
+//Copied from the simulation so the model can be drawn on another thread
+struct AnimationPose
+{
+	Player_State state{};
+	Run_State run_state{};
+	float time_into_frame{};
+};
+
 struct Frame
 {
 	ObjLibrary::KeyframeModelWithShader model;
@@ -58,14 +67,18 @@ public:
 
 	Player_State getState() const;
 
+	//Returns the current state and frame of the animation
+	AnimationPose getPose() const;
+
 	void updateAnimation(double delta_time);
 
-	void draw(const glm::mat4x4& model_matrix,
+	void draw(const AnimationPose& pose,
+		const glm::mat4x4& model_matrix,
 		const glm::mat4x4& view_matrix,
 		const glm::mat4x4& model_view_projection_matrix,
 		const glm::vec3& camera_position) const;
 
-	void drawToDepth() const;
+	void drawToDepth(const AnimationPose& pose) const;
 
 
 	void transitionTo(Player_State new_state);
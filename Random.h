@@ -14,6 +14,9 @@ public:
 
 	static void init();
 
+	//Seeds the generator so the same numbers are made every run
+	static void seed(unsigned int seed);
+
 	//Get random int from [0, max)
 	static int randi(int max);
 
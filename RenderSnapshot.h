@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include "CoordinateSystem.h"
+#include "PlayerAnimatedModel.h"
+#include "PickupManager.h"
+#include "MovementGraph.h"
+#include "SimulationLod.h"
+#include "PerformanceCounter.h"
+#include "ParticleEmitter.h"
+
+//Everything Game::display draws that changes in Game::update
+//Filled on the simulation thread after an update and drawn on the display thread,
+//so drawing never reads the game while it is being updated.
+//Objects that move are stored before and after the update so they can be drawn in between
+struct RenderSnapshot
+{
+	//The update the snapshot was taken after
+	long long update_count{};
+
+	//Started when the snapshot was taken, to find how far the display is towards the next update
+	PerformanceCounter since_taken;
+	//The update lag left over when the snapshot was taken
+	double update_lag{};
+	double time_scale{ 1.0 };
+
+	CoordinateSystem previous_player;
+	CoordinateSystem player;
+	AnimationPose player_pose;
+
+	CoordinateSystem previous_camera;
+	CoordinateSystem camera;
+	bool overview_camera_active{};
+
+	struct BatTransform
+	{
+		Vec3f previous_position;
+		Vec3f position;
+		Vec3f forward;
+	};
+	std::vector<BatTransform> bats;
+
+	PickupTransforms pickups;
+	int score{};
+
+	//Ring 0 and the path it follows, only drawn while ring 0 has not been picked up
+	bool has_ring_zero{};
+	Vec3f ring_zero_position;
+	Vec3f ring_zero_target_position;
+	unsigned ring_zero_target_node_id{};
+	Path ring_zero_path;
+
+	//The nodes visited by ring 0's last search, only copied while the overview camera is active
+	std::vector<MemorizedNode> search_data;
+
+	//Bats and rings in each simulation LOD band
+	unsigned lod_band_counts[SimulationLod::BAND_COUNT]{};
+	unsigned lod_entity_count{};
+
+	//The GPU data of the particles alive after the update
+	std::vector<ParticleVertex> particle_data;
+	glm::vec3 particle_origin;
+	ParticleCounters particle_counters;
+};
@@ -4,104 +4,226 @@
 #include "MovementGraph.h"
 #include "Random.h"
 #include "MathHelper.h"
+#include "Disk.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 
 Ring::Ring(unsigned i, const World& w, MovementGraph* mg, const ModelWithShader& model) : Entity(model)
 {
 	index = i;
 
-	pickedUp = false;
 	world = &w;
 	world_graph = mg;
 
-	curr_node_id = Random::randu(world_graph->getNodeList().size() - 1);;
+	//Without any nodes the ring waits at the origin until it can find a path
+	curr_node_id = chooseRandomNode(NO_VERTEX_FOUND);
 	target_node_id = curr_node_id;
-	targetPosition = world_graph->getNodeList()[target_node_id].position;
+	if (curr_node_id != NO_VERTEX_FOUND)
+		targetPosition = Vec3f(world_graph->getNodeList()[target_node_id].position);
+	else
+		targetPosition = Vec3f(0, 0, 0);
 	coordinate_system.setPosition({targetPosition.x, targetPosition.y + 0.1f, targetPosition.z});
 	coordinate_system.setOrientation({0,0,-1},{0,1,0});
+	savePreviousTransform();
+	buildTrajectory();
 }
 
-inline void Ring::update(double delta_time)
+void Ring::update(double delta_time)
 {
-	const Vector3& position = coordinate_system.getPosition();
-	Vector3 direction = targetPosition - position;
-	direction.normalizeSafe();
-
-	const float speed_factor = world->getSpeedFactorAtPosition(float(position.x), float(position.z));
-	const float distance = velocity * float(delta_time) * speed_factor;
-
-	if (world_graph->getNodeList()[curr_node_id].disk_id == world_graph->getNodeList()[target_node_id].disk_id)
+	move(delta_time);
+	if (needs_path)
 	{
-		//Arc rotate around disk
+		followPathTo(chooseDestination(), nullptr);
 
-		double old_dist = position.getDistance(targetPosition);
-		Vector3 old_pos = position;
-		const Vector3 center = world->disks[world_graph->getNodeList()[curr_node_id].disk_id]->position;
-		Vector3 center_to_ring = position - center;
-		//Vector3 dir_center_to_target = targetPosition - center;
-		const Vector3 dir_pos_to_target = targetPosition - position;
-		const double tangent_angle = center_to_ring.getRotatedY(MathHelper::M_PI_2).getAngle(dir_pos_to_target);
+		//Remembers Ring 0s search data for display later
+		if (index == 0)
+			world_graph->memorizeLastSearch();
+	}
+}
 
+void Ring::savePreviousTransform(double delta_time)
+{
+	if (delta_time < update_interval)
+		previous_coordinate_system = CoordinateSystem::interpolate(previous_coordinate_system, coordinate_system,
+			float(delta_time / update_interval));
+	else
+		previous_coordinate_system = coordinate_system;
+	update_interval = delta_time;
+}
 
-		//The radius to rotate around the the disk radius - 0.7;
-		const float rad = world->disks[world_graph->getNodeList()[curr_node_id].disk_id]->radius - 0.7f;
+void Ring::move(double delta_time, bool animate)
+{
+	assert(!trajectory.speed_factors.empty());
 
-		//The angle to rotate using arc length formula
-		const float angle = distance / rad;
+	//Speed and height come from the samples taken when the trajectory was built
+	const unsigned sample = std::min(unsigned(travelled / TRAJECTORY_SAMPLE_SPACING), unsigned(trajectory.speed_factors.size() - 1));
+	float distance = velocity * float(delta_time) * trajectory.speed_factors[sample];
 
-		//Rotate around the disk in the shorter direction
-		if (tangent_angle < MathHelper::M_PI_2)
-			center_to_ring.rotateY(angle);
-		else
-			center_to_ring.rotateY(-angle);
+	//Stop at the target instead of passing it
+	const bool arrived = travelled + distance >= trajectory.length;
+	if (arrived)
+		distance = trajectory.length - travelled;
+	travelled += distance;
 
+	coordinate_system.position = getTrajectoryPosition(travelled);
 
-		//To Make sure we don't drift off the radius
-		coordinate_system.position = center + center_to_ring.getNormalized() * rad;
+	//Set the rings height based on the world height between the samples either side of it
+	const float sample_position = travelled / TRAJECTORY_SAMPLE_SPACING;
+	const unsigned before = std::min(unsigned(sample_position), unsigned(trajectory.heights.size() - 1));
+	const unsigned after = std::min(before + 1, unsigned(trajectory.heights.size() - 1));
+	const float blend = std::min(sample_position - float(before), 1.0f);
+	coordinate_system.position.y = trajectory.heights[before] + (trajectory.heights[after] - trajectory.heights[before]) * blend + 0.1f;
 
-	} else
+	//Rotate the ring's forward based on how much we moved
+	pending_spin += rotVelocity * distance;
+	if (animate)
 	{
-		//Move direct to another disk
-
-		coordinate_system.position += direction * distance;
+		coordinate_system.forward.rotateY(pending_spin);
+		pending_spin = 0.0f;
 	}
 
-	//Rotate the ring's forward based on how much we moved
-	coordinate_system.forward.rotateY(rotVelocity * distance);
-	
-	//Set the rings height based on the world height at the position
-	coordinate_system.position.y = world->getHeightAtCirclePosition(float(position.x), float(position.z), radius) + 0.1f;
-
-
 	//If on center of disk get new target
-	if (Collision::pointCircleIntersection(float(targetPosition.x), float(targetPosition.z), float(position.x), float(position.z), 0.1f))
+	if (arrived)
 	{
 		curr_node_id = target_node_id;
+
+		//Wait for a new path if this one is finished
 		if (path.empty())
 		{
-			//Get a random node that is not this same node
-			unsigned rand = Random::randu(world_graph->getNodeList().size() - 1);
-			while (rand == curr_node_id) rand = Random::randu(world_graph->getNodeList().size() - 1);
-
-
-			//Remembers Ring 0s search data for display later
-			if (index == 0)
-			{
-				//Perform all the searches so we can record the visits required for all
-				path = world_graph->dijkstraSearch(curr_node_id, rand);
-				path = world_graph->aStarSearch(curr_node_id, rand);
-				path = world_graph->mmSearch(curr_node_id, rand);
-				world_graph->memorizeLastSearch();
-			} else
-			{
-				//Get the path between the nodes
-				path = world_graph->mmSearch(curr_node_id, rand);
-			}
-			//Pop the node off the front and set it as the target
+			needs_path = true;
+			return;
 		}
-		target_node_id = path.front();
-		path.pop_front();
-		targetPosition = world_graph->getNodeList()[target_node_id].position;
+		takeNextTarget();
+	}
+}
+
+unsigned Ring::chooseDestination() const
+{
+	return chooseRandomNode(curr_node_id);
+}
+
+unsigned Ring::chooseRandomNode(unsigned excluded_node_id) const
+{
+	const std::vector<unsigned>& active_ids = world_graph->getActiveNodeIds();
+	const bool exclude = world_graph->isNodeActive(excluded_node_id);
+	const unsigned choice_count = unsigned(active_ids.size()) - (exclude ? 1 : 0);
+	if (choice_count == 0)
+		return NO_VERTEX_FOUND;
+
+	//The ids are in increasing order, so the choices from the excluded node's place onwards are one further along
+	unsigned choice = Random::randu(choice_count - 1);
+	if (exclude && active_ids[choice] >= excluded_node_id)
+		choice++;
+	return active_ids[choice];
+}
+
+void Ring::followPathTo(unsigned destination, SearchContext* context)
+{
+	//Without a node to go to the ring waits, it tries again on its next update
+	path.clear();
+	if (destination == NO_VERTEX_FOUND) return;
+
+	//A ring that is not on a node heads straight for the destination
+	if (!world_graph->isNodeActive(curr_node_id))
+	{
+		path.pushFront(destination);
+		needs_path = false;
+		takeNextTarget();
+		return;
+	}
 
+	if (index == 0)
+	{
+		//Perform all the searches so we can record the visits required for all
+		if (context == nullptr)
+		{
+			world_graph->dijkstraSearch(curr_node_id, destination, path);
+			world_graph->aStarSearch(curr_node_id, destination, path);
+			world_graph->mmSearch(curr_node_id, destination, path);
+		} else
+		{
+			world_graph->dijkstraSearch(curr_node_id, destination, path, *context);
+			world_graph->aStarSearch(curr_node_id, destination, path, *context);
+			world_graph->mmSearch(curr_node_id, destination, path, *context);
+		}
+	} else
+	{
+		//Get the path between the nodes
+		if (context == nullptr)
+			world_graph->mmSearch(curr_node_id, destination, path);
+		else
+			world_graph->mmSearch(curr_node_id, destination, path, *context);
+	}
+
+	//The destination can not be reached if the graph was split, so the ring waits for another one
+	if (path.empty()) return;
+	needs_path = false;
+	takeNextTarget();
+}
+
+void Ring::takeNextTarget()
+{
+	//Pop the node off the front and set it as the target
+	target_node_id = path.front();
+	path.popFront();
+	targetPosition = Vec3f(world_graph->getNodeList()[target_node_id].position);
+	buildTrajectory();
+}
+
+void Ring::buildTrajectory()
+{
+	const Vec3f& position = coordinate_system.getPosition();
+	const std::vector<Node>& node_list = world_graph->getNodeList();
+
+	//Rings without a node have a target at their own position, so they stay where they are
+	trajectory.is_arc = curr_node_id != target_node_id && world_graph->isNodeActive(curr_node_id) &&
+		target_node_id != NO_VERTEX_FOUND && node_list[curr_node_id].disk_id == node_list[target_node_id].disk_id;
+	if (trajectory.is_arc)
+	{
+		//Arc around the disk at the radius of its nodes
+		const Disk& disk = *world->disks[node_list[curr_node_id].disk_id];
+		trajectory.center = Vec3f(disk.position);
+		trajectory.arc_radius = disk.radius - 0.7f;
+		trajectory.start_angle = float(atan2(position.z - disk.position.z, position.x - disk.position.x));
+
+		//Go around the disk in the shorter direction
+		const float end_angle = float(atan2(targetPosition.z - disk.position.z, targetPosition.x - disk.position.x));
+		float turn = end_angle - trajectory.start_angle;
+		if (turn > MathHelper::M_PI) turn -= float(MathHelper::M_2PI);
+		if (turn < -MathHelper::M_PI) turn += float(MathHelper::M_2PI);
+		trajectory.turn_direction = turn < 0 ? -1.0f : 1.0f;
+		trajectory.length = std::abs(turn) * trajectory.arc_radius;
+	} else
+	{
+		//Straight to another disk
+		trajectory.start = Vec3f(position.x, 0, position.z);
+		trajectory.direction = Vec3f(targetPosition.x - position.x, 0, targetPosition.z - position.z);
+		trajectory.length = trajectory.direction.getNorm();
+		trajectory.direction.normalizeSafe();
+	}
+	travelled = 0.0f;
+
+	//Sample the world along the trajectory, including both ends
+	const unsigned sample_count = unsigned(trajectory.length / TRAJECTORY_SAMPLE_SPACING) + 2;
+	trajectory.heights.clear();
+	trajectory.speed_factors.clear();
+	for (unsigned i = 0; i < sample_count; i++)
+	{
+		const float distance = std::min(float(i) * TRAJECTORY_SAMPLE_SPACING, trajectory.length);
+		const Vec3f sample = getTrajectoryPosition(distance);
+		trajectory.heights.push_back(world->getHeightAtCirclePosition(sample.x, sample.z, radius));
+		trajectory.speed_factors.push_back(world->getSpeedFactorAtPosition(sample.x, sample.z));
+	}
+}
+
+Vec3f Ring::getTrajectoryPosition(float distance) const
+{
+	if (trajectory.is_arc)
+	{
+		const float angle = trajectory.start_angle + trajectory.turn_direction * distance / trajectory.arc_radius;
+		return trajectory.center + Vec3f(std::cos(angle), 0, std::sin(angle)) * trajectory.arc_radius;
 	}
+	return trajectory.start + trajectory.direction * distance;
 }
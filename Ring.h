@@ -1,5 +1,6 @@
 #pragma once
 #pragma once
+#include <vector>
 #include "Entity.h"
 #include "MovementGraph.h"
 
@@ -8,24 +9,104 @@ class World;
 class Ring : public Entity
 {
 public:
+	using Entity::savePreviousTransform;
+
+	//The ring's id, it stays the same when PickupManager moves rings around
 	unsigned index;
 	World const* world;
 	MovementGraph* world_graph;
 	
-	const int pointValue = 1;
-	const float velocity = 2.5f / 1000.0f;
-	const float rotVelocity = 1.3f;
-	const float radius = 0.7f;
-	const float halfHeight = 0.1f;
-	bool pickedUp;
-	Vector3 targetPosition;
-
-	std::deque<unsigned> path;
+	//Static so rings can be assigned when PickupManager swaps them around
+	static constexpr int pointValue = 1;
+	static constexpr float velocity = 2.5f / 1000.0f;
+	static constexpr float rotVelocity = 1.3f;
+	static constexpr float radius = 0.7f;
+	static constexpr float halfHeight = 0.1f;
+
+	//Distance between the samples of world height and speed factor along a trajectory
+	static constexpr float TRAJECTORY_SAMPLE_SPACING = 1.0f;
+
+	Vec3f targetPosition;
+
+	//The way from the ring's position to its target node
+	//Built once when the ring gets a new target so moving only steps along it
+	struct Trajectory
+	{
+		//Rings go around a disk in an arc between two nodes on the same disk
+		//and in a straight line between nodes on different disks
+		bool is_arc = false;
+
+		//Straight lines go from start along direction
+		Vec3f start;
+		Vec3f direction;
+
+		//Arcs go around center at arc_radius from start_angle, increasing the angle
+		//if turn_direction is 1 and decreasing it if it is -1
+		Vec3f center;
+		float arc_radius = 0.0f;
+		float start_angle = 0.0f;
+		float turn_direction = 1.0f;
+
+		float length = 0.0f;
+
+		//The world height and speed factor every TRAJECTORY_SAMPLE_SPACING along the trajectory
+		std::vector<float> heights;
+		std::vector<float> speed_factors;
+	};
+	Trajectory trajectory;
+
+	//How far the ring has moved along its trajectory
+	float travelled = 0.0f;
+
+	Path path;
 	unsigned curr_node_id;
 	unsigned target_node_id;
 
+	//Set when the ring reached the end of its path and is waiting for a new one
+	bool needs_path = false;
+
+	//Spin skipped while the ring was off screen, applied when it is next animated
+	float pending_spin = 0.0f;
+
+	//The time the ring's last move covered, several ticks for rings the LOD moves less often
+	//The ring is drawn moving from previous_coordinate_system over this time
+	double update_interval = 0.0;
+
 	explicit Ring(unsigned i, const World& w, MovementGraph* mg, const ModelWithShader& model);;
 
+	//Moves the ring and finds a new path when it reaches the end of its path
 	void update(double delta_time) override;
+
+	//Saves the coordinate system the ring is drawn from before it moves for a time
+	//A ring moving before the end of its last update interval starts from where it is drawn so it does not jump
+	void savePreviousTransform(double delta_time);
+
+	//Moves the ring along its path and sets needs_path when it reaches the end
+	//Only reads the world and movement graph so rings can be moved on several threads
+	//Rings that are not animated save their spin for later
+	void move(double delta_time, bool animate = true);
+
+	//Returns a random node other than the current one to find a path to
+	//Returns NO_VERTEX_FOUND if there is no other node
+	unsigned chooseDestination() const;
+
+	//Searches a path to the destination and starts following it
+	//Searches with the context if one is given so rings can search on several threads
+	//If there is no path the ring keeps needs_path set and waits where it is
+	//A ring that is not on a node, because there were none, goes straight to the destination
+	void followPathTo(unsigned destination, SearchContext* context);
+
+private:
+	//Returns a random node that has not been removed, other than the excluded node
+	//Returns NO_VERTEX_FOUND if there is none
+	unsigned chooseRandomNode(unsigned excluded_node_id) const;
+
+	void takeNextTarget();
+
+	//Builds the trajectory from the ring's position to the target node
+	void buildTrajectory();
+
+	//Returns the XZ position a distance along the trajectory
+	Vec3f getTrajectoryPosition(float distance) const;
 };
 
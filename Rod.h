@@ -4,21 +4,20 @@
 class Rod : public Entity
 {
 public:
+	//The rod's id, it stays the same when PickupManager moves rods around
+	unsigned index;
 	unsigned int pointValue;
-	bool pickedUp;
-	float radius;
-	float halfHeight;
+	//Static so rods can be drawn from copies of their positions
+	static constexpr float radius = 0.1f;
+	static constexpr float halfHeight = 1.0f;
 
-	Rod(const ModelWithShader& model, Vector3 position, unsigned int value);
+	Rod(unsigned i, const ModelWithShader& model, Vec3f position, unsigned int value);
 
 	void update(double delta_time) override;
 };
 
-inline Rod::Rod(const ModelWithShader& model, Vector3 position, unsigned value): Entity(model, Vector3(position.x, position.y + 1.0f, position.z)), pointValue(value)
+inline Rod::Rod(unsigned i, const ModelWithShader& model, Vec3f position, unsigned value): Entity(model, Vec3f(position.x, position.y + 1.0f, position.z)), index(i), pointValue(value)
 {
-	pickedUp = false;
-	radius = 0.1f;
-	halfHeight = 1.0f;
 }
 
 inline void Rod::update(double delta_time)
@@ -1,5 +1,8 @@
 #pragma once
 #include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
 
 //SIMD functions to perform many calculations more quickly
 
@@ -194,4 +197,127 @@ inline void SquareRootSIMD(float* result, const int size1, const float* x)
 	{
 		_mm_store_ps(result + i, _mm_sqrt_ps(_mm_load_ps(x + i)));
 	}
-}
\ No newline at end of file
+}
+
+
+//Lane width independent helpers for structure of arrays updates
+//Uses 8 float lanes when compiled with AVX (/arch:AVX) and 4 SSE lanes otherwise
+//Loads and stores are unaligned so they can be used on std::vector data
+//A mask lane is all bits set when the comparison was true
+#ifdef __AVX__
+
+typedef __m256 simd_float;
+const unsigned SIMD_WIDTH = 8;
+
+inline simd_float simdLoad(const float* x) { return _mm256_loadu_ps(x); }
+inline void simdStore(float* result, simd_float a) { _mm256_storeu_ps(result, a); }
+inline simd_float simdSet1(float a) { return _mm256_set1_ps(a); }
+inline simd_float simdAdd(simd_float a, simd_float b) { return _mm256_add_ps(a, b); }
+inline simd_float simdSub(simd_float a, simd_float b) { return _mm256_sub_ps(a, b); }
+inline simd_float simdMul(simd_float a, simd_float b) { return _mm256_mul_ps(a, b); }
+inline simd_float simdDiv(simd_float a, simd_float b) { return _mm256_div_ps(a, b); }
+inline simd_float simdSqrt(simd_float a) { return _mm256_sqrt_ps(a); }
+inline simd_float simdMin(simd_float a, simd_float b) { return _mm256_min_ps(a, b); }
+inline simd_float simdMax(simd_float a, simd_float b) { return _mm256_max_ps(a, b); }
+inline simd_float simdLess(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline simd_float simdLessEqual(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline simd_float simdGreater(simd_float a, simd_float b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+inline simd_float simdAnd(simd_float a, simd_float b) { return _mm256_and_ps(a, b); }
+inline simd_float simdOr(simd_float a, simd_float b) { return _mm256_or_ps(a, b); }
+inline simd_float simdAndNot(simd_float mask, simd_float a) { return _mm256_andnot_ps(mask, a); }
+//Picks a where the mask is set and b everywhere else
+inline simd_float simdSelect(simd_float mask, simd_float a, simd_float b) { return _mm256_blendv_ps(b, a, mask); }
+//Returns one bit per lane, lane 0 in the lowest bit
+inline int simdMoveMask(simd_float mask) { return _mm256_movemask_ps(mask); }
+
+//Returns lanes 4 * part to 4 * part + 3, part is less than SIMD_SSE_PARTS
+inline __m128 simdGetSSEPart(simd_float a, unsigned part)
+{
+	return part == 0 ? _mm256_castps256_ps128(a) : _mm256_extractf128_ps(a, 1);
+}
+
+#else
+
+typedef __m128 simd_float;
+const unsigned SIMD_WIDTH = 4;
+
+inline simd_float simdLoad(const float* x) { return _mm_loadu_ps(x); }
+inline void simdStore(float* result, simd_float a) { _mm_storeu_ps(result, a); }
+inline simd_float simdSet1(float a) { return _mm_set_ps1(a); }
+inline simd_float simdAdd(simd_float a, simd_float b) { return _mm_add_ps(a, b); }
+inline simd_float simdSub(simd_float a, simd_float b) { return _mm_sub_ps(a, b); }
+inline simd_float simdMul(simd_float a, simd_float b) { return _mm_mul_ps(a, b); }
+inline simd_float simdDiv(simd_float a, simd_float b) { return _mm_div_ps(a, b); }
+inline simd_float simdSqrt(simd_float a) { return _mm_sqrt_ps(a); }
+inline simd_float simdMin(simd_float a, simd_float b) { return _mm_min_ps(a, b); }
+inline simd_float simdMax(simd_float a, simd_float b) { return _mm_max_ps(a, b); }
+inline simd_float simdLess(simd_float a, simd_float b) { return _mm_cmplt_ps(a, b); }
+inline simd_float simdLessEqual(simd_float a, simd_float b) { return _mm_cmple_ps(a, b); }
+inline simd_float simdGreater(simd_float a, simd_float b) { return _mm_cmpgt_ps(a, b); }
+inline simd_float simdAnd(simd_float a, simd_float b) { return _mm_and_ps(a, b); }
+inline simd_float simdOr(simd_float a, simd_float b) { return _mm_or_ps(a, b); }
+inline simd_float simdAndNot(simd_float mask, simd_float a) { return _mm_andnot_ps(mask, a); }
+//Picks a where the mask is set and b everywhere else
+inline simd_float simdSelect(simd_float mask, simd_float a, simd_float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+//Returns one bit per lane, lane 0 in the lowest bit
+inline int simdMoveMask(simd_float mask) { return _mm_movemask_ps(mask); }
+
+//Returns lanes 4 * part to 4 * part + 3, part is less than SIMD_SSE_PARTS
+//There is only part 0 without AVX
+inline __m128 simdGetSSEPart(simd_float a, unsigned /*part*/)
+{
+	return a;
+}
+
+#endif
+
+//The number of 4 lane SSE parts in a simd_float
+//Integer work is done on the SSE parts since 8 lane integer operations need AVX2
+const unsigned SIMD_SSE_PARTS = SIMD_WIDTH / 4;
+
+//Converts 4 floats to half floats in the low 16 bits of each lane, rounding to nearest
+//Values too large for a half float become infinity
+inline __m128i halfFromFloatSSE(__m128 f)
+{
+	const __m128 sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+	const __m128 round_mask = _mm_castsi128_ps(_mm_set1_epi32(~0xfff));
+	const __m128i float_infinity = _mm_set1_epi32(255 << 23);
+	//Moves the exponent bias from float to half float
+	const __m128 bias_scale = _mm_castsi128_ps(_mm_set1_epi32(15 << 23));
+	//The largest value that does not round to infinity
+	const __m128 clamp = _mm_castsi128_ps(_mm_set1_epi32((31 << 23) - 0x1000));
+
+	const __m128 sign = _mm_and_ps(f, sign_mask);
+	const __m128 absolute = _mm_xor_ps(f, sign);
+	const __m128i absolute_bits = _mm_castps_si128(absolute);
+	const __m128i is_nan = _mm_cmpgt_epi32(absolute_bits, float_infinity);
+	const __m128i is_finite = _mm_cmpgt_epi32(float_infinity, absolute_bits);
+	const __m128i infinity_or_nan = _mm_or_si128(_mm_and_si128(is_nan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+
+	//Rescaling the exponent also handles half float denormals, subtracting the
+	//round mask adds 0x1000 so the shift rounds instead of truncating
+	const __m128 scaled = _mm_min_ps(_mm_mul_ps(_mm_and_ps(absolute, round_mask), bias_scale), clamp);
+	const __m128i rounded = _mm_srli_epi32(_mm_sub_epi32(_mm_castps_si128(scaled), _mm_castps_si128(round_mask)), 13);
+
+	const __m128i joined = _mm_or_si128(_mm_and_si128(is_finite, rounded), _mm_andnot_si128(is_finite, infinity_or_nan));
+	return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+//Stores 4 rows of 3 32 bit values, row i is lane i of a, b and c
+//Nothing after the 12 bytes of the last row is written
+inline void storeInterleaved3SSE(void* result, __m128i a, __m128i b, __m128i c)
+{
+	__m128 row_0 = _mm_castsi128_ps(a);
+	__m128 row_1 = _mm_castsi128_ps(b);
+	__m128 row_2 = _mm_castsi128_ps(c);
+	__m128 row_3 = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(row_0, row_1, row_2, row_3);
+
+	//Each row's fourth value is overwritten by the next row
+	float* destination = static_cast<float*>(result);
+	_mm_storeu_ps(destination, row_0);
+	_mm_storeu_ps(destination + 3, row_1);
+	_mm_storeu_ps(destination + 6, row_2);
+	_mm_storel_pi(reinterpret_cast<__m64*>(destination + 9), row_3);
+	_mm_store_ss(destination + 11, _mm_movehl_ps(row_3, row_3));
+}
@@ -91,13 +91,13 @@ public:
 	{
 		//const glm::mat4 rotation = glm::transpose(calculateCameraRotationMatrix());
 
-		const Vector3 forward_vector = (*cam)->getForward();
-		const Vector3 up_vector = (*cam)->getUp();
-		const Vector3 to_far = forward_vector * SHADOW_DISTANCE;
-		const Vector3 to_near = forward_vector * (CLIP_NEAR );
+		const Vec3f forward_vector = (*cam)->getForward();
+		const Vec3f up_vector = (*cam)->getUp();
+		const Vec3f to_far = forward_vector * SHADOW_DISTANCE;
+		const Vec3f to_near = forward_vector * (CLIP_NEAR );
 
-		const Vector3 center_near = to_near + (*cam)->getPosition();
-		const Vector3 center_far = to_far + (*cam)->getPosition();
+		const Vec3f center_near = to_near + (*cam)->getPosition();
+		const Vec3f center_far = to_far + (*cam)->getPosition();
 
 		glm::vec4* points = calculateFrustumVertices(up_vector, forward_vector, center_near,
 			center_far);
@@ -147,7 +147,7 @@ public:
 	*
 	* @return The center of the "view cuboid" in world space.
 	*/
-	Vector3 getCenter() const
+	Vec3f getCenter() const
 	{
 		const float x = (min_x + max_x) / 2.0f;
 		const float y = (min_y + max_y) / 2.0f;
@@ -155,7 +155,7 @@ public:
 		const glm::vec4 cen = glm::vec4(x, y, z, 1);
 
 		const glm::mat4x4 inverted_light = glm::inverse(*light_view_matrix);
-		Vector3 result(inverted_light * cen);
+		Vec3f result(glm::vec3(inverted_light * cen));
 		return result;
 	}
 
@@ -199,17 +199,17 @@ public:
 	*            plane.
 	* @return The positions of the vertices of the frustum in light space.
 	*/
-	glm::vec4* calculateFrustumVertices(const Vector3& up_vector, const Vector3& forward_vector,
-		const Vector3& center_near, const Vector3& center_far) const
+	glm::vec4* calculateFrustumVertices(const Vec3f& up_vector, const Vec3f& forward_vector,
+		const Vec3f& center_near, const Vec3f& center_far) const
 	{
 
-		const Vector3 right_vector = forward_vector.crossProduct(up_vector);
-		const Vector3 down_vector = -up_vector;
-		const Vector3 left_vector = -right_vector;
-		const Vector3 far_top = center_far + up_vector * far_height;
-		const Vector3 far_bottom = center_far + down_vector * far_height;
-		const Vector3 near_top = center_near + up_vector * near_height;
-		const Vector3 near_bottom = center_near + down_vector *  near_height;
+		const Vec3f right_vector = forward_vector.crossProduct(up_vector);
+		const Vec3f down_vector = -up_vector;
+		const Vec3f left_vector = -right_vector;
+		const Vec3f far_top = center_far + up_vector * far_height;
+		const Vec3f far_bottom = center_far + down_vector * far_height;
+		const Vec3f near_top = center_near + up_vector * near_height;
+		const Vec3f near_bottom = center_near + down_vector *  near_height;
 
 		auto* points = new glm::vec4[8];
 		points[0] = calculateLightSpaceFrustumCorner(far_top, right_vector, far_width);
@@ -235,10 +235,10 @@ public:
 	*            - the distance of the corner from the start point.
 	* @return - The relevant corner vertex of the view frustum in light space.
 	*/
-	glm::vec4 calculateLightSpaceFrustumCorner(const Vector3& start_point, const Vector3& direction,
+	glm::vec4 calculateLightSpaceFrustumCorner(const Vec3f& start_point, const Vec3f& direction,
 		const float width) const
 	{
-		const Vector3 point = start_point + Vector3(direction.x * width, direction.y * width, direction.z * width);
+		const Vec3f point = start_point + Vec3f(direction.x * width, direction.y * width, direction.z * width);
 		glm::vec4 point4f = glm::vec4(point.x, point.y, point.z, 1.0f);
 		point4f = *light_view_matrix * point4f;
 		return point4f;
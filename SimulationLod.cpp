@@ -0,0 +1,122 @@
+#include "SimulationLod.h"
+#include <algorithm>
+#include <cassert>
+
+void SimulationLod::setBandDistances(float band_1, float band_2, float band_3)
+{
+	assert(band_1 < band_2 && band_2 < band_3);
+	band_distances[0] = band_1;
+	band_distances[1] = band_2;
+	band_distances[2] = band_3;
+}
+
+void SimulationLod::resize(unsigned count)
+{
+	bands.resize(count, 0);
+	visible.resize(count, 1);
+	accumulated_time.resize(count, 0.0);
+}
+
+unsigned SimulationLod::size() const
+{
+	return bands.size();
+}
+
+void SimulationLod::swapRemove(unsigned i)
+{
+	assert(i < bands.size());
+	bands[i] = bands.back();
+	visible[i] = visible.back();
+	accumulated_time[i] = accumulated_time.back();
+	bands.pop_back();
+	visible.pop_back();
+	accumulated_time.pop_back();
+}
+
+void SimulationLod::beginTick(const LodView& view)
+{
+	this->view = view;
+	tick++;
+
+	for (unsigned b = 0; b < BAND_COUNT - 1; b++)
+	{
+		const float out_distance = band_distances[b] + HYSTERESIS;
+		const float in_distance = std::max(0.0f, band_distances[b] - HYSTERESIS);
+		band_out_squared[b] = out_distance * out_distance;
+		band_in_squared[b] = in_distance * in_distance;
+	}
+}
+
+bool SimulationLod::schedule(unsigned i, const Vec3f& position, double delta_time)
+{
+	assert(i < bands.size());
+
+	const float distance_squared = position.getDistanceSquared(view.focus);
+	bands[i] = (unsigned char)(chooseBand(bands[i], distance_squared));
+
+	accumulated_time[i] += delta_time;
+
+	//Offset by the index so a band's entities are spread over its ticks
+	const unsigned period = 1u << bands[i];
+	if ((tick + i) % period != 0)
+		return false;
+
+	const Vec3f to_entity = position - view.camera_position;
+	const float camera_distance = to_entity.getNorm();
+	visible[i] = camera_distance <= NEAR_CAMERA_DISTANCE ||
+		to_entity.dotProduct(view.camera_forward) >= VIEW_CONE_COS * camera_distance;
+	return true;
+}
+
+double SimulationLod::takeAccumulatedTime(unsigned i)
+{
+	assert(i < accumulated_time.size());
+	const double time = accumulated_time[i];
+	accumulated_time[i] = 0.0;
+	return time;
+}
+
+double SimulationLod::getAccumulatedTime(unsigned i) const
+{
+	assert(i < accumulated_time.size());
+	return accumulated_time[i];
+}
+
+bool SimulationLod::isVisible(unsigned i) const
+{
+	assert(i < visible.size());
+	return visible[i] != 0;
+}
+
+unsigned SimulationLod::getBand(unsigned i) const
+{
+	assert(i < bands.size());
+	return bands[i];
+}
+
+void SimulationLod::countBands()
+{
+	for (unsigned b = 0; b < BAND_COUNT; b++)
+		band_counts[b] = 0;
+	for (unsigned char band : bands)
+		band_counts[band]++;
+}
+
+unsigned SimulationLod::getBandCount(unsigned band) const
+{
+	assert(band < BAND_COUNT);
+	return band_counts[band];
+}
+
+unsigned SimulationLod::chooseBand(unsigned current_band, float distance_squared) const
+{
+	//Move out a band once past its distance plus the hysteresis
+	while (current_band < BAND_COUNT - 1 && distance_squared > band_out_squared[current_band])
+		current_band++;
+
+	//Move in a band once inside its start distance minus the hysteresis
+	while (current_band > 0 && distance_squared < band_in_squared[current_band - 1])
+		current_band--;
+
+	return current_band;
+}
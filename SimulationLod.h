@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include "Vec3f.h"
+
+//Where the simulation level of detail is measured from for one update
+struct LodView
+{
+	//Distance bands are measured from here, usually the player
+	Vec3f focus;
+
+	//Entities outside the camera's view can skip work that only changes how they look
+	Vec3f camera_position;
+	Vec3f camera_forward;
+};
+
+//Schedules entities far from the focus to update less often
+//Each entity is put in a band by its distance to the focus. Band 0 updates every tick,
+//band 1 every 2nd tick, band 2 every 4th tick and band 3 every 8th tick.
+//The time of skipped ticks is accumulated and given to the entity when it next updates.
+//Entities in a band are spread over the ticks by index so each tick costs about the same.
+//An entity only changes band once it is HYSTERESIS past a band distance so entities
+//moving along a band edge do not switch back and forth every tick
+class SimulationLod
+{
+public:
+	static const unsigned BAND_COUNT = 4;
+
+	//How far past a band distance an entity must be to change band
+	const float HYSTERESIS = 4.0f;
+
+	//Entities within this distance of the camera count as on screen whatever their direction
+	const float NEAR_CAMERA_DISTANCE = 10.0f;
+
+	//The cosine of the angle from the camera forward that counts as on screen
+	//Wider than the field of view so entities at the edge of the screen are not skipped
+	const float VIEW_CONE_COS = 0.3f;
+
+private:
+	//The distance from the focus where bands 1, 2 and 3 start
+	float band_distances[BAND_COUNT - 1] = { 40.0f, 80.0f, 160.0f };
+
+	//Squared distances to move out of and back into each band, with the hysteresis applied
+	float band_out_squared[BAND_COUNT - 1] = {};
+	float band_in_squared[BAND_COUNT - 1] = {};
+
+	std::vector<unsigned char> bands;
+	std::vector<unsigned char> visible;
+	std::vector<double> accumulated_time;
+
+	LodView view;
+	unsigned tick{};
+
+	unsigned band_counts[BAND_COUNT] = {};
+
+public:
+	SimulationLod() = default;
+
+	//Sets the distance from the focus where bands 1, 2 and 3 start
+	//Distances must be increasing
+	void setBandDistances(float band_1, float band_2, float band_3);
+
+	//Sets the number of entities scheduled
+	//New entities start in band 0 so they update on their first tick
+	void resize(unsigned count);
+
+	unsigned size() const;
+
+	//Removes entity i by moving the last entity into its place
+	//Matches removing entities from a dense array with swap and pop
+	void swapRemove(unsigned i);
+
+	//Starts a new tick measured from a view
+	void beginTick(const LodView& view);
+
+	//Updates the band of entity i at a position and adds the tick's time
+	//Returns true if the entity updates this tick, its on screen state is only updated then
+	//Only touches entity i so entities can be scheduled on several threads
+	bool schedule(unsigned i, const Vec3f& position, double delta_time);
+
+	//Returns the time accumulated for entity i since it last updated and resets it
+	double takeAccumulatedTime(unsigned i);
+
+	//Returns the time accumulated for entity i since it last updated
+	double getAccumulatedTime(unsigned i) const;
+
+	//Returns if entity i was in the camera's view when last scheduled
+	bool isVisible(unsigned i) const;
+
+	unsigned getBand(unsigned i) const;
+
+	//Counts the entities in each band for getBandCount
+	void countBands();
+
+	//Returns the number of entities in a band when countBands was last called
+	unsigned getBandCount(unsigned band) const;
+
+private:
+	unsigned chooseBand(unsigned current_band, float distance_squared) const;
+};
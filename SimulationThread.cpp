@@ -0,0 +1,121 @@
+#include "SimulationThread.h"
+#include <algorithm>
+#include <iostream>
+#include "Game.h"
+#include "InputLog.h"
+#include "Sleep.h"
+#include "Globals.h"
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start(Game& game, InputRecorder& recorder, InputPlayer& player)
+{
+	if (running.load()) return;
+
+	this->game = &game;
+	this->recorder = &recorder;
+	this->player = &player;
+	copied_time_scale_id = g_window_time_scale_id;
+
+	//The display always has a snapshot of the current game to draw
+	publishSnapshot();
+
+	running.store(true);
+	thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	if (!running.load()) return;
+	running.store(false);
+	thread.join();
+}
+
+bool SimulationThread::isRunning() const
+{
+	return running.load();
+}
+
+std::unique_lock<std::mutex> SimulationThread::lockInput()
+{
+	return std::unique_lock<std::mutex>(input_mutex);
+}
+
+const RenderSnapshot& SimulationThread::getSnapshot()
+{
+	return snapshots.getReadSnapshot();
+}
+
+void SimulationThread::run()
+{
+	PerformanceCounter counter;
+	counter.start();
+
+	while (running.load())
+	{
+		//Multiply delta time by time_scale to slow or speed up game
+		g_update_lag += counter.getAndReset() * g_time_scale;
+
+		//Process all updates
+		bool updated = false;
+		while (g_update_lag > FRAME_TIME_UPDATE)
+		{
+			copyWindowInput();
+
+			//A replay sets the input of each update, otherwise the input can be recorded
+			if (player->isOpen())
+			{
+				if (!player->replayTick())
+					std::cout << "Replay finished after " << player->getTickCount() << " ticks" << std::endl;
+			} else
+				recorder->recordTick();
+
+			game->update(FRAME_TIME_UPDATE);
+			game->updateAnimations(FRAME_TIME_UPDATE);
+			g_update_lag -= FRAME_TIME_UPDATE;
+			g_update_count++;
+			updated = true;
+		}
+
+		if (updated)
+			publishSnapshot();
+
+		//Real time until the next update is due
+		const double wait_time = (FRAME_TIME_UPDATE - g_update_lag) / g_time_scale;
+		if (wait_time > 0.0)
+			sleepms(wait_time);
+	}
+}
+
+void SimulationThread::copyWindowInput()
+{
+	const std::lock_guard<std::mutex> lock(input_mutex);
+	std::copy(g_window_key_pressed, g_window_key_pressed + KEY_COUNT, g_key_pressed);
+
+	//Mouse movement is used up by the update it is copied to
+	g_mouse_dx = g_window_mouse_dx;
+	g_mouse_dy = g_window_mouse_dy;
+	g_window_mouse_dx = 0;
+	g_window_mouse_dy = 0;
+
+	if (g_window_time_scale_id != copied_time_scale_id)
+	{
+		copied_time_scale_id = g_window_time_scale_id;
+		g_time_scale_id = g_window_time_scale_id;
+		g_time_scale = TIME_SCALES[g_time_scale_id];
+	}
+}
+
+void SimulationThread::publishSnapshot()
+{
+	RenderSnapshot& snapshot = snapshots.getWriteSnapshot();
+	game->fillSnapshot(snapshot);
+	snapshot.update_count = g_update_count;
+	snapshot.update_lag = g_update_lag;
+	snapshot.time_scale = g_time_scale;
+	snapshot.since_taken.start();
+	snapshots.publish();
+}
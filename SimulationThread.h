@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "RenderSnapshot.h"
+#include "SnapshotBuffer.h"
+
+class Game;
+class InputRecorder;
+class InputPlayer;
+
+//Runs Game::update at FRAME_TIME_UPDATE on its own thread so updating and drawing overlap
+//After each round of updates a RenderSnapshot is published through a SnapshotBuffer for
+//the display thread to draw. The window's input is shared through the input mutex, which the
+//thread only holds to copy the input at the start of each update. The update runs without it.
+class SimulationThread
+{
+private:
+	std::thread thread;
+	std::atomic<bool> running{ false };
+	std::mutex input_mutex;
+
+	//The window's time scale when the input was last copied
+	//The update's time scale only follows the window's when it changes, so one set by a replay is kept
+	int copied_time_scale_id{};
+
+	Game* game{};
+	InputRecorder* recorder{};
+	InputPlayer* player{};
+
+	SnapshotBuffer<RenderSnapshot> snapshots;
+
+public:
+	SimulationThread() = default;
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread& other) = delete;
+	SimulationThread& operator=(const SimulationThread& other) = delete;
+
+	//Publishes a snapshot of the game and starts updating it
+	//Each update records its input to the recorder, or takes it from the player while it has ticks left
+	void start(Game& game, InputRecorder& recorder, InputPlayer& player);
+
+	//Waits for the current update to finish and stops the thread
+	//The game may be changed on the calling thread until start is called again
+	void stop();
+
+	bool isRunning() const;
+
+	//Locks the window's input so it can be changed without an update copying it halfway
+	//Must not be held while calling stop
+	std::unique_lock<std::mutex> lockInput();
+
+	//Returns the newest snapshot, only the display thread may call this
+	const RenderSnapshot& getSnapshot();
+
+private:
+	//The loop run on the thread
+	void run();
+
+	void publishSnapshot();
+
+	//Copies the window's keys, mouse movement and time scale into the input the update reads
+	//Holds the input mutex only for the copy
+	void copyWindowInput();
+};
@@ -60,8 +60,8 @@
 		if(milliseconds > 0.0)
 		{
 			timespec spec;
-			spec.tv_sec  = (int)(seconds);
-			spec.tv_nsec = (int)((seconds - spec.tv_sec) * 1000000);
+			spec.tv_sec  = (int)(milliseconds / 1000.0);
+			spec.tv_nsec = (int)((milliseconds - spec.tv_sec * 1000.0) * 1000000);
 			// beware rounding erros
 			if(spec.tv_nsec < 0)
 				spec.tv_nsec = 0;
@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+
+//Hands snapshots from one thread that writes them to one thread that reads them without locks
+//The writer fills its snapshot and publishes it, the reader takes the newest published snapshot.
+//A third snapshot sits between them so neither thread ever waits for the other: publishing
+//swaps the written snapshot with the one in the middle and reading swaps the read snapshot
+//with the middle one only if something new was published.
+template <typename Snapshot>
+class SnapshotBuffer
+{
+private:
+	//Set in the middle index when it holds a snapshot the reader has not taken
+	static const unsigned NEW_BIT = 4;
+
+	Snapshot snapshots[3];
+
+	//Only used by the writer
+	unsigned write_index = 0;
+	//The snapshot between the threads, swapped by both
+	std::atomic<unsigned> middle_index{ 1 };
+	//Only used by the reader
+	unsigned read_index = 2;
+
+public:
+	SnapshotBuffer() = default;
+
+	SnapshotBuffer(const SnapshotBuffer& other) = delete;
+	SnapshotBuffer& operator=(const SnapshotBuffer& other) = delete;
+
+	//Returns the snapshot to fill, only the writing thread may call this
+	//It holds whatever was published two snapshots ago, so it must be filled completely
+	Snapshot& getWriteSnapshot()
+	{
+		return snapshots[write_index];
+	}
+
+	//Makes the written snapshot the newest one, only the writing thread may call this
+	void publish()
+	{
+		write_index = middle_index.exchange(write_index | NEW_BIT, std::memory_order_acq_rel) & ~NEW_BIT;
+	}
+
+	//Returns the newest published snapshot, only the reading thread may call this
+	//The snapshot stays valid and unchanged until the next call
+	const Snapshot& getReadSnapshot()
+	{
+		if (middle_index.load(std::memory_order_relaxed) & NEW_BIT)
+			read_index = middle_index.exchange(read_index, std::memory_order_acq_rel) & ~NEW_BIT;
+		return snapshots[read_index];
+	}
+};
@@ -0,0 +1,112 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+void SpatialGrid::init(float cell_size)
+{
+	assert(cell_size > 0);
+	clear();
+	this->cell_size = cell_size;
+}
+
+void SpatialGrid::clear()
+{
+	cells.clear();
+	id_bounds.clear();
+	id_inserted.clear();
+	count = 0;
+}
+
+void SpatialGrid::insert(unsigned id, float x, float z, float r)
+{
+	if (id >= id_inserted.size())
+	{
+		id_bounds.resize(id + 1);
+		id_inserted.resize(id + 1, false);
+	}
+	assert(!id_inserted[id]);
+
+	const CellBounds bounds = calculateCellBounds(x, z, r);
+	for (int cx = bounds.min_x; cx <= bounds.max_x; cx++)
+		for (int cz = bounds.min_z; cz <= bounds.max_z; cz++)
+			cells[getKey(cx, cz)].push_back(id);
+
+	id_bounds[id] = bounds;
+	id_inserted[id] = true;
+	count++;
+}
+
+void SpatialGrid::remove(unsigned id)
+{
+	if (!contains(id)) return;
+
+	const CellBounds& bounds = id_bounds[id];
+	for (int cx = bounds.min_x; cx <= bounds.max_x; cx++)
+	{
+		for (int cz = bounds.min_z; cz <= bounds.max_z; cz++)
+		{
+			const auto cell = cells.find(getKey(cx, cz));
+			if (cell == cells.end()) continue;
+
+			std::vector<unsigned>& ids = cell->second;
+			ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+			if (ids.empty()) cells.erase(cell);
+		}
+	}
+	id_inserted[id] = false;
+	count--;
+}
+
+void SpatialGrid::move(unsigned id, float x, float z, float r)
+{
+	if (contains(id) && id_bounds[id] == calculateCellBounds(x, z, r))
+		return;
+
+	remove(id);
+	insert(id, x, z, r);
+}
+
+bool SpatialGrid::contains(unsigned id) const
+{
+	return id < id_inserted.size() && id_inserted[id];
+}
+
+unsigned SpatialGrid::size() const
+{
+	return count;
+}
+
+void SpatialGrid::query(float x, float z, float r, std::vector<unsigned>& result) const
+{
+	const size_t first = result.size();
+	const CellBounds bounds = calculateCellBounds(x, z, r);
+	for (int cx = bounds.min_x; cx <= bounds.max_x; cx++)
+	{
+		for (int cz = bounds.min_z; cz <= bounds.max_z; cz++)
+		{
+			const auto cell = cells.find(getKey(cx, cz));
+			if (cell == cells.end()) continue;
+			result.insert(result.end(), cell->second.begin(), cell->second.end());
+		}
+	}
+
+	//A circle covering several cells is found once per cell
+	std::sort(result.begin() + first, result.end());
+	result.erase(std::unique(result.begin() + first, result.end()), result.end());
+}
+
+SpatialGrid::CellBounds SpatialGrid::calculateCellBounds(float x, float z, float r) const
+{
+	CellBounds bounds;
+	bounds.min_x = int(std::floor((x - r) / cell_size));
+	bounds.min_z = int(std::floor((z - r) / cell_size));
+	bounds.max_x = int(std::floor((x + r) / cell_size));
+	bounds.max_z = int(std::floor((z + r) / cell_size));
+	return bounds;
+}
+
+long long SpatialGrid::getKey(int cell_x, int cell_z)
+{
+	return (long long)(cell_x) << 32 | (unsigned)(cell_z);
+}
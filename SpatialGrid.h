@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+
+//A uniform grid over the XZ plane that buckets circles by the cells they cover.
+//Used to find the circles near a position without testing against every one of them.
+//Moving circles are kept up to date with move, which only changes cells when the
+//circle crosses into a new one.
+//Ids are expected to be small dense indices (disk ids, entity indices)
+class SpatialGrid
+{
+private:
+	//The range of cells a circle covers
+	struct CellBounds
+	{
+		int min_x{}, min_z{};
+		int max_x{}, max_z{};
+
+		bool operator==(const CellBounds& other) const
+		{
+			return min_x == other.min_x && min_z == other.min_z &&
+				max_x == other.max_x && max_z == other.max_z;
+		}
+	};
+
+	float cell_size = 16.0f;
+
+	//The ids in each occupied cell
+	std::unordered_map<long long, std::vector<unsigned>> cells;
+
+	//The cells covered by each id and if the id is in the grid
+	std::vector<CellBounds> id_bounds;
+	std::vector<bool> id_inserted;
+
+	unsigned count{};
+
+public:
+	SpatialGrid() = default;
+
+	//Clears the grid and sets the width of each cell
+	void init(float cell_size);
+
+	//Removes every id from the grid
+	void clear();
+
+	//Adds a circle at x,z with radius r to the grid
+	void insert(unsigned id, float x, float z, float r);
+
+	//Removes an id from every cell it covers
+	void remove(unsigned id);
+
+	//Moves a circle to x,z, inserting it if it is not in the grid
+	//Cells are only changed if the circle now covers different cells
+	void move(unsigned id, float x, float z, float r);
+
+	//Returns if the id has been inserted and not removed
+	bool contains(unsigned id) const;
+
+	//Returns the number of ids in the grid
+	unsigned size() const;
+
+	//Adds the ids sharing a cell with the circle at x,z with radius r to result
+	//Each id is added once. Results are candidates and still need an exact intersection test
+	void query(float x, float z, float r, std::vector<unsigned>& result) const;
+
+private:
+	CellBounds calculateCellBounds(float x, float z, float r) const;
+	static long long getKey(int cell_x, int cell_z);
+};
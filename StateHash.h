@@ -0,0 +1,54 @@
+#pragma once
+#include <cstring>
+#include "Vec3f.h"
+
+//Hashes the state of the simulation with 64 bit FNV-1a
+//Two runs with the same world, seed and inputs must give the same hash,
+//so a changed hash shows an optimization changed the simulation's results
+class StateHash
+{
+private:
+	static constexpr unsigned long long FNV_OFFSET = 14695981039346656037ull;
+	static constexpr unsigned long long FNV_PRIME = 1099511628211ull;
+
+	unsigned long long hash = FNV_OFFSET;
+
+public:
+	StateHash() = default;
+
+	void add(const void* data, unsigned size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (unsigned i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= FNV_PRIME;
+		}
+	}
+
+	void add(unsigned value)
+	{
+		add(&value, sizeof(value));
+	}
+
+	//Floats are hashed by their bits so any change in rounding changes the hash
+	void add(float value)
+	{
+		unsigned bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+		add(bits);
+	}
+
+	//The padding lane is left out
+	void add(const Vec3f& v)
+	{
+		add(v.x);
+		add(v.y);
+		add(v.z);
+	}
+
+	unsigned long long get() const
+	{
+		return hash;
+	}
+};
@@ -0,0 +1,90 @@
+#include "StreamBuffer.h"
+#include <cassert>
+#include <cstring>
+
+//How long to wait on a fence before checking it again, in nanoseconds
+static const GLuint64 FENCE_WAIT_TIME = 1000000;
+
+void StreamBuffer::init(unsigned element_size, unsigned region_element_count)
+{
+	assert(element_size > 0);
+	this->element_size = element_size;
+	glGenBuffers(1, &buffer);
+	resize(GLsizeiptr(region_element_count) * element_size);
+}
+
+void StreamBuffer::destroy()
+{
+	for (GLsync& fence : region_fences)
+	{
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	if (buffer) glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+GLuint StreamBuffer::getBuffer() const
+{
+	return buffer;
+}
+
+unsigned StreamBuffer::write(const void* data, unsigned count)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	const GLsizeiptr size = GLsizeiptr(count) * element_size;
+	if (size == 0) return 0;
+	if (size > region_size)
+		resize(size);
+	if (write_offset + size > GLsizeiptr(region + 1) * region_size)
+		nextRegion();
+
+	//Nothing the GPU may still read is in the range, so the map does not need to wait for it
+	void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, write_offset, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (mapped)
+	{
+		memcpy(mapped, data, size);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+
+	const unsigned first = unsigned(write_offset / element_size);
+	write_offset += size;
+	return first;
+}
+
+void StreamBuffer::nextRegion()
+{
+	//Every draw reading the region has been sent by now
+	region_fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	region = (region + 1) % REGION_COUNT;
+	write_offset = GLsizeiptr(region) * region_size;
+
+	GLsync& fence = region_fences[region];
+	if (fence)
+	{
+		while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_WAIT_TIME) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+void StreamBuffer::resize(GLsizeiptr region_size)
+{
+	//Whole elements fit in each region so every region starts on an element
+	this->region_size = (region_size + element_size - 1) / element_size * element_size;
+
+	//The old storage is orphaned, draws still reading it keep it until they are done
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, this->region_size * REGION_COUNT, nullptr, GL_STREAM_DRAW);
+
+	for (GLsync& fence : region_fences)
+	{
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	region = 0;
+	write_offset = 0;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "lib/GetGlutWithShaders.h"
+
+//A vertex buffer that new data is written into every frame without stalling on the GPU
+//The buffer is split into REGION_COUNT regions that are filled in turn. Data is written
+//through an unsynchronized map after the end of the last write, and when a region is full
+//a fence is placed after the draws that read it. The region is only written again once
+//its fence has passed, so the GPU is never reading data that is being overwritten.
+//Data is placed at whole elements so draws can start at the returned element index
+class StreamBuffer
+{
+	static const unsigned REGION_COUNT = 3;
+
+	GLuint buffer{};
+	GLsizeiptr element_size{};
+	GLsizeiptr region_size{};
+
+	//The region being written and the offset of the next write in the buffer
+	unsigned region{};
+	GLsizeiptr write_offset{};
+
+	//Set when a region is left, deleted once it has passed
+	GLsync region_fences[REGION_COUNT]{};
+
+public:
+	StreamBuffer() = default;
+	~StreamBuffer() = default;
+
+	StreamBuffer(const StreamBuffer& other) = delete;
+	StreamBuffer& operator=(const StreamBuffer& other) = delete;
+
+	//Creates the buffer with room for region_element_count elements in each region
+	void init(unsigned element_size, unsigned region_element_count);
+
+	void destroy();
+
+	//Returns the buffer to point vertex attributes at
+	GLuint getBuffer() const;
+
+	//Copies count elements into the buffer and returns the index of the first one
+	//Grows the regions if the data does not fit in one
+	//Leaves the buffer bound to GL_ARRAY_BUFFER
+	unsigned write(const void* data, unsigned count);
+
+private:
+	//Fences the current region and waits until the GPU is done with the next one
+	void nextRegion();
+
+	//Replaces the buffer's storage with regions of at least region_size bytes
+	void resize(GLsizeiptr region_size);
+};
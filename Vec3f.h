@@ -0,0 +1,314 @@
+#pragma once
+#include <cmath>
+#include <emmintrin.h>
+#include "lib/glm/glm.hpp"
+#include "lib/ObjLibrary/Vector3.h"
+
+//A 3D vector of floats whose operations use SSE
+//The 4th lane is padding and is kept at 0 so it never changes norms or dot products.
+//The lanes are stored as plain floats and loaded unaligned, so a Vec3f can live in
+//any heap allocation (32 bit builds only align new to 8 bytes).
+//Game objects use this for positions and directions instead of ObjLibrary::Vector3,
+//which stores doubles. Data loaded from assets (disks, graph nodes) stays in
+//ObjLibrary::Vector3 and is converted once where it enters the game objects.
+//Converts implicitly to glm::vec3 for drawing
+class Vec3f
+{
+public:
+	float x, y, z, w;
+
+	Vec3f()
+		: x(0.0f), y(0.0f), z(0.0f), w(0.0f)
+	{}
+
+	Vec3f(float x, float y, float z)
+		: x(x), y(y), z(z), w(0.0f)
+	{}
+
+	explicit Vec3f(__m128 m)
+	{
+		store(m);
+	}
+
+	explicit Vec3f(const ObjLibrary::Vector3& v)
+		: x(float(v.x)), y(float(v.y)), z(float(v.z)), w(0.0f)
+	{}
+
+	explicit Vec3f(const glm::vec3& v)
+		: x(v.x), y(v.y), z(v.z), w(0.0f)
+	{}
+
+	//Loads the 4 lanes into a register
+	__m128 load() const
+	{
+		return _mm_loadu_ps(&x);
+	}
+
+	void store(__m128 m)
+	{
+		_mm_storeu_ps(&x, m);
+	}
+
+	operator glm::vec3() const
+	{
+		return glm::vec3(x, y, z);
+	}
+
+	ObjLibrary::Vector3 toVector3() const
+	{
+		return ObjLibrary::Vector3(x, y, z);
+	}
+
+	bool operator==(const Vec3f& other) const
+	{
+		return (_mm_movemask_ps(_mm_cmpeq_ps(load(), other.load())) & 0x7) == 0x7;
+	}
+
+	bool operator!=(const Vec3f& other) const
+	{
+		return !(*this == other);
+	}
+
+	Vec3f operator-() const
+	{
+		return Vec3f(_mm_sub_ps(_mm_setzero_ps(), load()));
+	}
+
+	Vec3f operator+(const Vec3f& right) const
+	{
+		return Vec3f(_mm_add_ps(load(), right.load()));
+	}
+
+	Vec3f operator-(const Vec3f& right) const
+	{
+		return Vec3f(_mm_sub_ps(load(), right.load()));
+	}
+
+	Vec3f operator*(float factor) const
+	{
+		return Vec3f(_mm_mul_ps(load(), _mm_set1_ps(factor)));
+	}
+
+	Vec3f operator/(float divisor) const
+	{
+		return Vec3f(_mm_mul_ps(load(), _mm_set1_ps(1.0f / divisor)));
+	}
+
+	Vec3f& operator+=(const Vec3f& right)
+	{
+		store(_mm_add_ps(load(), right.load()));
+		return *this;
+	}
+
+	Vec3f& operator-=(const Vec3f& right)
+	{
+		store(_mm_sub_ps(load(), right.load()));
+		return *this;
+	}
+
+	Vec3f& operator*=(float factor)
+	{
+		store(_mm_mul_ps(load(), _mm_set1_ps(factor)));
+		return *this;
+	}
+
+	Vec3f& operator/=(float divisor)
+	{
+		store(_mm_mul_ps(load(), _mm_set1_ps(1.0f / divisor)));
+		return *this;
+	}
+
+	float dotProduct(const Vec3f& other) const
+	{
+		const __m128 product = _mm_mul_ps(load(), other.load());
+		const __m128 sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+		return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+	}
+
+	Vec3f crossProduct(const Vec3f& other) const
+	{
+		//(y, z, x) * (other z, x, y) - (z, x, y) * (other y, z, x)
+		const __m128 a_yzx = _mm_shuffle_ps(load(), load(), _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 b_yzx = _mm_shuffle_ps(other.load(), other.load(), _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 c = _mm_sub_ps(_mm_mul_ps(load(), b_yzx), _mm_mul_ps(a_yzx, other.load()));
+		return Vec3f(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+	}
+
+	float getNormSquared() const
+	{
+		return dotProduct(*this);
+	}
+
+	float getNorm() const
+	{
+		return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(getNormSquared())));
+	}
+
+	float getDistanceSquared(const Vec3f& other) const
+	{
+		return (*this - other).getNormSquared();
+	}
+
+	float getDistance(const Vec3f& other) const
+	{
+		return (*this - other).getNorm();
+	}
+
+	//Returns if every component is within a small tolerance of 0
+	bool isZero() const
+	{
+		const __m128 abs = _mm_andnot_ps(_mm_set1_ps(-0.0f), load());
+		return _mm_movemask_ps(_mm_cmpgt_ps(abs, _mm_set1_ps(ZERO_TOLERANCE))) == 0;
+	}
+
+	//The vector must not be zero
+	Vec3f getNormalized() const
+	{
+		return *this / getNorm();
+	}
+
+	//Returns a zero vector unchanged
+	Vec3f getNormalizedSafe() const
+	{
+		return isZero() ? *this : getNormalized();
+	}
+
+	void normalize()
+	{
+		*this = getNormalized();
+	}
+
+	void normalizeSafe()
+	{
+		*this = getNormalizedSafe();
+	}
+
+	//Returns the angle between two vectors in radians, or 1 if either is zero
+	float getAngleSafe(const Vec3f& other) const
+	{
+		if (isZero() || other.isZero())
+			return 1.0f;
+		return acosClamped(dotProduct(other) / (getNorm() * other.getNorm()));
+	}
+
+	//Returns the angle between two unit vectors in radians
+	float getAngleNormal(const Vec3f& other) const
+	{
+		return acosClamped(dotProduct(other));
+	}
+
+	//Rotates around the Y axis the same way as ObjLibrary::Vector3
+	Vec3f getRotatedY(float radians) const
+	{
+		const float sin_angle = std::sin(radians);
+		const float cos_angle = std::cos(radians);
+		return Vec3f(sin_angle * z + cos_angle * x, y, cos_angle * z - sin_angle * x);
+	}
+
+	void rotateY(float radians)
+	{
+		*this = getRotatedY(radians);
+	}
+
+	//Rotates around an axis through the origin, the axis does not have to be normalized
+	Vec3f getRotatedArbitrary(const Vec3f& axis, float radians) const
+	{
+		const Vec3f a = axis.getNormalized();
+		const float sin_angle = std::sin(radians);
+		const float cos_angle = std::cos(radians);
+		return a * (a.dotProduct(*this) * (1.0f - cos_angle)) + *this * cos_angle + a.crossProduct(*this) * sin_angle;
+	}
+
+	void rotateArbitrary(const Vec3f& axis, float radians)
+	{
+		*this = getRotatedArbitrary(axis, radians);
+	}
+
+private:
+	static constexpr float ZERO_TOLERANCE = 1.0e-6f;
+
+	//acos with the ratio clamped to [-1, 1] to hide rounding errors
+	static float acosClamped(float ratio)
+	{
+		if (ratio <= -1.0f) return 3.14159265f;
+		if (ratio >= 1.0f) return 0.0f;
+		return std::acos(ratio);
+	}
+};
+
+inline Vec3f operator*(float factor, const Vec3f& v)
+{
+	return v * factor;
+}
+
+//A 4D vector of floats whose operations use SSE
+//Converts implicitly to glm::vec4 for drawing
+class Vec4f
+{
+public:
+	float x, y, z, w;
+
+	Vec4f()
+		: x(0.0f), y(0.0f), z(0.0f), w(0.0f)
+	{}
+
+	Vec4f(float x, float y, float z, float w)
+		: x(x), y(y), z(z), w(w)
+	{}
+
+	Vec4f(const Vec3f& v, float w)
+		: x(v.x), y(v.y), z(v.z), w(w)
+	{}
+
+	explicit Vec4f(__m128 m)
+	{
+		store(m);
+	}
+
+	explicit Vec4f(const glm::vec4& v)
+		: x(v.x), y(v.y), z(v.z), w(v.w)
+	{}
+
+	__m128 load() const
+	{
+		return _mm_loadu_ps(&x);
+	}
+
+	void store(__m128 m)
+	{
+		_mm_storeu_ps(&x, m);
+	}
+
+	operator glm::vec4() const
+	{
+		return glm::vec4(x, y, z, w);
+	}
+
+	//Returns x, y and z with w dropped
+	Vec3f getXYZ() const
+	{
+		return Vec3f(_mm_shuffle_ps(load(), _mm_movehl_ps(_mm_setzero_ps(), load()), _MM_SHUFFLE(2, 0, 1, 0)));
+	}
+
+	Vec4f operator+(const Vec4f& right) const
+	{
+		return Vec4f(_mm_add_ps(load(), right.load()));
+	}
+
+	Vec4f operator-(const Vec4f& right) const
+	{
+		return Vec4f(_mm_sub_ps(load(), right.load()));
+	}
+
+	Vec4f operator*(float factor) const
+	{
+		return Vec4f(_mm_mul_ps(load(), _mm_set1_ps(factor)));
+	}
+
+	float dotProduct(const Vec4f& other) const
+	{
+		const __m128 product = _mm_mul_ps(load(), other.load());
+		const __m128 sum = _mm_add_ps(product, _mm_movehl_ps(product, product));
+		return _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1))));
+	}
+};
@@ -17,6 +17,7 @@
 
 extern LineRenderer g_line_renderer;
 extern DepthTexture g_depth_texture;
+extern bool g_headless;
 
 using namespace ObjLibrary;
 
@@ -29,7 +30,8 @@ void World::init(const std::string& filename)
 {
 	if (initialized) destroy();
 	initialized = true;
-	loadModels();
+	if (!g_headless)
+		loadModels();
 
 
 	std::ifstream input_file;
@@ -115,6 +117,13 @@ void World::init(const std::string& filename)
 	}
 	std::cout << "world creation time: " << p.getCounter() << "ms" << std::endl;
 
+	disk_grid.init(DISK_GRID_CELL_SIZE);
+	for (unsigned i = 0; i < disks.size(); i++)
+		disk_grid.insert(i, float(disks[i]->position.x), float(disks[i]->position.z), disks[i]->radius);
+
+	if (!g_headless)
+		initInstanceBuffer();
+
 	std::cout << "Loaded file " << filename << std::endl;
 }
 
@@ -131,6 +140,10 @@ void World::destroy()
 	disksSorted[2].clear();
 	disksSorted[3].clear();
 	disksSorted[4].clear();
+	disk_grid.clear();
+
+	if (disk_instance_buffer) glDeleteBuffers(1, &disk_instance_buffer);
+	disk_instance_buffer = 0;
 
 	initialized = false;
 
@@ -160,86 +173,53 @@ void World::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& pro
 }
 void World::drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos)
 {
-		
-	//For each disk draw all the black cylinder bases
-//Setup to draw the black disk cylinders for all disks
-	const MaterialForShader& base = disks[0]->model->getMaterial(1);
+	if (disks.empty()) return;
 
+	//Each disk's model matrix comes from the instance buffer, so the uniforms only hold the view
 	const ObjShader::ShaderUniforms& uniforms = ObjShader::activateShader();
-	base.activate(uniforms);
-
+	const glm::mat4 model_matrix = glm::mat4();
+	const glm::mat4 vp_matrix = projection_matrix * view_matrix;
+	glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
 	glUniformMatrix4fv(uniforms.m_view_matrix, 1, false, &(view_matrix[0][0]));
+	glUniformMatrix4fv(uniforms.m_model_view_projection_matrix, 1, false, &(vp_matrix[0][0]));
 	glUniform3fv(uniforms.m_camera_pos, 1, &(camera_pos.x));
 
-
-	const glm::mat4 vp_matrix = projection_matrix * view_matrix;
-
-	//Call draw on each black disk base
-	for (auto const& disk : disks)
+	//Draw the black cylinder bases of every disk type with the same material
+	//Activating a material turns instancing off, so it is turned on after each one
+	const MaterialForShader& base = disks[0]->model->getMaterial(1);
+	base.activate(uniforms);
+	glUniform1i(uniforms.m_instancing_enabled, 1);
+	for (int i = 0; i < 5; i++)
 	{
-
-		glm::mat4x4 model_matrix = glm::mat4();
-		model_matrix = glm::translate(model_matrix, glm::vec3(disk->position));
-		model_matrix = glm::scale(model_matrix, glm::vec3(disk->radius, 1, disk->radius));
-		const glm::mat4x4 mvp_matrix = vp_matrix * model_matrix;
-
-		glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
-		glUniformMatrix4fv(uniforms.m_model_view_projection_matrix, 1, false, &(mvp_matrix[0][0]));
-		disk->model->drawCurrentMaterial(1);
+		if (disksSorted[i].empty()) continue;
+		disksSorted[i][0]->model->drawCurrentMaterialInstanced(1, unsigned(disksSorted[i].size()), disk_instance_first[i]);
 	}
 
-	//For each disk draw the other stuff as groups
+	//For each disk type draw the other stuff as groups
 	for (int i = 0; i < 5; i++)
 	{
 		if (disksSorted[i].empty()) continue;
-		const MaterialForShader& side = disksSorted[i][0]->model->getMaterial(0);
-		const MaterialForShader& top = disksSorted[i][0]->model->getMaterial(2);
+		const ModelWithShader* model = disksSorted[i][0]->model;
+		const unsigned disk_count = unsigned(disksSorted[i].size());
 
-		side.activate(uniforms);
-		for (auto const& disk : disksSorted[i])
-		{
-			glm::mat4x4 model_matrix = glm::mat4();
-			model_matrix = glm::translate(model_matrix, glm::vec3(disk->position));
-			model_matrix = glm::scale(model_matrix, glm::vec3(disk->radius, 1, disk->radius));
-			const glm::mat4x4 mvp_matrix = vp_matrix * model_matrix;
+		model->getMaterial(0).activate(uniforms);
+		glUniform1i(uniforms.m_instancing_enabled, 1);
+		model->drawCurrentMaterialInstanced(0, disk_count, disk_instance_first[i]);
 
-			glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
-			glUniformMatrix4fv(uniforms.m_model_view_projection_matrix, 1, false, &(mvp_matrix[0][0]));
-			disk->model->drawCurrentMaterial(0);
-		}
+		model->getMaterial(2).activate(uniforms);
+		glUniform1i(uniforms.m_instancing_enabled, 1);
+		model->drawCurrentMaterialInstanced(2, disk_count, disk_instance_first[i]);
 
-		top.activate(uniforms);
-		for (auto const& disk : disksSorted[i])
+		//Every height map is its own mesh, so they are drawn one at a time with their matrix from the buffer
+		for (unsigned d = 0; d < disk_count; d++)
 		{
-			glm::mat4x4 model_matrix = glm::mat4();
-			model_matrix = glm::translate(model_matrix, glm::vec3(disk->position));
-			model_matrix = glm::scale(model_matrix, glm::vec3(disk->radius, 1, disk->radius));
-			glm::mat4x4 mvp_matrix = vp_matrix * model_matrix;
-
-			glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
-			glUniformMatrix4fv(uniforms.m_model_view_projection_matrix, 1, false, &(mvp_matrix[0][0]));
-			disk->model->drawCurrentMaterial(2);
-
+			const Disk* disk = disksSorted[i][d];
 			if (disk->heightMapModel.getMeshCountTotal() > 0)
-			{
-				model_matrix = glm::mat4();
-				glm::vec3 pos = disk->position;
-				const float corner = float(disk->radius * 0.70710678118);
-
-				//Fix for overlapping faces causing flicker
-				pos.y += 0.00001f;
-				model_matrix = glm::translate(model_matrix, pos);
-				model_matrix = glm::scale(model_matrix, glm::vec3(corner * 2 / disk->heightMapSize, 1, corner * 2 / disk->heightMapSize));
-				mvp_matrix = vp_matrix * model_matrix;
-
-				glUniformMatrix4fv(uniforms.m_model_matrix, 1, false, &(model_matrix[0][0]));
-				glUniformMatrix4fv(uniforms.m_model_view_projection_matrix, 1, false, &(mvp_matrix[0][0]));
-				disk->heightMapModel.drawCurrentMaterial();
-			}
+				disk->heightMapModel.drawCurrentMaterialInstanced(1, height_map_instance_first[i] + d);
 		}
-
 	}
 
+	glUniform1i(uniforms.m_instancing_enabled, 0);
 }
 
 void World::drawDepth(const glm::mat4& depth_view_projection_matrix)const
@@ -252,7 +232,7 @@ void World::drawDepth(const glm::mat4& depth_view_projection_matrix)const
 
 }
 
-void World::drawDepthOptimized(const Vector3& position, float radius, const glm::mat4& depth_view_projection_matrix) const
+void World::drawDepthOptimized(const Vec3f& position, float radius, const glm::mat4& depth_view_projection_matrix) const
 {
 	const ObjLibrary::MeshWithShader& m1 = IcyModel.getMesh(0, 0);
 	const ObjLibrary::MeshWithShader& m2 = IcyModel.getMesh(1, 0);
@@ -261,7 +241,7 @@ void World::drawDepthOptimized(const Vector3& position, float radius, const glm:
 	for (auto const& disk : disks)
 	{
 		//Skip disks outside shadow distance radius
-		if (position.getDistanceSquared(disk->position) > pow((radius + disk->radius),2)) continue;
+		if (position.getDistanceSquared(Vec3f(disk->position)) > pow((radius + disk->radius),2)) continue;
 		glm::mat4x4 model_matrix = glm::mat4();
 		glm::mat4x4 pos_matrix = glm::mat4();
 		const glm::vec3 pos = disk->position;
@@ -349,11 +329,11 @@ Vector3& World::getRandomDiskPosition() const
 	return disks[i]->position;
 }
 
-Vector3 World::getRandomXZPosition() const
+Vec3f World::getRandomXZPosition() const
 {
 	float r = sqrt(Random::randf(0, 1)) * worldRadius;
 	double t = Random::randd(0, MathHelper::M_2PI);
-	Vector3 pos(r*cos(t), 15.0f, r*sin(t));
+	Vec3f pos(r*float(cos(t)), 15.0f, r*float(sin(t)));
 	return pos;
 }
 
@@ -364,8 +344,10 @@ bool World::isInitialized() const
 
 float World::getHeightAtPointPosition(const float x, const float z) const
 {
-	for (auto &disk : disks)
+	//Candidates are in disk order so the first disk found is the same as a full scan
+	for (const unsigned disk_id : getDiskCandidates(x, z, 0))
 	{
+		const Disk* disk = disks[disk_id].get();
 		//If colliding with this disk return the height at the position on the disk
 		if (Collision::pointCircleIntersection(x, z, float(disk->position.x), float(disk->position.z), disk->radius))
 			return disk->getHeightAtPosition(x, z);
@@ -386,6 +368,16 @@ float World::getHeightAtCirclePosition(const float x, const float z, const float
 	return 0.0f;
 }
 
+void World::getDisksNear(float x, float z, float r, std::vector<unsigned>& disk_ids) const
+{
+	for (const unsigned disk_id : getDiskCandidates(x, z, r))
+	{
+		const Disk* disk = disks[disk_id].get();
+		if (Collision::circleIntersection(x, z, r, float(disk->position.x), float(disk->position.z), disk->radius))
+			disk_ids.push_back(disk_id);
+	}
+}
+
 bool World::isOnDisk(float x, float z) const
 {
 	return isOnDisk(x, z, 0);
@@ -401,23 +393,78 @@ bool World::isOnDisk(float x, float z, float r) const
 	return false;
 }
 
-bool World::isCylinderCollisionWithDisk(const Vector3& pos, float r, float half_height) const
+bool World::isCylinderCollisionWithDisk(const Vec3f& pos, float r, float half_height) const
 {
-	for (auto &disk : disks)
+	bool touching_disk = false;
+	for (const unsigned disk_id : getDiskCandidates(pos.x, pos.z, r))
 	{
-		//If colliding with this disk return the height at the position on the disk
-		if (Collision::circleIntersection(float(pos.x), float(pos.z), r, float(disk->position.x), float(disk->position.z), disk->radius))
+		const Disk* disk = disks[disk_id].get();
+		if (Collision::circleIntersection(pos.x, pos.z, r, float(disk->position.x), float(disk->position.z), disk->radius))
+		{
+			touching_disk = true;
+			break;
+		}
+	}
+	if (!touching_disk) return false;
+
+	//The height is at the center of the cylinder so it is the same for every disk touched
+	//If position is below height map it is inside
+	const float a = getHeightAtPointPosition(pos.x, pos.z);
+	return pos.y - half_height <= a;
+}
+
+void World::initInstanceBuffer()
+{
+	std::vector<glm::mat4> instance_matrices;
+	instance_matrices.reserve(disks.size() * 2);
+	for (int i = 0; i < 5; i++)
+	{
+		disk_instance_first[i] = unsigned(instance_matrices.size());
+		for (const Disk* disk : disksSorted[i])
 		{
-			float a = getHeightAtPointPosition(float(pos.x), float(pos.z));
-			//If position is below height map it is inside
-			if (pos.y - half_height <= a)
-			{
-				return true;
-			}
+			glm::mat4x4 model_matrix = glm::mat4();
+			model_matrix = glm::translate(model_matrix, glm::vec3(disk->position));
+			model_matrix = glm::scale(model_matrix, glm::vec3(disk->radius, 1, disk->radius));
+			instance_matrices.push_back(model_matrix);
 		}
 
+		height_map_instance_first[i] = unsigned(instance_matrices.size());
+		for (const Disk* disk : disksSorted[i])
+		{
+			glm::mat4x4 model_matrix = glm::mat4();
+			glm::vec3 pos = disk->position;
+			const float corner = float(disk->radius * 0.70710678118);
+
+			//Fix for overlapping faces causing flicker
+			pos.y += 0.00001f;
+			model_matrix = glm::translate(model_matrix, pos);
+			model_matrix = glm::scale(model_matrix, glm::vec3(corner * 2 / disk->heightMapSize, 1, corner * 2 / disk->heightMapSize));
+			instance_matrices.push_back(model_matrix);
+		}
 	}
-	return false;
+
+	glGenBuffers(1, &disk_instance_buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, disk_instance_buffer);
+	glBufferData(GL_ARRAY_BUFFER, instance_matrices.size() * sizeof(glm::mat4), instance_matrices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//Every disk of a type shares its type's model
+	ModelWithShader* const type_models[5] = { &RedRockModel, &LeafyModel, &IcyModel, &SandyModel, &GreyRockModel };
+	for (ModelWithShader* model : type_models)
+		model->setInstanceMatrixBuffer(disk_instance_buffer);
+	for (auto& disk : disks)
+	{
+		if (disk->heightMapModel.getMeshCountTotal() > 0)
+			disk->heightMapModel.setInstanceMatrixBuffer(disk_instance_buffer);
+	}
+}
+
+const std::vector<unsigned>& World::getDiskCandidates(float x, float z, float r) const
+{
+	thread_local std::vector<unsigned> candidates;
+	candidates.clear();
+	disk_grid.query(x, z, r, candidates);
+	return candidates;
 }
 
 
@@ -1,10 +1,13 @@
 #pragma once
 #include "lib/ObjLibrary/ModelWithShader.h"
+#include "lib/GetGlutWithShaders.h"
 #include "ostream"
 #include "Disk.h"
 #include <vector>
 #include "memory"
 #include "PickupManager.h"
+#include "SpatialGrid.h"
+#include "Vec3f.h"
 
 //The world class loads in all of the disks and is able to draw itself.
 class World
@@ -39,6 +42,17 @@ public:
 
 	std::vector<Disk*> disksSorted[5];
 
+	//The disks bucketed by position so point queries only test nearby disks
+	SpatialGrid disk_grid;
+	const float DISK_GRID_CELL_SIZE = 16.0f;
+
+	//The model matrices of the disks for instanced drawing, built once at load because disks do not move
+	//For each disk type the matrices of its disks in disksSorted order are followed by the
+	//matrices of the same disks' height maps
+	GLuint disk_instance_buffer{};
+	unsigned disk_instance_first[5]{};
+	unsigned height_map_instance_first[5]{};
+
 public:
 	World() = default;
 	~World();
@@ -55,10 +69,13 @@ public:
 	float getHeightAtPointPosition(float x, float z) const;
 	float getHeightAtCirclePosition(float x, float z, float r) const;
 
+	//Adds the ids of the disks that overlap the circle to disk_ids, in ascending order
+	void getDisksNear(float x, float z, float r, std::vector<unsigned>& disk_ids) const;
+
 	bool isOnDisk(float x, float z) const;
 	bool isOnDisk(float x, float z, float r) const;
 
-	bool isCylinderCollisionWithDisk(const Vector3& pos, float r, float half_height) const;
+	bool isCylinderCollisionWithDisk(const Vec3f& pos, float r, float half_height) const;
 
 	//Draw all of the disks
 	void draw(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix);
@@ -67,12 +84,13 @@ public:
 	//Draws all of the disks blacks bases first
 	//For each disk type it draws all the disks sides
 	//For each disk type it draws all the disks tops and height maps
+	//The bases, sides and tops of each disk type are each one instanced draw
 	void drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix);
 	void drawOptimized(const glm::mat4x4& view_matrix, const glm::mat4x4& projection_matrix, const glm::vec3& camera_pos);
 	//Draw all of the disks to the depthRTT Shader
 	//depthMatrixID is the uniform location for the DepthMVP matrix that will be calculated here
 	void drawDepth(const glm::mat4& depth_view_projection_matrix) const;
-	void drawDepthOptimized(const Vector3& position, float radius ,const glm::mat4& depth_view_projection_matrix) const;
+	void drawDepthOptimized(const Vec3f& position, float radius ,const glm::mat4& depth_view_projection_matrix) const;
 
 	//Gets the speed multiplier based on the disk type
 	//Sandy 0.75, Icy 0.25, Leafy 0.5, other 1.0
@@ -87,7 +105,15 @@ public:
 
 	//Returns the center position of a random disk
 	Vector3& getRandomDiskPosition() const;
-	Vector3 getRandomXZPosition() const;
+	Vec3f getRandomXZPosition() const;
 
 	bool isInitialized() const;
+
+private:
+	//Fills the instance buffer and points the disk and height map models at it
+	void initInstanceBuffer();
+
+	//Returns the ids of the disks that may overlap the circle, in ascending order
+	//The list is reused by the next query on the same thread
+	const std::vector<unsigned>& getDiskCandidates(float x, float z, float r) const;
 };
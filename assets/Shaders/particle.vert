@@ -1,8 +1,8 @@
 
 layout (location = 0) in vec3 a_vertex;
-layout (location = 1) in vec3 a_position;
-layout (location = 2) in float a_size;
-layout (location = 3) in vec4 a_color;
+// The position relative to particle_origin in xyz and the size in w
+layout (location = 1) in vec4 a_position_size;
+layout (location = 2) in vec4 a_color;
 
 out vec4 color;
 out vec3 vpos;
@@ -12,14 +12,15 @@ out vec2 UV;
 uniform vec3 camera_right_worldspace;
 uniform vec3 camera_up_worldspace;
 uniform mat4 view_projection_matrix;
+uniform vec3 particle_origin;
 // Model-View-Projection matrix, but without the Model (the position is in BillboardPos; the orientation depends on the camera)
 
 void main()
 {
     vec3 vertex_position_worldspace = 
-		a_position
-		+ camera_right_worldspace * a_vertex.x * a_size
-		+ camera_up_worldspace * a_vertex.y * a_size;
+		particle_origin + a_position_size.xyz
+		+ camera_right_worldspace * a_vertex.x * a_position_size.w
+		+ camera_up_worldspace * a_vertex.y * a_position_size.w;
 
     // Output position of the vertex
 	gl_Position =  view_projection_matrix * vec4(vertex_position_worldspace, 1.0f);
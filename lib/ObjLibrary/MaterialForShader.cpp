@@ -396,6 +396,7 @@ void MaterialForShader :: activate (const ObjShader::ShaderUniforms& uniforms) c
 
 	glUniform1i(uniforms.m_tween_enabled, 0);
 	glUniform1f(uniforms.m_tween_factor, 0);
+	glUniform1i(uniforms.m_instancing_enabled, 0);
 }
 
 
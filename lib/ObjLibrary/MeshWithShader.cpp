@@ -34,6 +34,7 @@
 #include "VertexDataFormat.h"
 #include "ObjVbo.h"
 #include "ObjVao.h"
+#include "ObjShader.h"
 #include "MeshWithShader.h"
 
 using namespace ObjLibrary;
@@ -140,6 +141,36 @@ void MeshWithShader :: draw () const
 }
 
 
+void MeshWithShader :: drawInstanced (unsigned int instance_count,
+                                      unsigned int first_instance) const
+{
+	assert(isInitialized());
+
+	m_vao.bind();
+
+	glDrawElementsInstancedBaseInstance(m_primitive_type, m_vertex_indexes.getElementCount(), GL_UNSIGNED_INT, 0,
+	                                    instance_count, first_instance);
+}
+
+void MeshWithShader :: setInstanceMatrixBuffer (unsigned int buffer)
+{
+	assert(isInitialized());
+
+	m_vao.bind();
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	// a mat4x4 attribute takes one slot per column
+	for(unsigned int i = 0; i < 4; i++)
+	{
+		const unsigned int attribute = ObjShader::INSTANCE_MATRIX_ATTRIBUTE + i;
+		glEnableVertexAttribArray(attribute);
+		glVertexAttribPointer(attribute, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4x4), (void*)(sizeof(glm::vec4) * i));
+		glVertexAttribDivisor(attribute, 1);
+	}
+
+	m_vao.bindNone();  // we don't want to accidentally change it elsewhere
+}
+
 void MeshWithShader :: init (unsigned int primitive_type,
                              unsigned int data_format,
                              const ObjVbo<float>& vertex_data,
@@ -190,6 +190,31 @@ public:
 
 	void draw () const;
 
+//
+//  drawInstanced
+//
+//  Purpose: To display many copies of this MeshWithShader
+//           with one draw call.
+//  Parameter(s):
+//    <1> instance_count: How many copies to display
+//    <2> first_instance: The index of the first model matrix
+//                        to use in the instance matrix buffer
+//  Precondition(s):
+//    <1> isInitialized()
+//    <2> An instance matrix buffer has been set with
+//        setInstanceMatrixBuffer
+//  Returns: N/A
+//  Side Effect: This MeshWithShader is displayed
+//               instance_count times using the current
+//               ObjLibrary shader and material information.
+//               Each copy uses the next model matrix in the
+//               instance matrix buffer, starting at
+//               first_instance.
+//
+
+	void drawInstanced (unsigned int instance_count,
+	                    unsigned int first_instance) const;
+
 
 //
 //  init
@@ -254,6 +279,27 @@ public:
 		unsigned int data_format,
 		const ObjVbo<float>& vertex_data);
 
+//
+//  setInstanceMatrixBuffer
+//
+//  Purpose: To set the buffer of model matrices used when
+//           this MeshWithShader is displayed instanced.
+//  Parameter(s):
+//    <1> buffer: The handle of a GL_ARRAY_BUFFER holding
+//                tightly packed glm::mat4x4 model matrices
+//  Precondition(s):
+//    <1> isInitialized()
+//  Returns: N/A
+//  Side Effect: Vertex attributes INSTANCE_MATRIX_ATTRIBUTE
+//               to INSTANCE_MATRIX_ATTRIBUTE + 3 of the VAO for
+//               this MeshWithShader read one matrix column
+//               each from buffer, advancing once per instance.
+//               The VAO is shared with every copy of this
+//               MeshWithShader.
+//
+
+	void setInstanceMatrixBuffer (unsigned int buffer);
+
 //
 //  makeEmpty
 //
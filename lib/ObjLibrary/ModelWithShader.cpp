@@ -189,6 +189,47 @@ void ModelWithShader::drawCurrentMaterial(unsigned int material) const
 
 
 
+void ModelWithShader :: drawCurrentMaterialInstanced (unsigned int instance_count,
+                                                      unsigned int first_instance) const
+{
+	assert(isReady());
+	assert(ObjShader::isLoaded());
+
+	for(unsigned int i = 0; i < mv_materials.size(); i++)
+		drawCurrentMaterialInstanced(i, instance_count, first_instance);
+
+	ObjVao::bindNone();  // we don't want to accidentally change our meshes elsewhere
+}
+
+void ModelWithShader :: drawCurrentMaterialInstanced (unsigned int material,
+                                                      unsigned int instance_count,
+                                                      unsigned int first_instance) const
+{
+	assert(isReady());
+	assert(ObjShader::isLoaded());
+	assert(material < getMaterialCount());
+
+	static const glm::vec2 ZERO2(0.0, 0.0);
+	static const glm::vec3 ZERO3(0.0, 0.0, 0.0);
+
+	const std::vector<MeshWithShader>& v_meshes = mv_materials[material].mv_meshes;
+	for(unsigned int j = 0; j < v_meshes.size(); j++)
+	{
+		// the same fallback values as drawCurrentMaterial
+		glVertexAttrib2fv(1, &(ZERO2.x));  // texture coordinates
+		glVertexAttrib3fv(2, &(ZERO3.x));  // normals
+		glVertexAttrib3fv(3, &(ZERO3.x));  // vertex1
+		glVertexAttrib3fv(4, &(ZERO3.x));  // normal2
+
+		assert(v_meshes[j].isInitialized());
+		v_meshes[j].drawInstanced(instance_count, first_instance);
+	}
+
+	ObjVao::bindNone();  // we don't want to accidentally change our meshes elsewhere
+}
+
+
+
 unsigned int ModelWithShader :: addMaterial (const MaterialForShader& material)
 {
 	mv_materials.push_back(material);
@@ -197,6 +238,18 @@ unsigned int ModelWithShader :: addMaterial (const MaterialForShader& material)
 	return mv_materials.size() - 1;
 }
 
+void ModelWithShader :: setInstanceMatrixBuffer (unsigned int buffer)
+{
+	assert(isReady());
+
+	for(unsigned int i = 0; i < mv_materials.size(); i++)
+	{
+		std::vector<MeshWithShader>& v_meshes = mv_materials[i].mv_meshes;
+		for(unsigned int j = 0; j < v_meshes.size(); j++)
+			v_meshes[j].setInstanceMatrixBuffer(buffer);
+	}
+}
+
 void ModelWithShader :: setMaterial (unsigned int index,
                                      const MaterialForShader& material)
 {
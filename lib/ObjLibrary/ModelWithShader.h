@@ -476,6 +476,61 @@ public:
 
 	void drawCurrentMaterial (unsigned int material) const;
 
+//
+//  drawCurrentMaterialInstanced
+//
+//  Purpose: To display many copies of the meshes in this
+//           ModelWithShader with the current shader program
+//           and material, using one draw call per mesh.
+//  Parameter(s):
+//    <1> instance_count: How many copies to display
+//    <2> first_instance: The index of the first model matrix
+//                        to use in the instance matrix buffer
+//  Precondition(s):
+//    <1> isReady()
+//    <2> ObjShader::isLoaded()
+//    <3> An instance matrix buffer has been set with
+//        setInstanceMatrixBuffer
+//  Returns: N/A
+//  Side Effect: The meshes in this ModelWithShader are
+//               displayed instance_count times using the
+//               current shaders and uniform values.  The
+//               instancing_enabled uniform must be set for
+//               the copies to use their own model matrices.
+//
+
+	void drawCurrentMaterialInstanced (
+	                        unsigned int instance_count,
+	                        unsigned int first_instance) const;
+
+//
+//  drawCurrentMaterialInstanced
+//
+//  Purpose: To display many copies of the meshes in this
+//           ModelWithShader associated with the specified
+//           material, using one draw call per mesh.
+//  Parameter(s):
+//    <1> material: The Material the meshes are associated with
+//    <2> instance_count: How many copies to display
+//    <3> first_instance: The index of the first model matrix
+//                        to use in the instance matrix buffer
+//  Precondition(s):
+//    <1> isReady()
+//    <2> ObjShader::isLoaded()
+//    <3> material < getMaterialCount()
+//    <4> An instance matrix buffer has been set with
+//        setInstanceMatrixBuffer
+//  Returns: N/A
+//  Side Effect: The meshes in this ModelWithShader are
+//               displayed instance_count times using the
+//               current shaders and uniform values.
+//
+
+	void drawCurrentMaterialInstanced (
+	                        unsigned int material,
+	                        unsigned int instance_count,
+	                        unsigned int first_instance) const;
+
 //
 //  addMaterial
 //
@@ -549,6 +604,26 @@ public:
 	void addMesh (unsigned int material,
 	              const MeshWithShader& mesh);
 
+//
+//  setInstanceMatrixBuffer
+//
+//  Purpose: To set the buffer of model matrices used when the
+//           meshes in this ModelWithShader are displayed
+//           instanced.
+//  Parameter(s):
+//    <1> buffer: The handle of a GL_ARRAY_BUFFER holding
+//                tightly packed glm::mat4x4 model matrices
+//  Precondition(s):
+//    <1> isReady()
+//  Returns: N/A
+//  Side Effect: Every mesh in this ModelWithShader reads its
+//               per-instance model matrices from buffer.
+//               Copies of this ModelWithShader share the
+//               meshes, so they are changed as well.
+//
+
+	void setInstanceMatrixBuffer (unsigned int buffer);
+
 //
 //  makeEmpty
 //
@@ -155,6 +155,7 @@ namespace
 		glBindAttribLocation(shader_program_id, 2, "normal");
 		glBindAttribLocation(shader_program_id, 3, "vertex1");
 		glBindAttribLocation(shader_program_id, 4, "normal1");
+		glBindAttribLocation(shader_program_id, INSTANCE_MATRIX_ATTRIBUTE, "instance_model_matrix");
 
 		bool is_good = initProgramEnd(shader_program_id);
 		if(!is_good)
@@ -196,6 +197,7 @@ namespace
 
 		r_uniforms.m_tween_enabled					= glGetUniformLocation(shader_program_id, "tween_enabled");
 		r_uniforms.m_tween_factor					= glGetUniformLocation(shader_program_id, "tween_factor");
+		r_uniforms.m_instancing_enabled				= glGetUniformLocation(shader_program_id, "instancing_enabled");
 
 		r_uniforms.m_model_matrix				    = glGetUniformLocation(shader_program_id, "model_matrix");
 		r_uniforms.m_view_matrix					= glGetUniformLocation(shader_program_id, "view_matrix");
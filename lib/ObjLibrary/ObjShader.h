@@ -111,6 +111,16 @@ const unsigned int SHADER_MAJOR_VERSION = 3;
 
 	const unsigned int SHADER_MINOR_VERSION = 3;
 
+//
+//  INSTANCE_MATRIX_ATTRIBUTE
+//
+//  The first vertex attribute of the per-instance model matrix
+//    used when a mesh is displayed instanced.  The matrix uses
+//    this attribute and the 3 after it, one per column.
+//
+
+const unsigned int INSTANCE_MATRIX_ATTRIBUTE = 5;
+
 
 
 //
@@ -424,6 +434,7 @@ struct ShaderUniforms
 {
 	unsigned int m_tween_enabled;
 	unsigned int m_tween_factor;
+	unsigned int m_instancing_enabled;
 
 	unsigned int m_model_matrix;
 	unsigned int m_view_matrix;
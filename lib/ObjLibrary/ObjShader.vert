@@ -36,11 +36,16 @@ uniform vec3 camera_pos;
 uniform bool tween_enabled;
 uniform float tween_factor;
 
+//When instancing is enabled each instance has its own model matrix,
+//applied before model_matrix
+uniform bool instancing_enabled;
+
 in vec3 vertex;
 in vec2 tex_coord;
 in vec3 normal;
 in vec3 vertex1;
 in vec3 normal1;
+in mat4 instance_model_matrix;
 
 out vec3 position;
 out vec2 tex_coord2;
@@ -56,13 +61,18 @@ void main()
 		new_normal = mix(normal,normal1,tween_factor);      
         new_vertex = mix(vertex,vertex1,tween_factor);
     }
+
+    mat4 instance_matrix = mat4(1.0);
+    if(instancing_enabled)
+        instance_matrix = instance_model_matrix;
+    mat4 world_matrix = model_matrix * instance_matrix;
 	
-	vec4 world_position = model_matrix * vec4(new_vertex, 1.0);
+	vec4 world_position = world_matrix * vec4(new_vertex, 1.0);
 
 	position   = world_position.xyz;
 	tex_coord2 = tex_coord;
-	normal2    = mat3(transpose(inverse(model_matrix))) * new_normal;
+	normal2    = mat3(transpose(inverse(world_matrix))) * new_normal;
 	to_camera  = normalize(camera_pos - world_position.xyz);
 
-	gl_Position = model_view_projection_matrix * vec4(new_vertex, 1.0);
+	gl_Position = model_view_projection_matrix * instance_matrix * vec4(new_vertex, 1.0);
 }
@@ -40,11 +40,16 @@ uniform vec4 light_position[LIGHT_COUNT];
 uniform bool tween_enabled;
 uniform float tween_factor;
 
+//When instancing is enabled each instance has its own model matrix,
+//applied before model_matrix
+uniform bool instancing_enabled;
+
 in vec3 vertex;
 in vec2 tex_coord;
 in vec3 normal;
 in vec3 vertex1;
 in vec3 normal1;
+in mat4 instance_model_matrix;
 
 out vec3 position;
 out vec2 tex_coord2;
@@ -65,11 +70,16 @@ void main()
 		new_normal = mix(normal,normal1,tween_factor);      
         new_vertex = mix(vertex,vertex1,tween_factor);
     }
+
+    mat4 instance_matrix = mat4(1.0);
+    if(instancing_enabled)
+        instance_matrix = instance_model_matrix;
+    mat4 world_matrix = model_matrix * instance_matrix;
 	
     //(OUT) Output position of the vertex in clip space
-	gl_Position = model_view_projection_matrix * vec4(new_vertex, 1.0);
+	gl_Position = model_view_projection_matrix * instance_matrix * vec4(new_vertex, 1.0);
 
-    vec4 world_position = model_matrix * vec4(new_vertex, 1.0);
+    vec4 world_position = world_matrix * vec4(new_vertex, 1.0);
 
     //(OUT) Position of vertex in world sapce
 	position  = world_position.xyz;
@@ -78,7 +88,7 @@ void main()
 	tex_coord2 = tex_coord;
 
     //(OUT) Update the normal to be the inverse transpose of the model matrix.
-    normal2    = mat3(transpose(inverse(model_matrix))) * new_normal;
+    normal2    = mat3(transpose(inverse(world_matrix))) * new_normal;
     normal_cameraspace  = (view_matrix * vec4(normal2,0)).xyz;
 
     //(OUT)
@@ -40,6 +40,38 @@
  *		+: Increase time scale
  *		-: Decrease time scale
  *
+ *		HEADLESS:
+ *		CS409-201810-A6 --headless [world file] [ticks] [seed] [input script]
+ *		Runs the simulation for a number of ticks without a window and prints tick
+ *		times and a hash of the final state. See HeadlessRunner.h for the script format.
+ *
+ *		PARTICLE BENCHMARK:
+ *		CS409-201810-A6 --bench-particles [case] [ticks] [threads] [world file]
+ *		Runs the particle emitter alone for a number of ticks and prints tick times and particle counts.
+ *		The case is idle, burst, saturation, sort or all. A thread count of 0 uses every hardware thread.
+ *		With a world file the particles bounce off its disks. See ParticleBenchmark.h for the cases.
+ *
+ *		GRAPH CHECK:
+ *		CS409-201810-A6 --check-graph [world file] [disk]
+ *		Removes a disk from the movement graph and adds it back, checking the graph matches a full build
+ *		after each step and that the other node ids do not change. Without a disk every disk is checked.
+ *		Returns 1 if anything did not match. See GraphCheck.h.
+ *
+ *		RECORD AND REPLAY:
+ *		CS409-201810-A6 --record <input log> [world file]
+ *		Plays normally and records the input of every update. The log is finished on [ESC].
+ *		CS409-201810-A6 --replay <input log>
+ *		Replays a log in the window with the seed and world it was recorded with.
+ *		Input is given back to the player when the log ends.
+ *		CS409-201810-A6 --headless-replay <input log>
+ *		Replays a log without a window and prints tick times and the state hash.
+ *		World cycling with [Tab] is disabled while recording or replaying.
+ *
+ *		THREADS:
+ *		The game is updated on its own thread at a fixed rate (see SimulationThread.h).
+ *		After each update it publishes a snapshot that the GLUT thread draws, blended
+ *		between the last two updates, so drawing and updating run at the same time.
+ *
  */
 
 #include <cstdlib>
@@ -64,6 +96,12 @@
 #include "LineRenderer.h"
 #include "TextRenderer.h"
 #include "ParticleEmitter.h"
+#include "JobSystem.h"
+#include "HeadlessRunner.h"
+#include "ParticleBenchmark.h"
+#include "GraphCheck.h"
+#include "InputLog.h"
+#include "SimulationThread.h"
 #include "Globals.h"
 #include "main.h"
 
@@ -77,8 +115,43 @@ using MathHelper::M_PI_2;
 
 int main(int argc, char* argv[])
 {
-	srand(unsigned(time(nullptr)));
-	Random::init();
+	const string mode = argc > 1 ? argv[1] : "";
+	if (mode == "--headless")
+		return runHeadless(argc, argv);
+	if (mode == "--headless-replay")
+		return runHeadlessReplay(argc, argv);
+	if (mode == "--bench-particles")
+		return runParticleBenchmark(argc, argv);
+	if (mode == "--check-graph")
+		return runGraphCheck(argc, argv);
+
+	if (mode == "--record" || mode == "--replay")
+	{
+		if (argc < 3)
+		{
+			cerr << "Error: " << mode << " needs an input log file" << endl;
+			return 1;
+		}
+
+		//The seed is saved in the log so the replay makes the same random numbers
+		unsigned seed = unsigned(time(nullptr));
+		if (mode == "--record")
+		{
+			if (argc > 3) world_file_name = argv[3];
+			if (!input_recorder.open(argv[2], seed, world_file_name)) return 1;
+		} else
+		{
+			if (!input_player.open(argv[2])) return 1;
+			seed = input_player.getSeed();
+			world_file_name = input_player.getWorldFileName();
+		}
+		srand(seed);
+		Random::seed(seed);
+	} else
+	{
+		srand(unsigned(time(nullptr)));
+		Random::init();
+	}
 
 	glutInit(&argc, argv);
 	glutInitDisplayMode(GLUT_DOUBLE | GLUT_DEPTH | GLUT_RGB | GLUT_MULTISAMPLE);
@@ -124,6 +197,127 @@ int main(int argc, char* argv[])
 
 
 
+int runHeadless(int argc, char* argv[])
+{
+	g_headless = true;
+	const string world_file_name = argc > 2 ? argv[2] : "Basic.txt";
+	const unsigned tick_count = argc > 3 ? unsigned(atoi(argv[3])) : 3600;
+	const unsigned seed = argc > 4 ? unsigned(atoi(argv[4])) : 1;
+
+	//Every random number comes from the seed so runs can be compared
+	srand(seed);
+	Random::seed(seed);
+
+	HeadlessRunner runner;
+	if (argc > 5)
+	{
+		if (!runner.loadScript(argv[5])) return 1;
+	} else
+		runner.useDefaultScript(tick_count);
+
+	g_job_system.init();
+	game.init(world_file_name);
+
+	runner.run(game, tick_count);
+	runner.printReport(cout);
+	return 0;
+}
+
+int runHeadlessReplay(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		cerr << "Error: --headless-replay needs an input log file" << endl;
+		return 1;
+	}
+
+	g_headless = true;
+	if (!input_player.open(argv[2])) return 1;
+	srand(input_player.getSeed());
+	Random::seed(input_player.getSeed());
+
+	g_job_system.init();
+	game.init(input_player.getWorldFileName());
+
+	HeadlessRunner runner;
+	runner.runReplay(game, input_player);
+	runner.printReport(cout);
+	return 0;
+}
+
+int runParticleBenchmark(int argc, char* argv[])
+{
+	g_headless = true;
+	const string case_name = argc > 2 ? argv[2] : "all";
+	const unsigned tick_count = argc > 3 ? unsigned(atoi(argv[3])) : 1000;
+	const unsigned thread_count = argc > 4 ? unsigned(atoi(argv[4])) : 0;
+
+	vector<ParticleBenchmark::Bench_Case> cases;
+	ParticleBenchmark::Bench_Case bench_case;
+	if (case_name == "all")
+		cases = { ParticleBenchmark::Bench_Case::IDLE, ParticleBenchmark::Bench_Case::BURST, ParticleBenchmark::Bench_Case::SATURATION,
+			ParticleBenchmark::Bench_Case::SORT };
+	else if (ParticleBenchmark::parseCase(case_name, bench_case))
+		cases = { bench_case };
+	else
+	{
+		cerr << "Error: \"" << case_name << "\" is not a particle benchmark case" << endl;
+		return 1;
+	}
+
+	//The world's height maps come from the seed, so every run collides with the same ground
+	srand(1);
+	Random::seed(1);
+	g_job_system.init(thread_count);
+
+	World world;
+	ParticleBenchmark benchmark;
+	if (argc > 5)
+	{
+		world.init(string("assets/Worlds/") + argv[5]);
+		benchmark.setWorld(&world);
+	}
+
+	for (unsigned i = 0; i < cases.size(); i++)
+	{
+		if (i > 0) cout << endl;
+		benchmark.run(g_particle_emitter, cases[i], tick_count);
+		benchmark.printReport(cout);
+	}
+
+	g_particle_emitter.setCollisionWorld(nullptr);
+	return 0;
+}
+
+int runGraphCheck(int argc, char* argv[])
+{
+	g_headless = true;
+	const string world_name = argc > 2 ? argv[2] : "Basic.txt";
+	const unsigned disk_id = argc > 3 ? unsigned(atoi(argv[3])) : NO_DISK_FOUND;
+
+	srand(1);
+	Random::seed(1);
+	g_job_system.init();
+
+	World world;
+	world.init(string("assets/Worlds/") + world_name);
+	if (world.disks.empty())
+	{
+		cerr << "Error: \"" << world_name << "\" has no disks to check" << endl;
+		return 1;
+	}
+	if (disk_id != NO_DISK_FOUND && disk_id >= world.disks.size())
+	{
+		cerr << "Error: the world only has " << world.disks.size() << " disks" << endl;
+		return 1;
+	}
+
+	GraphCheck check;
+	const bool passed = check.run(world, world_name, disk_id);
+	check.printReport(cout);
+	return passed ? 0 : 1;
+}
+
 void init()
 {
 	glClearColor(0.2f, 0.4f, 0.6f, 0.0f);
@@ -137,11 +331,17 @@ void init()
 	g_sphere_renderer.init();
 	g_particle_emitter.init();
 
+	//Start the worker threads before the game so it can size its per thread data
+	g_job_system.init();
+
 	//Initialize Game
-	game.init();
+	game.init(world_file_name);
 
 	//Start delta time clock
 	g_time_counter.start();
+
+	//Update the game on its own thread from now on
+	simulation_thread.start(game, input_recorder, input_player);
 }
 
 
@@ -154,56 +354,77 @@ void keyboard(unsigned char key, int x, int y)
 	if (key >= 'a' && key <= 'z')
 		key = key - 'a' + 'A';
 
-	//These should only happen on key down not hold
-	switch (key)
+	//Changing worlds and exiting stop the simulation thread, which can not be done holding the input
+	bool next_world = false;
+	bool quit = false;
 	{
-	case '+':
-		if (!g_key_pressed['+'])
-		{
-		g_time_scale_id--;
-		if (g_time_scale_id < 0) 
-			g_time_scale_id = 0;
-		g_time_scale = TIME_SCALES[g_time_scale_id];
-		g_update_count = 0;
-		g_elapsed_time_nanoseconds = 0;
-		}
-		break;
-	case '-':
-		if (!g_key_pressed['-'])
-		{
-		g_time_scale_id++;
-		if (g_time_scale_id > TIME_SCALE_COUNT) 
-			g_time_scale_id = TIME_SCALE_COUNT;
-		g_time_scale = TIME_SCALES[g_time_scale_id];
-		g_update_count = 0;
-		g_elapsed_time_nanoseconds = 0;
-		}
-		break;
-		//Tab cycle between worlds on win32
-#ifdef _WIN32
-	case '\t':
-		if (!g_key_pressed['\t'])
+		const unique_lock<mutex> input_lock = simulation_thread.lockInput();
+
+		//These should only happen on key down not hold
+		switch (key)
 		{
-			game.destroyIntoNextWorld();
+		case '+':
+			if (!g_window_key_pressed['+'])
+			{
+			g_window_time_scale_id--;
+			if (g_window_time_scale_id < 0) 
+				g_window_time_scale_id = 0;
+			g_update_count = 0;
+			g_elapsed_time_nanoseconds = 0;
+			}
+			break;
+		case '-':
+			if (!g_window_key_pressed['-'])
+			{
+			g_window_time_scale_id++;
+			if (g_window_time_scale_id > TIME_SCALE_COUNT) 
+				g_window_time_scale_id = TIME_SCALE_COUNT;
+			g_update_count = 0;
+			g_elapsed_time_nanoseconds = 0;
+			}
+			break;
+			//Tab cycle between worlds on win32
+	#ifdef _WIN32
+		case '\t':
+			//The world a log was recorded in must stay loaded
+			if (!g_window_key_pressed['\t'] && !input_recorder.isOpen() && !input_player.isOpen())
+			{
+				next_world = true;
+			}
+
+			break;
+	#endif
+		case 'L':
+			LightingManager::setEnabled(!LightingManager::isEnabled());
+			break;
+		case 27: // on [ESC]
+			quit = true;
+			break;
+		default:;
 		}
 
-		break;
-#endif
-	case 'L':
-		LightingManager::setEnabled(!LightingManager::isEnabled());
-		break;
-	case 27: // on [ESC]
-		exit(0); // normal exit
-	default:;
+		g_window_key_pressed[key] = true;
+
+		g_window_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
+		g_window_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
 	}
 
-	g_key_pressed[key] = true;
+	if (next_world)
+	{
+		simulation_thread.stop();
+		game.destroyIntoNextWorld();
+		simulation_thread.start(game, input_recorder, input_player);
+	}
 
-	g_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
-	g_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
+	if (quit)
+	{
+		simulation_thread.stop();
+		input_recorder.close();
+		exit(0); // normal exit
+	}
 
 	//Alt-Enter will change to and from fullscreen
-	if (g_key_pressed[KEY_LEFT_ALT] && g_key_pressed[13] && g_fullscreen_toggle_allowed)
+	if (g_window_key_pressed[KEY_LEFT_ALT] && g_window_key_pressed[13] && g_fullscreen_toggle_allowed)
 	{
 		g_full_screen = !g_full_screen;
 		g_fullscreen_toggle_allowed = false;
@@ -227,15 +448,17 @@ void keyboardUp(unsigned char key, int x, int y)
 	if (key >= 'a' && key <= 'z')
 		key = key - 'a' + 'A';
 
+	const unique_lock<mutex> input_lock = simulation_thread.lockInput();
+
 	//Unpress the key
-	g_key_pressed[key] = false;
+	g_window_key_pressed[key] = false;
 
 
 	//Fix sticky key with shift
 	if (key == '?' || key == '/')
 	{
-		g_key_pressed['?'] = false;
-		g_key_pressed['/'] = false;
+		g_window_key_pressed['?'] = false;
+		g_window_key_pressed['/'] = false;
 	}
 
 	switch (key)
@@ -247,33 +470,34 @@ void keyboardUp(unsigned char key, int x, int y)
 	}
 
 	//Set special keys
-	g_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
-	g_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
+	g_window_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
+	g_window_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
 
 }
 
 //Read keyboard input on key down
 void special(const int special_key, int x, int y)
 {
+	const unique_lock<mutex> input_lock = simulation_thread.lockInput();
 	switch (special_key)
 	{
 	case GLUT_KEY_SHIFT_L:
-		g_key_pressed[KEY_SHIFT] = true;
+		g_window_key_pressed[KEY_SHIFT] = true;
 		break;
 	case GLUT_KEY_UP:
-		g_key_pressed[KEY_UP_ARROW] = true;
+		g_window_key_pressed[KEY_UP_ARROW] = true;
 		break;
 	case GLUT_KEY_DOWN:
-		g_key_pressed[KEY_DOWN_ARROW] = true;
+		g_window_key_pressed[KEY_DOWN_ARROW] = true;
 		break;
 	case GLUT_KEY_LEFT:
-		g_key_pressed[KEY_LEFT_ARROW] = true;
+		g_window_key_pressed[KEY_LEFT_ARROW] = true;
 		break;
 	case GLUT_KEY_RIGHT:
-		g_key_pressed[KEY_RIGHT_ARROW] = true;
+		g_window_key_pressed[KEY_RIGHT_ARROW] = true;
 		break;
 	case GLUT_KEY_ALT_L:
-		g_key_pressed[KEY_LEFT_ALT] = false;
+		g_window_key_pressed[KEY_LEFT_ALT] = false;
 		break;
 	default:;
 	}
@@ -283,40 +507,43 @@ void special(const int special_key, int x, int y)
 //Read keyboard input on key up
 void specialUp(const int special_key, int x, int y)
 {
+	const unique_lock<mutex> input_lock = simulation_thread.lockInput();
 	switch (special_key)
 	{
 	case GLUT_KEY_UP:
-		g_key_pressed[KEY_UP_ARROW] = false;
+		g_window_key_pressed[KEY_UP_ARROW] = false;
 		break;
 	case GLUT_KEY_DOWN:
-		g_key_pressed[KEY_DOWN_ARROW] = false;
+		g_window_key_pressed[KEY_DOWN_ARROW] = false;
 		break;
 	case GLUT_KEY_LEFT:
-		g_key_pressed[KEY_LEFT_ARROW] = false;
+		g_window_key_pressed[KEY_LEFT_ARROW] = false;
 		break;
 	case GLUT_KEY_RIGHT:
-		g_key_pressed[KEY_RIGHT_ARROW] = false;
+		g_window_key_pressed[KEY_RIGHT_ARROW] = false;
 		break;
 	case GLUT_KEY_END:
-		g_key_pressed[KEY_END] = false;
+		g_window_key_pressed[KEY_END] = false;
 		break;
 	case GLUT_KEY_ALT_L:
-		g_key_pressed[KEY_LEFT_ALT] = false;
+		g_window_key_pressed[KEY_LEFT_ALT] = false;
 		break;
 	default:;
 	}
 
 	//Set special keys
-	g_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
-	g_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
+	g_window_key_pressed[KEY_SHIFT] = (glutGetModifiers() == GLUT_ACTIVE_SHIFT);
+	g_window_key_pressed[KEY_LEFT_ALT] = (glutGetModifiers() == GLUT_ACTIVE_ALT);
 }
 
 //Read mouse move input when a button is held
 void mouseMove(const int x, const int y)
 {
+	const unique_lock<mutex> input_lock = simulation_thread.lockInput();
+
 	//Add up mouse movements until they are processed.
-	g_mouse_dx += x - g_mouse_x;
-	g_mouse_dy += y - g_mouse_y;
+	g_window_mouse_dx += x - g_mouse_x;
+	g_window_mouse_dy += y - g_mouse_y;
 	g_mouse_x = x;
 	g_mouse_y = y;
 
@@ -333,6 +560,7 @@ void mouseMove(const int x, const int y)
 //Read mouse click input
 void mouseButton(const int button, const int state, const int x, const int y)
 {
+	const unique_lock<mutex> input_lock = simulation_thread.lockInput();
 
 	//Hides mouse when held
 	switch (button)
@@ -340,22 +568,22 @@ void mouseButton(const int button, const int state, const int x, const int y)
 	case GLUT_RIGHT_BUTTON:
 		if (state == GLUT_DOWN)
 		{
-			g_key_pressed[MOUSE_RIGHT] = true;
+			g_window_key_pressed[MOUSE_RIGHT] = true;
 			glutSetCursor(GLUT_CURSOR_NONE);
 		} else
 		{
-			g_key_pressed[MOUSE_RIGHT] = false;
+			g_window_key_pressed[MOUSE_RIGHT] = false;
 			glutSetCursor(GLUT_CURSOR_INHERIT);
 		}
 		break;
 	case GLUT_LEFT_BUTTON:
 		if (state == GLUT_DOWN)
 		{
-			g_key_pressed[MOUSE_LEFT] = true;
+			g_window_key_pressed[MOUSE_LEFT] = true;
 			glutSetCursor(GLUT_CURSOR_NONE);
 		} else
 		{
-			g_key_pressed[MOUSE_LEFT] = false;
+			g_window_key_pressed[MOUSE_LEFT] = false;
 			glutSetCursor(GLUT_CURSOR_INHERIT);
 		}
 		break;
@@ -376,27 +604,8 @@ void update()
 	//Get time since last frame
 	g_delta_time = g_time_counter.getAndReset();
 
-	//Multiply delta time by time_scale to slow or speed up game
-	const double scaled_time = g_delta_time * g_time_scale;
-
-	//Increment elapsed time and update lag
-	g_elapsed_time_nanoseconds += long long(g_delta_time * 1000 + 0.5);
-	g_update_lag += scaled_time;
-
-	//If should update
-	if (g_update_lag > FRAME_TIME_UPDATE)
-	{
-		//Process all updates
-		while (g_update_lag > FRAME_TIME_UPDATE)
-		{
-			game.update(FRAME_TIME_UPDATE);
-			g_update_lag -= FRAME_TIME_UPDATE;
-			g_update_count++;
-		}
-	}
-
-	//Update the animations every frame
-	game.updateAnimations(scaled_time);
+	//Increment elapsed time, the game itself is updated on the simulation thread
+	g_elapsed_time_nanoseconds += (long long)(g_delta_time * 1000 + 0.5);
 	g_display_count++;
 
 	//If Should sleep
@@ -441,6 +650,11 @@ void reshape(const int w, const int h)
 
 void display()
 {
-	game.display();
+	const RenderSnapshot& snapshot = simulation_thread.getSnapshot();
+
+	//How far the display is from the snapshot's update towards the next one
+	const double lag = snapshot.update_lag + snapshot.since_taken.getCounter() * snapshot.time_scale;
+	g_render_fraction = float(min(lag / FRAME_TIME_UPDATE, 1.0));
+	game.display(snapshot);
 	glutSwapBuffers();
 }
@@ -2,6 +2,22 @@
 
 //Main functions
 
+//Runs the simulation without a window or OpenGL context and prints tick times and a state hash
+//Arguments after --headless: [world file] [ticks] [seed] [input script]
+int runHeadless(int argc, char* argv[]);
+
+//Replays an input log without a window or OpenGL context and prints tick times and a state hash
+//Arguments after --headless-replay: <input log>
+int runHeadlessReplay(int argc, char* argv[]);
+
+//Times the particle emitter without a window or OpenGL context and prints tick times and particle counts
+//Arguments after --bench-particles: [case] [ticks] [threads] [world file]
+int runParticleBenchmark(int argc, char* argv[]);
+
+//Checks removing and adding disks against a full build of the movement graph and prints the differences
+//Arguments after --check-graph: [world file] [disk]. Returns 1 if the check failed
+int runGraphCheck(int argc, char* argv[]);
+
 //Initialize the data for the game.
 //Loads assets and builds world, movement graph and pickup manager
 void init();
@@ -26,6 +42,16 @@ void mouseButton(int button, int state, int x, int y);
 //The overarching game class
 Game game;
 
+//The world file the game starts in
+std::string world_file_name = "Basic.txt";
+
+//Records or replays the input of every update when started with --record or --replay
+InputRecorder input_recorder;
+InputPlayer input_player;
+
+//Updates the game, declared last so it is stopped before anything it uses is destroyed
+SimulationThread simulation_thread;
+
 
 
 